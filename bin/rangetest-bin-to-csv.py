@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+# Convert a binary range test log (/static/rangetest.bin, written when the firmware is built with
+# USERPREFS_RANGE_TEST_BINARY_LOG) into the same CSV the range test module writes by default.
+#
+# The binary log has no sender names, the node id (!xxxxxxxx) is used instead.
+
+import argparse
+import csv
+import math
+import struct
+import sys
+import time
+
+MAGIC = b"RTB1"
+
+# Must match RangeTestLogRecord in src/modules/RangeTestModule.h
+RECORD = struct.Struct("<IIiiiiifBB")
+
+HEADER = [
+    "time",
+    "from",
+    "sender name",
+    "sender lat",
+    "sender long",
+    "rx lat",
+    "rx long",
+    "rx elevation",
+    "rx snr",
+    "distance",
+    "hop limit",
+    "payload",
+]
+
+
+def distance_m(lat1, lon1, lat2, lon2):
+    """Great circle distance in meters"""
+    r = 6371e3
+    p1, p2 = math.radians(lat1), math.radians(lat2)
+    dp, dl = math.radians(lat2 - lat1), math.radians(lon2 - lon1)
+    a = math.sin(dp / 2) ** 2 + math.cos(p1) * math.cos(p2) * math.sin(dl / 2) ** 2
+    return 2 * r * math.asin(math.sqrt(a))
+
+
+def records(data):
+    if not data.startswith(MAGIC):
+        raise ValueError("not a binary range test log")
+    pos = len(MAGIC)
+    while pos + RECORD.size <= len(data):
+        fields = RECORD.unpack_from(data, pos)
+        pos += RECORD.size
+        payload_len = fields[-1]
+        payload = data[pos : pos + payload_len]
+        pos += payload_len
+        if len(payload) < payload_len:
+            print("Warning: log ends in a truncated record", file=sys.stderr)
+            return
+        yield fields[:-1], payload
+
+
+def convert(data, out):
+    writer = csv.writer(out, lineterminator="\n")
+    writer.writerow(HEADER)
+    for (t, frm, slat, slon, rlat, rlon, ralt, snr, hops), payload in records(data):
+        timestr = time.strftime("%H:%M:%S", time.gmtime(t)) if t else "??:??:??"
+        if slat and slon and rlat and rlon:
+            distance = f"{distance_m(slat * 1e-7, slon * 1e-7, rlat * 1e-7, rlon * 1e-7):f}"
+        else:
+            distance = "0"
+        writer.writerow(
+            [
+                timestr,
+                struct.unpack("<i", struct.pack("<I", frm))[0],  # The CSV log prints node numbers signed
+                f"!{frm:08x}",
+                f"{slat * 1e-7:f}",
+                f"{slon * 1e-7:f}",
+                f"{rlat * 1e-7:f}",
+                f"{rlon * 1e-7:f}",
+                ralt,
+                f"{snr:f}",
+                distance,
+                hops,
+                payload.decode("utf-8", errors="replace"),
+            ]
+        )
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a binary range test log to CSV")
+    parser.add_argument("input", help="rangetest.bin downloaded from the node")
+    parser.add_argument("output", nargs="?", help="CSV file to write (default: stdout)")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    if args.output:
+        with open(args.output, "w", newline="") as out:
+            convert(data, out)
+    else:
+        convert(data, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -14,4 +14,6 @@ const uint8_t FROMNUM_UUID_16[16u] = {0x53, 0x44, 0xe3, 0x47, 0x75, 0xaa, 0x70,
 const uint8_t LEGACY_LOGRADIO_UUID_16[16u] = {0xe2, 0xf2, 0x1e, 0xbe, 0xc5, 0x15, 0xcf, 0xaa,
                                               0x6b, 0x43, 0xfa, 0x78, 0x38, 0xd2, 0x6f, 0x6c};
 const uint8_t LOGRADIO_UUID_16[16u] = {0x47, 0x95, 0xDF, 0x8C, 0xDE, 0xE9, 0x44, 0x99,
-                                       0x23, 0x44, 0xE6, 0x06, 0x49, 0x6E, 0x3D, 0x5A};
\ No newline at end of file
+                                       0x23, 0x44, 0xE6, 0x06, 0x49, 0x6E, 0x3D, 0x5A};
+const uint8_t FROMRADIO_BATCH_UUID_16[16u] = {0x90, 0x4c, 0x7f, 0x2a, 0x1b, 0x5e, 0x3c, 0x9d,
+                                              0x8a, 0x4b, 0x0e, 0x6f, 0xa4, 0xc1, 0xf7, 0xd2};
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "BootTimeline.h"
+#include "concurrency/OSThread.h"
+#include <vector>
+
+BootTimeline bootTimeline;
+
+/// Runs the deferred init functions from the main loop, with a short gap after each
+class DeferredInitThread : public concurrency::OSThread
+{
+  public:
+    struct Step {
+        const char *name;
+        void (*fn)();
+    };
+    std::vector<Step> steps;
+
+    DeferredInitThread() : OSThread("DeferredInit") {}
+
+  protected:
+    virtual int32_t runOnce() override
+    {
+        if (steps.empty())
+            return disable();
+
+        Step step = steps.front();
+        steps.erase(steps.begin());
+        LOG_DEBUG("Deferred init: %s", step.name);
+        step.fn();
+        bootTimeline.mark(step.name);
+
+        if (!steps.empty())
+            return BOOT_DEFER_GAP_MS;
+        bootTimeline.log();
+        return disable();
+    }
+};
+
+void BootTimeline::mark(const char *name)
+{
+    uint32_t now = millis();
+    LOG_DEBUG("Boot phase %s took %u ms", name, now - lastMarkMs);
+    lastMarkMs = now;
+    if (numPhases < BOOT_TIMELINE_MAX_PHASES)
+        phases[numPhases++] = {name, now};
+}
+
+void BootTimeline::setupDone()
+{
+    mark("Setup done");
+    setupDoneMs = lastMarkMs ? lastMarkMs : 1;
+    if (!deferred)
+        log();
+}
+
+void BootTimeline::markFirstPacket()
+{
+    if (firstPacketMs)
+        return;
+    uint32_t now = millis();
+    firstPacketMs = now ? now : 1;
+    LOG_INFO("First packet received %u ms after boot", firstPacketMs);
+}
+
+void BootTimeline::defer(const char *name, void (*fn)())
+{
+#if BOOT_DEFER_NONCRITICAL_INIT
+    if (!setupDoneMs) {
+        if (!deferred)
+            deferred = new DeferredInitThread();
+        deferred->steps.push_back({name, fn});
+        return;
+    }
+#endif
+    fn();
+    mark(name);
+}
+
+void BootTimeline::log()
+{
+    LOG_INFO("Boot timeline (ms since start):");
+    uint32_t prevMs = 0;
+    for (size_t i = 0; i < numPhases; i++) {
+        LOG_INFO("  %6u %-16s +%u", phases[i].endMs, phases[i].name, phases[i].endMs - prevMs);
+        prevMs = phases[i].endMs;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "configuration.h"
+
+/// Most boot phases we keep the timestamps of, later ones are only logged
+#define BOOT_TIMELINE_MAX_PHASES 24
+
+/// Start the web server, MQTT and the like from a thread once setup() is done, instead of before the radio is receiving
+#ifndef BOOT_DEFER_NONCRITICAL_INIT
+#define BOOT_DEFER_NONCRITICAL_INIT 1
+#endif
+
+/// Time the main loop gets between two deferred init steps
+#define BOOT_DEFER_GAP_MS 20
+
+struct BootPhase {
+    const char *name; // A string literal
+    uint32_t endMs;   // millis() at the end of the phase
+};
+
+class DeferredInitThread;
+
+/**
+ * Where the time goes while we boot: setup() marks the end of each of its phases, and we note when the first packet came in
+ * over the radio (which is what a user waits for after switching a node on).
+ *
+ * Init that isn't needed to get the radio going can be deferred, it then runs from a thread once the main loop is running.
+ */
+class BootTimeline
+{
+  public:
+    /// A phase of the boot just ended
+    void mark(const char *name);
+
+    /// setup() is about to return
+    void setupDone();
+
+    /// A packet came in over the radio, only the first one counts
+    void markFirstPacket();
+
+    /**
+     * Call fn once setup() is done, one deferred function at a time so the radio gets its turn in between.  Without
+     * BOOT_DEFER_NONCRITICAL_INIT it is called right away.
+     */
+    void defer(const char *name, void (*fn)());
+
+    /// Log every phase with its duration
+    void log();
+
+    size_t getNumPhases() const { return numPhases; }
+    const BootPhase &getPhase(size_t i) const { return phases[i]; }
+
+    /// millis() when setup() was done, 0 while still in setup()
+    uint32_t getSetupDoneMs() const { return setupDoneMs; }
+
+    /// millis() when the first packet came in, 0 if none did yet
+    uint32_t getFirstPacketMs() const { return firstPacketMs; }
+
+  private:
+    BootPhase phases[BOOT_TIMELINE_MAX_PHASES] = {};
+    size_t numPhases = 0;
+    uint32_t lastMarkMs = 0;
+    uint32_t setupDoneMs = 0;
+    uint32_t firstPacketMs = 0;
+    DeferredInitThread *deferred = NULL;
+};
+
+extern BootTimeline bootTimeline;
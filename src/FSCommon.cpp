@@ -9,6 +9,7 @@
  *
  */
 #include "FSCommon.h"
+#include "concurrency/LockGuard.h"
 #include "configuration.h"
 
 #ifdef HAS_SDCARD
@@ -201,6 +202,89 @@ std::vector<meshtastic_FileInfo> getFiles(const char *dirname, uint8_t levels)
     return filenames;
 }
 
+/// Cached result of getFiles("/", 10), only valid if filesManifestValid
+static std::vector<meshtastic_FileInfo> filesManifest;
+static bool filesManifestValid;
+static concurrency::Lock *filesManifestLock;
+
+/**
+ * @brief Get the list of all files on the filesystem, as sent to clients when they connect.
+ *
+ * Walking the whole filesystem is slow on flash, so the list is kept around until something changes it (see
+ * updateFilesManifest() and invalidateFilesManifest()).
+ *
+ * @return A copy of the manifest, so it stays usable while the filesystem changes underneath.
+ */
+std::vector<meshtastic_FileInfo> getFilesManifest()
+{
+    concurrency::LockGuard guard(filesManifestLock);
+    if (!filesManifestValid) {
+        filesManifest = getFiles("/", 10);
+        filesManifestValid = true;
+        LOG_DEBUG("Built file manifest, %u files", (unsigned)filesManifest.size());
+    }
+    return filesManifest;
+}
+
+/**
+ * getFiles() lists full paths on ESP32, but only what file.name() gives us elsewhere, which on nRF52 is just the file name.
+ * So a listed name without the leading slash matches the end of path, starting at a directory separator.
+ */
+static bool isListedAs(const char *path, const char *listed)
+{
+    if (listed[0] == '/')
+        return strcmp(path, listed) == 0;
+
+    size_t pathLen = strlen(path), listedLen = strlen(listed);
+    if (listedLen > pathLen || strcmp(path + pathLen - listedLen, listed) != 0)
+        return false;
+    return listedLen == pathLen || path[pathLen - listedLen - 1] == '/';
+}
+
+/**
+ * @brief Bring the cached manifest up to date after a file was written or removed.
+ *
+ * A file we already know about just gets its new size (or is dropped if it is gone), a new file means the manifest is
+ * rebuilt the next time somebody asks for it.
+ *
+ * @param path The full path of the file.
+ */
+void updateFilesManifest(const char *path)
+{
+#ifdef FSCom
+    concurrency::LockGuard guard(filesManifestLock);
+    if (!filesManifestValid)
+        return;
+
+    for (auto it = filesManifest.begin(); it != filesManifest.end(); ++it) {
+        if (!isListedAs(path, it->file_name))
+            continue;
+
+        File file = FSCom.open(path, FILE_O_READ);
+        if (file) {
+            it->size_bytes = file.size();
+            file.close();
+        } else {
+            filesManifest.erase(it);
+        }
+        return;
+    }
+
+    // A new file, the manifest has to be rebuilt to get it in the right place
+    if (FSCom.exists(path))
+        filesManifestValid = false;
+#endif
+}
+
+/**
+ * @brief Forget the cached manifest, e.g. after a whole directory was removed.
+ */
+void invalidateFilesManifest()
+{
+    concurrency::LockGuard guard(filesManifestLock);
+    filesManifestValid = false;
+}
+
 /**
  * Lists the contents of a directory.
  *
@@ -316,6 +400,7 @@ void listDir(const char *dirname, uint8_t levels, bool del)
 void rmDir(const char *dirname)
 {
 #ifdef FSCom
+    invalidateFilesManifest();
 #if (defined(ARCH_ESP32) || defined(ARCH_RP2040) || defined(ARCH_PORTDUINO))
     listDir(dirname, 10, true);
 #elif defined(ARCH_NRF52)
@@ -327,6 +412,7 @@ void rmDir(const char *dirname)
 
 void fsInit()
 {
+    filesManifestLock = new concurrency::Lock();
 #ifdef FSCom
     if (!FSBegin()) {
         LOG_ERROR("Filesystem mount failed");
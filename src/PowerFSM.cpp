@@ -105,6 +105,7 @@ static void lsIdle()
             ledBlink.set(false); // Never leave led on while in light sleep
             esp_sleep_source_t wakeCause2 = doLightSleep(sleepTime * 1000LL);
             powerMon->clearState(meshtastic_PowerMon_State_CPU_LightSleep);
+            powerMon->countWakeup("LightSleep", wakeCause2 != ESP_SLEEP_WAKEUP_TIMER);
 
             switch (wakeCause2) {
             case ESP_SLEEP_WAKEUP_TIMER:
@@ -1,5 +1,41 @@
 #include "PowerMon.h"
+#include "MeshService.h"
 #include "NodeDB.h"
+#include "RTC.h"
+#include "concurrency/OSThread.h"
+#include <algorithm>
+
+static const char *subsystemNames[POWERMON_NUM_SUBSYSTEMS] = {
+    "CPU", "LightSleep", "Vext1", "LoraRX", "LoraTX", "LoraRXActive", "BT", "LED", "Screen", "ScreenDrawing", "WiFi", "GPS"};
+
+static const uint32_t subsystemCurrentUa[POWERMON_NUM_SUBSYSTEMS] = {POWERMON_CURRENT_CPU_UA,
+                                                                    POWERMON_CURRENT_LIGHTSLEEP_UA,
+                                                                    POWERMON_CURRENT_VEXT_UA,
+                                                                    POWERMON_CURRENT_LORA_RX_UA,
+                                                                    POWERMON_CURRENT_LORA_TX_UA,
+                                                                    POWERMON_CURRENT_LORA_RX_ACTIVE_UA,
+                                                                    POWERMON_CURRENT_BT_UA,
+                                                                    POWERMON_CURRENT_LED_UA,
+                                                                    POWERMON_CURRENT_SCREEN_UA,
+                                                                    POWERMON_CURRENT_SCREEN_DRAWING_UA,
+                                                                    POWERMON_CURRENT_WIFI_UA,
+                                                                    POWERMON_CURRENT_GPS_UA};
+
+// Subsystem 0 is the CPU, which is on unless we are sleeping. The others are simply state bit i
+static bool isSubsystemOn(uint64_t states, size_t i)
+{
+    if (i == 0)
+        return !(states & (meshtastic_PowerMon_State_CPU_DeepSleep | meshtastic_PowerMon_State_CPU_LightSleep));
+    return (states & (1ULL << i)) != 0;
+}
+
+// uA * ms to mAh
+static float toMah(uint64_t uAms)
+{
+    return uAms / 3600000000.0f;
+}
+
+PowerMon::PowerMon() : lastChangeMs(millis()) {}
 
 // Use the 'live' config flag to figure out if we should be showing this message
 bool PowerMon::is_power_enabled(uint64_t m)
@@ -13,6 +49,8 @@ void PowerMon::setState(_meshtastic_PowerMon_State state, const char *reason)
 {
 #ifdef USE_POWERMON
     auto oldstates = states;
+    if ((states | state) != oldstates)
+        accumulate();
     states |= state;
     if (oldstates != states && is_power_enabled(state)) {
         emitLog(reason);
@@ -24,6 +62,8 @@ void PowerMon::clearState(_meshtastic_PowerMon_State state, const char *reason)
 {
 #ifdef USE_POWERMON
     auto oldstates = states;
+    if ((states & ~state) != oldstates)
+        accumulate();
     states &= ~state;
     if (oldstates != states && is_power_enabled(state)) {
         emitLog(reason);
@@ -31,6 +71,179 @@ void PowerMon::clearState(_meshtastic_PowerMon_State state, const char *reason)
 #endif
 }
 
+void PowerMon::accumulate()
+{
+    uint32_t now = millis();
+    uint32_t elapsed = now - lastChangeMs;
+    lastChangeMs = now;
+    if (!elapsed)
+        return;
+
+    totalMs += elapsed;
+    for (size_t i = 0; i < POWERMON_NUM_SUBSYSTEMS; i++) {
+        if (isSubsystemOn(states, i))
+            subsystemMs[i] += elapsed;
+    }
+
+    PowerMonCombo *freeCombo = NULL;
+    for (size_t i = 0; i < POWERMON_MAX_COMBOS; i++) {
+        if (combos[i].ms && combos[i].states == (uint32_t)states) {
+            combos[i].ms += elapsed;
+            return;
+        }
+        if (!combos[i].ms && !freeCombo)
+            freeCombo = &combos[i];
+    }
+    if (freeCombo)
+        *freeCombo = {(uint32_t)states, elapsed};
+    else
+        otherCombosMs += elapsed;
+}
+
+void PowerMon::countWakeup(const char *cause, bool interrupted)
+{
+    for (size_t i = 0; i < POWERMON_MAX_WAKE_CAUSES; i++) {
+        if (!wakeCauses[i].cause)
+            wakeCauses[i].cause = cause;
+        else if (strcmp(wakeCauses[i].cause, cause) != 0)
+            continue;
+
+        if (interrupted)
+            wakeCauses[i].interrupt++;
+        else
+            wakeCauses[i].timer++;
+        return;
+    }
+}
+
+uint64_t PowerMon::getSubsystemMs(size_t i) const
+{
+    uint64_t ms = subsystemMs[i];
+    if (isSubsystemOn(states, i))
+        ms += (uint32_t)(millis() - lastChangeMs);
+    return ms;
+}
+
+size_t PowerMon::getSubsystems(PowerMonSubsystem *out, size_t maxOut) const
+{
+    size_t numOut = std::min((size_t)POWERMON_NUM_SUBSYSTEMS, maxOut);
+    for (size_t i = 0; i < numOut; i++) {
+        uint64_t onMs = getSubsystemMs(i);
+        out[i] = {subsystemNames[i], onMs, toMah(onMs * subsystemCurrentUa[i])};
+    }
+    return numOut;
+}
+
+float PowerMon::getTotalMah() const
+{
+    float mAh = 0;
+    for (size_t i = 0; i < POWERMON_NUM_SUBSYSTEMS; i++)
+        mAh += toMah(getSubsystemMs(i) * subsystemCurrentUa[i]);
+    return mAh;
+}
+
+float PowerMon::getAverageMa() const
+{
+    uint64_t ms = getTotalMs();
+    return ms ? getTotalMah() * 3600000.0f / ms : 0;
+}
+
+size_t PowerMon::getCombos(PowerMonCombo *out, size_t maxOut) const
+{
+    PowerMonCombo all[POWERMON_MAX_COMBOS];
+    size_t numUsed = 0;
+    for (size_t i = 0; i < POWERMON_MAX_COMBOS; i++) {
+        if (!combos[i].ms)
+            continue;
+        all[numUsed] = combos[i];
+        if (combos[i].states == (uint32_t)states)
+            all[numUsed].ms += (uint32_t)(millis() - lastChangeMs);
+        numUsed++;
+    }
+    std::sort(all, all + numUsed, [](const PowerMonCombo &a, const PowerMonCombo &b) { return a.ms > b.ms; });
+
+    size_t numOut = std::min(numUsed, maxOut);
+    memcpy(out, all, numOut * sizeof(PowerMonCombo));
+    return numOut;
+}
+
+size_t PowerMon::getWakeups(PowerMonWakeups *out, size_t maxOut) const
+{
+    PowerMonWakeups all[MAX_THREADS + POWERMON_MAX_WAKE_CAUSES];
+    size_t numUsed = 0;
+    for (int i = 0; i < MAX_THREADS; i++) {
+        auto thread = static_cast<concurrency::OSThread *>(concurrency::mainController.get(i));
+        if (thread && (thread->timerWakeups || thread->interruptWakeups))
+            all[numUsed++] = {thread->ThreadName.c_str(), thread->timerWakeups, thread->interruptWakeups};
+    }
+    for (size_t i = 0; i < POWERMON_MAX_WAKE_CAUSES; i++) {
+        if (wakeCauses[i].cause)
+            all[numUsed++] = wakeCauses[i];
+    }
+    std::sort(all, all + numUsed, [](const PowerMonWakeups &a, const PowerMonWakeups &b) {
+        return a.timer + a.interrupt > b.timer + b.interrupt;
+    });
+
+    size_t numOut = std::min(numUsed, maxOut);
+    memcpy(out, all, numOut * sizeof(PowerMonWakeups));
+    return numOut;
+}
+
+size_t PowerMon::formatSummary(char *buf, size_t len) const
+{
+    PowerMonSubsystem subsystems[POWERMON_NUM_SUBSYSTEMS];
+    PowerMonWakeups wakeups[5];
+
+    // Everything in tenths, the nrf52 printf can't do floats
+    uint32_t hours10 = getTotalMs() / 360000;
+    uint32_t mAh10 = getTotalMah() * 10;
+    uint32_t mA10 = getAverageMa() * 10;
+    size_t used = snprintf(buf, len, "Energy over %u.%uh: %u.%umAh, avg %u.%umA. By subsystem (mAh):", hours10 / 10, hours10 % 10,
+                           mAh10 / 10, mAh10 % 10, mA10 / 10, mA10 % 10);
+    size_t numSubsystems = getSubsystems(subsystems, POWERMON_NUM_SUBSYSTEMS);
+    for (size_t i = 0; i < numSubsystems && used < len; i++) {
+        if (!subsystems[i].onMs)
+            continue;
+        uint32_t subsystemMah10 = subsystems[i].mAh * 10;
+        used += snprintf(buf + used, len - used, " %s %u.%u", subsystems[i].name, subsystemMah10 / 10, subsystemMah10 % 10);
+    }
+    if (used < len)
+        used += snprintf(buf + used, len - used, ". Wakeups (timer/irq):");
+    size_t numWakeups = getWakeups(wakeups, 5);
+    for (size_t i = 0; i < numWakeups && used < len; i++)
+        used += snprintf(buf + used, len - used, " %s %u/%u", wakeups[i].cause, wakeups[i].timer, wakeups[i].interrupt);
+    return std::min(used, len - 1);
+}
+
+void PowerMon::logSummary()
+{
+    accumulate();
+
+    char summary[400];
+    formatSummary(summary, sizeof(summary));
+    LOG_INFO("%s", summary);
+
+    PowerMonCombo top[5];
+    size_t numCombos = getCombos(top, 5);
+    for (size_t i = 0; i < numCombos; i++)
+        LOG_INFO("States 0x%04x for %us", top[i].states, (uint32_t)(top[i].ms / 1000));
+    if (otherCombosMs)
+        LOG_INFO("Other states for %us", (uint32_t)(otherCombosMs / 1000));
+}
+
+void PowerMon::sendSummaryToPhone(uint32_t replyId)
+{
+    meshtastic_ClientNotification *cn = clientNotificationPool.allocZeroed();
+    cn->has_reply_id = true;
+    cn->reply_id = replyId;
+    cn->level = meshtastic_LogRecord_Level_INFO;
+    cn->time = getValidTime(RTCQualityFromNet);
+    formatSummary(cn->message, sizeof(cn->message));
+
+    LOG_INFO("%s", cn->message);
+    service->sendClientNotification(cn);
+}
+
 void PowerMon::emitLog(const char *reason)
 {
 #ifdef USE_POWERMON
@@ -44,4 +257,4 @@ PowerMon *powerMon;
 void powerMonInit()
 {
     powerMon = new PowerMon();
-}
\ No newline at end of file
+}
@@ -7,10 +7,78 @@
 #define USE_POWERMON // FIXME turn this only for certain builds
 #endif
 
+// Energy attribution: the CPU (whenever it is neither light nor deep sleeping) followed by one entry per state bit from
+// CPU_LightSleep to GPS_Active
+#define POWERMON_NUM_SUBSYSTEMS 12
+#define POWERMON_MAX_COMBOS 16     // Combinations of states we keep time for, anything beyond that is lumped together
+#define POWERMON_MAX_WAKE_CAUSES 4 // Wakeups that are not charged to an OSThread (e.g. light sleep)
+
+// Extra current drawn while each subsystem is on, in uA. These are rough figures for a typical board, a variant that knows
+// better (or a user with a meter) can override them with build flags to get useful mAh estimates
+#ifndef POWERMON_CURRENT_CPU_UA
+#define POWERMON_CURRENT_CPU_UA 30000
+#endif
+#ifndef POWERMON_CURRENT_LIGHTSLEEP_UA
+#define POWERMON_CURRENT_LIGHTSLEEP_UA 1500
+#endif
+#ifndef POWERMON_CURRENT_VEXT_UA
+#define POWERMON_CURRENT_VEXT_UA 2000
+#endif
+#ifndef POWERMON_CURRENT_LORA_RX_UA
+#define POWERMON_CURRENT_LORA_RX_UA 5500
+#endif
+#ifndef POWERMON_CURRENT_LORA_TX_UA
+#define POWERMON_CURRENT_LORA_TX_UA 110000
+#endif
+#ifndef POWERMON_CURRENT_LORA_RX_ACTIVE_UA
+#define POWERMON_CURRENT_LORA_RX_ACTIVE_UA 500
+#endif
+#ifndef POWERMON_CURRENT_BT_UA
+#define POWERMON_CURRENT_BT_UA 10000
+#endif
+#ifndef POWERMON_CURRENT_LED_UA
+#define POWERMON_CURRENT_LED_UA 3000
+#endif
+#ifndef POWERMON_CURRENT_SCREEN_UA
+#define POWERMON_CURRENT_SCREEN_UA 8000
+#endif
+#ifndef POWERMON_CURRENT_SCREEN_DRAWING_UA
+#define POWERMON_CURRENT_SCREEN_DRAWING_UA 10000
+#endif
+#ifndef POWERMON_CURRENT_WIFI_UA
+#define POWERMON_CURRENT_WIFI_UA 80000
+#endif
+#ifndef POWERMON_CURRENT_GPS_UA
+#define POWERMON_CURRENT_GPS_UA 25000
+#endif
+
+/// Time spent in one subsystem since boot and what we think it cost
+struct PowerMonSubsystem {
+    const char *name;
+    uint64_t onMs;
+    float mAh;
+};
+
+/// Time spent with exactly this set of states active
+struct PowerMonCombo {
+    uint32_t states;
+    uint64_t ms; // 0 means this entry is free
+};
+
+/// Who woke the main loop, split by whether a timer expired or something interrupted the sleep
+struct PowerMonWakeups {
+    const char *cause;
+    uint32_t timer;
+    uint32_t interrupt;
+};
+
 /**
  * The singleton class for monitoring power consumption of device
  * subsystems/modes.
  *
+ * Besides logging state changes for an external meter, it keeps time in each state (and each combination of states) so we can
+ * estimate where the battery went without any extra hardware.
+ *
  * For more information see the PowerMon docs.
  */
 class PowerMon
@@ -24,19 +92,65 @@ class PowerMon
      */
     bool force_enabled = false;
 
+    /// millis() when states last changed, everything before that is already in the counters below
+    uint32_t lastChangeMs;
+    uint64_t subsystemMs[POWERMON_NUM_SUBSYSTEMS] = {};
+    uint64_t totalMs = 0;
+    PowerMonCombo combos[POWERMON_MAX_COMBOS] = {};
+    uint64_t otherCombosMs = 0;
+    PowerMonWakeups wakeCauses[POWERMON_MAX_WAKE_CAUSES] = {};
+
   public:
-    PowerMon() {}
+    PowerMon();
 
     // Mark entry/exit of a power consuming state
     void setState(_meshtastic_PowerMon_State state, const char *reason = "");
     void clearState(_meshtastic_PowerMon_State state, const char *reason = "");
 
+    /// Count a wakeup that did not come from the main loop (OSThread wakeups are counted by the threads themselves)
+    void countWakeup(const char *cause, bool interrupted);
+
+    /// Time and estimated charge used by each subsystem since boot, in the order of POWERMON_NUM_SUBSYSTEMS
+    size_t getSubsystems(PowerMonSubsystem *out, size_t maxOut) const;
+
+    /// Estimated charge used since boot, and the average current that works out to
+    float getTotalMah() const;
+    float getAverageMa() const;
+    uint64_t getTotalMs() const { return totalMs + (uint32_t)(millis() - lastChangeMs); }
+
+    /**
+     * Copy the state combinations we spent the most time in, longest first
+     * @return the number of entries stored in out
+     */
+    size_t getCombos(PowerMonCombo *out, size_t maxOut) const;
+
+    /**
+     * Copy the threads (and other causes) that woke the main loop most often, most wakeups first
+     * @return the number of entries stored in out
+     */
+    size_t getWakeups(PowerMonWakeups *out, size_t maxOut) const;
+
+    /// Log the energy estimate, the busiest state combinations and who keeps waking us
+    void logSummary();
+
+    /// Send a short energy summary to our own phone as a ClientNotification replying to replyId
+    void sendSummaryToPhone(uint32_t replyId);
+
   private:
     // Emit the coded log message
     void emitLog(const char *reason);
 
     // Use the 'live' config flag to figure out if we should be showing this message
     bool is_power_enabled(uint64_t m);
+
+    /// Charge the time since the last change to the states that were active during it
+    void accumulate();
+
+    /// Time a subsystem has been on, including the still running stretch since the last change
+    uint64_t getSubsystemMs(size_t i) const;
+
+    /// Turn the summary into one line of text, returns the length used
+    size_t formatSummary(char *buf, size_t len) const;
 };
 
 extern PowerMon *powerMon;
@@ -54,12 +54,15 @@ bool SafeFile::close()
         return false;
 
     f.close();
-    if (!testReadback())
+    if (!testReadback()) {
+        invalidateFilesManifest();
         return false;
+    }
 
     // brief window of risk here ;-)
     if (fullAtomic && FSCom.exists(filename.c_str()) && !FSCom.remove(filename.c_str())) {
         LOG_ERROR("Can't remove old pref file");
+        invalidateFilesManifest();
         return false;
     }
 
@@ -67,9 +70,12 @@ bool SafeFile::close()
     filenameTmp += ".tmp";
     if (!renameFile(filenameTmp.c_str(), filename.c_str())) {
         LOG_ERROR("Error: can't rename new pref file");
+        invalidateFilesManifest();
         return false;
     }
 
+    updateFilesManifest(filenameTmp.c_str());
+    updateFilesManifest(filename.c_str());
     return true;
 }
 
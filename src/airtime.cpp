@@ -1,6 +1,7 @@
 #include "airtime.h"
 #include "NodeDB.h"
 #include "configuration.h"
+#include <algorithm>
 
 AirTime *airTime = NULL;
 
@@ -9,15 +10,51 @@ AirTime *airTime = NULL;
 uint32_t air_period_tx[PERIODS_TO_LOG];
 uint32_t air_period_rx[PERIODS_TO_LOG];
 
+// Zero the slots of a ring we moved into since fromSlot, at most one full lap
+static void clearSlots(uint32_t *slots, uint32_t &sum, uint32_t numSlots, uint32_t fromSlot, uint32_t toSlot)
+{
+    for (uint32_t s = fromSlot + 1; s <= toSlot && s <= fromSlot + numSlots; s++) {
+        sum -= slots[s % numSlots];
+        slots[s % numSlots] = 0;
+    }
+}
+
+void AirTime::catchUp()
+{
+    uint32_t elapsedSecs = (millis() - lastCatchUpMs) / 1000;
+    if (elapsedSecs == 0)
+        return;
+    lastCatchUpMs += elapsedSecs * 1000;
+
+    uint32_t oldSecs = secSinceBoot;
+    secSinceBoot += elapsedSecs;
+
+    clearSlots(channelUtilization, channelUtilizationSum, CHANNEL_UTILIZATION_PERIODS, oldSecs / 10, secSinceBoot / 10);
+    clearSlots(utilizationTX, utilizationTXSum, MINUTES_IN_HOUR, oldSecs / 60, secSinceBoot / 60);
+
+    uint32_t newPeriods = secSinceBoot / SECONDS_PER_PERIOD - oldSecs / SECONDS_PER_PERIOD;
+    for (uint32_t i = 0; i < newPeriods && i < PERIODS_TO_LOG; i++)
+        airtimeRotatePeriod();
+
+    uint32_t oldSourceSlot = oldSecs / AIRTIME_SOURCE_SLOT_SECONDS;
+    uint32_t newSourceSlot = secSinceBoot / AIRTIME_SOURCE_SLOT_SECONDS;
+    for (uint32_t s = oldSourceSlot + 1; s <= newSourceSlot && s <= oldSourceSlot + AIRTIME_SOURCE_SLOTS; s++) {
+        clearSourceSlot(nodeSources, AIRTIME_MAX_NODE_SOURCES, s % AIRTIME_SOURCE_SLOTS);
+        clearSourceSlot(portSources, AIRTIME_MAX_PORT_SOURCES, s % AIRTIME_SOURCE_SLOTS);
+    }
+}
+
 void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
 {
+    catchUp();
 
     if (reportType == TX_LOG) {
         LOG_DEBUG("Packet TX: %ums", airtime_ms);
         this->airtimes.periodTX[0] = this->airtimes.periodTX[0] + airtime_ms;
         air_period_tx[0] = air_period_tx[0] + airtime_ms;
 
-        this->utilizationTX[this->getPeriodUtilHour()] = this->utilizationTX[this->getPeriodUtilHour()] + airtime_ms;
+        this->utilizationTX[this->getPeriodUtilHour()] += airtime_ms;
+        utilizationTXSum += airtime_ms;
     } else if (reportType == RX_LOG) {
         LOG_DEBUG("Packet RX: %ums", airtime_ms);
         this->airtimes.periodRX[0] = this->airtimes.periodRX[0] + airtime_ms;
@@ -28,52 +65,130 @@ void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
     }
 
     // Log all airtime type for channel utilization
-    this->channelUtilization[this->getPeriodUtilMinute()] = channelUtilization[this->getPeriodUtilMinute()] + airtime_ms;
+    this->channelUtilization[this->getPeriodUtilMinute()] += airtime_ms;
+    channelUtilizationSum += airtime_ms;
+}
+
+void AirTime::logNodeAirtime(NodeNum node, uint32_t airtime_ms)
+{
+    catchUp();
+    addToSource(nodeSources, AIRTIME_MAX_NODE_SOURCES, node, airtime_ms);
+}
+
+void AirTime::logPortAirtime(meshtastic_PortNum portnum, uint32_t airtime_ms)
+{
+    catchUp();
+    addToSource(portSources, AIRTIME_MAX_PORT_SOURCES, portnum, airtime_ms);
+}
+
+void AirTime::addToSource(AirtimeSource *sources, size_t numSources, uint32_t key, uint32_t airtime_ms)
+{
+    if (airtime_ms == 0)
+        return;
+
+    // Use the entry for this key if we have one, otherwise a free one, otherwise evict the quietest
+    AirtimeSource *entry = NULL;
+    AirtimeSource *quietest = &sources[0];
+    for (size_t i = 0; i < numSources; i++) {
+        AirtimeSource *s = &sources[i];
+        if (s->totalMs && s->key == key) {
+            entry = s;
+            break;
+        }
+        if (s->totalMs < quietest->totalMs)
+            quietest = s;
+    }
+    if (!entry) {
+        entry = quietest;
+        memset(entry, 0, sizeof(*entry));
+        entry->key = key;
+    }
+
+    entry->slotMs[currentSourceSlot()] += airtime_ms;
+    entry->totalMs += airtime_ms;
+}
+
+void AirTime::clearSourceSlot(AirtimeSource *sources, size_t numSources, uint8_t slot)
+{
+    for (size_t i = 0; i < numSources; i++) {
+        sources[i].totalMs -= sources[i].slotMs[slot];
+        sources[i].slotMs[slot] = 0;
+    }
+}
+
+size_t AirTime::getTopSources(const AirtimeSource *sources, size_t numSources, AirtimeShare *out, size_t maxOut)
+{
+    catchUp();
+
+    static_assert(AIRTIME_MAX_NODE_SOURCES >= AIRTIME_MAX_PORT_SOURCES, "scratch below must fit either table");
+    AirtimeShare all[AIRTIME_MAX_NODE_SOURCES];
+    size_t numUsed = 0;
+    for (size_t i = 0; i < numSources; i++) {
+        if (sources[i].totalMs)
+            all[numUsed++] = {sources[i].key, sources[i].totalMs};
+    }
+    std::sort(all, all + numUsed, [](const AirtimeShare &a, const AirtimeShare &b) { return a.airtimeMs > b.airtimeMs; });
+
+    size_t numOut = std::min(numUsed, maxOut);
+    memcpy(out, all, numOut * sizeof(AirtimeShare));
+    return numOut;
+}
+
+size_t AirTime::getNodeAirtime(AirtimeShare *out, size_t maxOut)
+{
+    return getTopSources(nodeSources, AIRTIME_MAX_NODE_SOURCES, out, maxOut);
+}
+
+size_t AirTime::getPortAirtime(AirtimeShare *out, size_t maxOut)
+{
+    return getTopSources(portSources, AIRTIME_MAX_PORT_SOURCES, out, maxOut);
 }
 
 uint8_t AirTime::currentPeriodIndex()
 {
-    return ((getSecondsSinceBoot() / SECONDS_PER_PERIOD) % PERIODS_TO_LOG);
+    return ((secSinceBoot / SECONDS_PER_PERIOD) % PERIODS_TO_LOG);
 }
 
 uint8_t AirTime::getPeriodUtilMinute()
 {
-    return (getSecondsSinceBoot() / 10) % CHANNEL_UTILIZATION_PERIODS;
+    return (secSinceBoot / 10) % CHANNEL_UTILIZATION_PERIODS;
 }
 
 uint8_t AirTime::getPeriodUtilHour()
 {
-    return (getSecondsSinceBoot() / 60) % MINUTES_IN_HOUR;
+    return (secSinceBoot / 60) % MINUTES_IN_HOUR;
 }
 
-void AirTime::airtimeRotatePeriod()
+uint8_t AirTime::currentSourceSlot()
 {
+    return (secSinceBoot / AIRTIME_SOURCE_SLOT_SECONDS) % AIRTIME_SOURCE_SLOTS;
+}
 
-    if (this->airtimes.lastPeriodIndex != this->currentPeriodIndex()) {
-        LOG_DEBUG("Rotate airtimes to a new period = %u", this->currentPeriodIndex());
-
-        for (int i = PERIODS_TO_LOG - 2; i >= 0; --i) {
-            this->airtimes.periodTX[i + 1] = this->airtimes.periodTX[i];
-            this->airtimes.periodRX[i + 1] = this->airtimes.periodRX[i];
-            this->airtimes.periodRX_ALL[i + 1] = this->airtimes.periodRX_ALL[i];
+// Shift the per period logs by one period, called by catchUp() for every period boundary we crossed
+void AirTime::airtimeRotatePeriod()
+{
+    LOG_DEBUG("Rotate airtimes to a new period = %u", this->currentPeriodIndex());
 
-            air_period_tx[i + 1] = this->airtimes.periodTX[i];
-            air_period_rx[i + 1] = this->airtimes.periodRX[i];
-        }
+    for (int i = PERIODS_TO_LOG - 2; i >= 0; --i) {
+        this->airtimes.periodTX[i + 1] = this->airtimes.periodTX[i];
+        this->airtimes.periodRX[i + 1] = this->airtimes.periodRX[i];
+        this->airtimes.periodRX_ALL[i + 1] = this->airtimes.periodRX_ALL[i];
 
-        this->airtimes.periodTX[0] = 0;
-        this->airtimes.periodRX[0] = 0;
-        this->airtimes.periodRX_ALL[0] = 0;
+        air_period_tx[i + 1] = this->airtimes.periodTX[i];
+        air_period_rx[i + 1] = this->airtimes.periodRX[i];
+    }
 
-        air_period_tx[0] = 0;
-        air_period_rx[0] = 0;
+    this->airtimes.periodTX[0] = 0;
+    this->airtimes.periodRX[0] = 0;
+    this->airtimes.periodRX_ALL[0] = 0;
 
-        this->airtimes.lastPeriodIndex = this->currentPeriodIndex();
-    }
+    air_period_tx[0] = 0;
+    air_period_rx[0] = 0;
 }
 
 uint32_t *AirTime::airtimeReport(reportTypes reportType)
 {
+    catchUp();
 
     if (reportType == TX_LOG) {
         return this->airtimes.periodTX;
@@ -97,27 +212,20 @@ uint32_t AirTime::getSecondsPerPeriod()
 
 uint32_t AirTime::getSecondsSinceBoot()
 {
+    catchUp();
     return this->secSinceBoot;
 }
 
 float AirTime::channelUtilizationPercent()
 {
-    uint32_t sum = 0;
-    for (uint32_t i = 0; i < CHANNEL_UTILIZATION_PERIODS; i++) {
-        sum += this->channelUtilization[i];
-    }
-
-    return (float(sum) / float(CHANNEL_UTILIZATION_PERIODS * 10 * 1000)) * 100;
+    catchUp();
+    return (float(channelUtilizationSum) / float(CHANNEL_UTILIZATION_PERIODS * 10 * 1000)) * 100;
 }
 
 float AirTime::utilizationTXPercent()
 {
-    uint32_t sum = 0;
-    for (uint32_t i = 0; i < MINUTES_IN_HOUR; i++) {
-        sum += this->utilizationTX[i];
-    }
-
-    return (float(sum) / float(MS_IN_HOUR)) * 100;
+    catchUp();
+    return (float(utilizationTXSum) / float(MS_IN_HOUR)) * 100;
 }
 
 bool AirTime::isTxAllowedChannelUtil(bool polite)
@@ -147,6 +255,7 @@ bool AirTime::isTxAllowedAirUtil()
 // Get the amount of minutes we have to be silent before we can send again
 uint8_t AirTime::getSilentMinutes(float txPercent, float dutyCycle)
 {
+    catchUp();
     float newTxPercent = txPercent;
     for (int8_t i = MINUTES_IN_HOUR - 1; i >= 0; --i) {
         newTxPercent -= ((float)this->utilizationTX[i] / (MS_IN_MINUTE * MINUTES_IN_HOUR / 100));
@@ -157,54 +266,4 @@ uint8_t AirTime::getSilentMinutes(float txPercent, float dutyCycle)
     return MINUTES_IN_HOUR;
 }
 
-AirTime::AirTime() : concurrency::OSThread("AirTime"), airtimes({}) {}
-
-int32_t AirTime::runOnce()
-{
-    secSinceBoot++;
-
-    uint8_t utilPeriod = this->getPeriodUtilMinute();
-    uint8_t utilPeriodTX = this->getPeriodUtilHour();
-
-    if (firstTime) {
-
-        // Init utilizationTX window to all 0
-        for (uint32_t i = 0; i < MINUTES_IN_HOUR; i++) {
-            this->utilizationTX[i] = 0;
-        }
-
-        // Init channelUtilization window to all 0
-        for (uint32_t i = 0; i < CHANNEL_UTILIZATION_PERIODS; i++) {
-            this->channelUtilization[i] = 0;
-        }
-
-        // Init airtime windows to all 0
-        for (int i = 0; i < PERIODS_TO_LOG; i++) {
-            this->airtimes.periodTX[i] = 0;
-            this->airtimes.periodRX[i] = 0;
-            this->airtimes.periodRX_ALL[i] = 0;
-
-            // air_period_tx[i] = 0;
-            // air_period_rx[i] = 0;
-        }
-
-        firstTime = false;
-        lastUtilPeriod = utilPeriod;
-    } else {
-        this->airtimeRotatePeriod();
-
-        // Reset the channelUtilization window when we roll over
-        if (lastUtilPeriod != utilPeriod) {
-            lastUtilPeriod = utilPeriod;
-
-            this->channelUtilization[utilPeriod] = 0;
-        }
-
-        if (lastUtilPeriodTX != utilPeriodTX) {
-            lastUtilPeriodTX = utilPeriodTX;
-
-            this->utilizationTX[utilPeriodTX] = 0;
-        }
-    }
-    return (1000 * 1);
-}
+AirTime::AirTime() : airtimes({}) {}
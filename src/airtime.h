@@ -1,7 +1,7 @@
 #pragma once
 
 #include "MeshRadio.h"
-#include "concurrency/OSThread.h"
+#include "MeshTypes.h"
 #include "configuration.h"
 #include <Arduino.h>
 #include <functional>
@@ -23,6 +23,13 @@
                     other lora radios.
 
   RX_ALL_LOG - RX_LOG = Other lora radios on our frequency channel.
+
+  Nothing here runs on a timer, the windows are rolled forward from millis() whenever they are read or written, so an idle
+  device doesn't have to wake up just to keep its airtime statistics.
+
+  On top of the totals we attribute airtime over the last hour to the node that sent a packet (every frame heard, our own
+  transmissions count against our node) and to its portnum (packets we handled, relays and duplicates excluded), so we can
+  find the nodes and modules that use up the channel.
 */
 
 #define CHANNEL_UTILIZATION_PERIODS 6
@@ -33,19 +40,44 @@
 #define MS_IN_MINUTE (SECONDS_IN_MINUTE * 1000)
 #define MS_IN_HOUR (MINUTES_IN_HOUR * SECONDS_IN_MINUTE * 1000)
 
+#define AIRTIME_SOURCE_SLOTS 6          // The attribution window is made of this many slots...
+#define AIRTIME_SOURCE_SLOT_SECONDS 600 // ...of this many seconds each, one hour in total
+#define AIRTIME_MAX_NODE_SOURCES 32     // Quietest node is forgotten when the table is full
+#define AIRTIME_MAX_PORT_SOURCES 16
+
 enum reportTypes { TX_LOG, RX_LOG, RX_ALL_LOG };
 
 void logAirtime(reportTypes reportType, uint32_t airtime_ms);
 
 uint32_t *airtimeReport(reportTypes reportType);
 
-class AirTime : private concurrency::OSThread
+/// Airtime used by one node or portnum over the attribution window
+struct AirtimeShare {
+    uint32_t key; // NodeNum or meshtastic_PortNum
+    uint32_t airtimeMs;
+};
+
+class AirTime
 {
 
   public:
     AirTime();
 
     void logAirtime(reportTypes reportType, uint32_t airtime_ms);
+
+    /// Attribute airtime to the node that transmitted a frame
+    void logNodeAirtime(NodeNum node, uint32_t airtime_ms);
+
+    /// Attribute airtime to the portnum of a packet, meshtastic_PortNum_UNKNOWN_APP if we couldn't decode it
+    void logPortAirtime(meshtastic_PortNum portnum, uint32_t airtime_ms);
+
+    /**
+     * Copy the nodes (or portnums) with the most airtime over the attribution window, busiest first.
+     * @return the number of entries stored in out
+     */
+    size_t getNodeAirtime(AirtimeShare *out, size_t maxOut);
+    size_t getPortAirtime(AirtimeShare *out, size_t maxOut);
+
     float channelUtilizationPercent();
     float utilizationTXPercent();
 
@@ -63,10 +95,10 @@ class AirTime : private concurrency::OSThread
     bool isTxAllowedAirUtil();
 
   private:
-    bool firstTime = true;
-    uint8_t lastUtilPeriod = 0;
-    uint8_t lastUtilPeriodTX = 0;
     uint32_t secSinceBoot = 0;
+    uint32_t lastCatchUpMs = 0;         // millis() that secSinceBoot corresponds to
+    uint32_t channelUtilizationSum = 0; // Running sums of the windows, so the percentages don't have to add them up
+    uint32_t utilizationTXSum = 0;
     uint8_t max_channel_util_percent = 40;
     uint8_t polite_channel_util_percent = 25;
     uint8_t polite_duty_cycle_percent = 50; // half of Duty Cycle allowance is ok for metadata
@@ -75,15 +107,27 @@ class AirTime : private concurrency::OSThread
         uint32_t periodTX[PERIODS_TO_LOG];     // AirTime transmitted
         uint32_t periodRX[PERIODS_TO_LOG];     // AirTime received and repeated (Only valid mesh packets)
         uint32_t periodRX_ALL[PERIODS_TO_LOG]; // AirTime received regardless of valid mesh packet. Could include noise.
-        uint8_t lastPeriodIndex;
     } airtimes;
 
+    struct AirtimeSource {
+        uint32_t key;
+        uint32_t slotMs[AIRTIME_SOURCE_SLOTS];
+        uint32_t totalMs; // 0 means this entry is free
+    };
+    AirtimeSource nodeSources[AIRTIME_MAX_NODE_SOURCES] = {};
+    AirtimeSource portSources[AIRTIME_MAX_PORT_SOURCES] = {};
+
+    /// Roll every window forward to the current time, clearing the slots we moved into since we last looked
+    void catchUp();
+
     uint8_t getPeriodUtilMinute();
     uint8_t getPeriodUtilHour();
     uint8_t currentPeriodIndex();
+    uint8_t currentSourceSlot();
 
-  protected:
-    virtual int32_t runOnce() override;
+    void addToSource(AirtimeSource *sources, size_t numSources, uint32_t key, uint32_t airtime_ms);
+    void clearSourceSlot(AirtimeSource *sources, size_t numSources, uint8_t slot);
+    size_t getTopSources(const AirtimeSource *sources, size_t numSources, AirtimeShare *out, size_t maxOut);
 };
 
 extern AirTime *airTime;
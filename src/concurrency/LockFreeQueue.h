@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+namespace concurrency
+{
+
+/**
+ * A fixed size FIFO for handing items from exactly one producer task to exactly one consumer task without taking a lock.
+ *
+ * Only the producer may call push() and only the consumer may call pop().  Holds N - 1 items.
+ */
+template <class T, size_t N> class LockFreeQueue
+{
+    T items[N];
+    std::atomic<size_t> head{0}; // Next slot to pop, only written by the consumer
+    std::atomic<size_t> tail{0}; // Next slot to push, only written by the producer
+
+  public:
+    /// Add an item, false if the queue is full
+    bool push(const T &item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t next = (t + 1) % N;
+        if (next == head.load(std::memory_order_acquire))
+            return false;
+        items[t] = item;
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /// Take the oldest item, false if the queue is empty
+    bool pop(T &item)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[h];
+        head.store((h + 1) % N, std::memory_order_release);
+        return true;
+    }
+
+    /// Items waiting, only a snapshot when called from the other side
+    size_t numWaiting() const { return (tail.load(std::memory_order_acquire) + N - head.load(std::memory_order_acquire)) % N; }
+};
+
+} // namespace concurrency
@@ -36,6 +36,9 @@ class NotifiedWorkerThread : public OSThread
     bool notifyLater(uint32_t delay, uint32_t v, bool overwrite);
 
   protected:
+    /// What we interrupt so our controller gets run, the main loop's delay unless we were moved to a task of our own
+    InterruptableDelay *wakeDelay = &mainDelay;
+
     virtual void onNotify(uint32_t notification) = 0;
 
     /// just calls checkNotification()
@@ -17,6 +17,8 @@ bool OSThread::showWaiting = false;
 
 const OSThread *OSThread::currentThread;
 
+OSThread::WakeupKind OSThread::pendingWakeup = OSThread::NoWakeup;
+
 ThreadController mainController, timerController;
 InterruptableDelay mainDelay;
 
@@ -45,6 +47,17 @@ OSThread::~OSThread()
         controller->remove(this);
 }
 
+void OSThread::moveToController(ThreadController *_controller)
+{
+    if (controller)
+        controller->remove(this);
+    controller = _controller;
+    if (controller) {
+        bool added = controller->add(this);
+        assert(added);
+    }
+}
+
 /**
  * Wait a specified number msecs starting from the current time (rather than the last time we were run)
  */
@@ -57,6 +70,11 @@ void OSThread::setIntervalFromNow(unsigned long _interval)
     _cached_next_run = millis() + interval;
 }
 
+void OSThread::noteWakeup(bool interrupted)
+{
+    pendingWakeup = interrupted ? InterruptWakeup : TimerWakeup;
+}
+
 bool OSThread::shouldRun(unsigned long time)
 {
     bool r = Thread::shouldRun(time);
@@ -82,6 +100,13 @@ void OSThread::run()
     auto heap = memGet.getFreeHeap();
 #endif
     currentThread = this;
+    if (pendingWakeup != NoWakeup) {
+        if (pendingWakeup == InterruptWakeup)
+            interruptWakeups++;
+        else
+            timerWakeups++;
+        pendingWakeup = NoWakeup;
+    }
     auto newDelay = runOnce();
 #ifdef DEBUG_HEAP
     auto newHeap = memGet.getFreeHeap();
@@ -41,10 +41,22 @@ class OSThread : public Thread
     /// Show debugging info for threads we decide not to run;
     static bool showWaiting;
 
+    enum WakeupKind { NoWakeup, TimerWakeup, InterruptWakeup };
+
+    /// The main loop just woke up and no thread has run since
+    static WakeupKind pendingWakeup;
+
   public:
     /// For debug printing only (might be null)
     static const OSThread *currentThread;
 
+    /// How often this thread was the first to run after the main loop slept, by what ended the sleep
+    uint32_t timerWakeups = 0;
+    uint32_t interruptWakeups = 0;
+
+    /// Called by loop() after it slept, so the wakeup gets charged to the next thread that runs
+    static void noteWakeup(bool interrupted);
+
     OSThread(const char *name, uint32_t period = 0, ThreadController *controller = &mainController);
 
     virtual ~OSThread();
@@ -61,6 +73,9 @@ class OSThread : public Thread
     void setIntervalFromNow(unsigned long _interval);
 
   protected:
+    /// Leave our controller for another one (e.g. one that runs on a task of its own)
+    void moveToController(ThreadController *_controller);
+
     /**
      * The method that will be called each time our thread gets a chance to run
      *
@@ -2,7 +2,10 @@
 
 #if !MESHTASTIC_EXCLUDE_I2C
 
+#include "FSCommon.h"
+#include "SafeFile.h"
 #include "concurrency/LockGuard.h"
+#include <algorithm>
 #if defined(ARCH_PORTDUINO)
 #include "linux/LinuxHardwareI2C.h"
 #endif
@@ -10,6 +13,17 @@
 #include "meshUtils.h" // vformat
 #endif
 
+#define I2C_CACHE_FILE "/prefs/i2c.bin"
+#define I2C_CACHE_MAGIC 0x49324331 // "I2C1"
+#define I2C_CACHE_MAX_DEVICES 32
+
+// The device types are only stable within one firmware version, so we store it with the map
+typedef struct I2CCacheHeader {
+    uint32_t magic;
+    char version[32];
+    uint8_t count;
+} I2CCacheHeader;
+
 // AXP192 and AXP2101 have the same device address, we just need to identify it in Power.cpp
 #ifndef XPOWERS_AXP192_AXP2101_ADDRESS
 #define XPOWERS_AXP192_AXP2101_ADDRESS 0x34
@@ -450,7 +464,134 @@ void ScanI2CTwoWire::scanPort(I2CPort port, uint8_t *address, uint8_t asize)
 
 void ScanI2CTwoWire::scanPort(I2CPort port)
 {
+    uint32_t start = millis();
+    uint8_t cached[I2C_CACHE_MAX_DEVICES];
+    uint8_t cachedCount = 0;
+    for (auto &device : cachedDevices) {
+        if (device.port == port)
+            cached[cachedCount++] = device.address;
+    }
+
+    if (cachedCount > 0) {
+        LOG_INFO("Verify %u cached I2C devices on port %d", cachedCount, port);
+        scanPort(port, cached, cachedCount);
+        if (matchesCache(port)) {
+            LOG_INFO("I2C port %d verified in %ums", port, millis() - start);
+            return;
+        }
+        LOG_INFO("I2C devices on port %d changed, do a full scan", port);
+        forgetPort(port);
+    }
+
     scanPort(port, nullptr, 0);
+    LOG_INFO("I2C port %d scanned in %ums", port, millis() - start);
+}
+
+bool ScanI2CTwoWire::matchesCache(I2CPort port) const
+{
+    size_t cachedCount = 0, foundCount = 0;
+    for (auto &device : cachedDevices) {
+        if (device.port != port)
+            continue;
+        auto found = foundDevices.find(DeviceAddress(port, device.address));
+        if (found == foundDevices.end() || found->first.port != port || found->second != device.type)
+            return false;
+        cachedCount++;
+    }
+
+    for (auto &found : foundDevices) {
+        if (found.first.port == port)
+            foundCount++;
+    }
+    return cachedCount == foundCount;
+}
+
+void ScanI2CTwoWire::forgetPort(I2CPort port)
+{
+    concurrency::LockGuard guard((concurrency::Lock *)&lock);
+
+    for (auto it = foundDevices.begin(); it != foundDevices.end();) {
+        if (it->first.port == port)
+            it = foundDevices.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = deviceAddresses.begin(); it != deviceAddresses.end();) {
+        if (it->second.port == port)
+            it = deviceAddresses.erase(it);
+        else
+            ++it;
+    }
+}
+
+void ScanI2CTwoWire::loadCache()
+{
+    cachedDevices.clear();
+#ifdef FSCom
+    auto file = FSCom.open(I2C_CACHE_FILE, FILE_O_READ);
+    if (!file) {
+        LOG_INFO("No I2C device cache, do a full scan");
+        return;
+    }
+
+    I2CCacheHeader header;
+    bool okay = file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) && header.magic == I2C_CACHE_MAGIC &&
+                header.count <= I2C_CACHE_MAX_DEVICES;
+    if (okay && strncmp(header.version, optstr(APP_VERSION), sizeof(header.version)) != 0) {
+        LOG_INFO("I2C device cache is from firmware %.32s, do a full scan", header.version);
+        okay = false;
+    }
+
+    for (uint8_t i = 0; okay && i < header.count; i++) {
+        CachedDevice device;
+        okay = file.read((uint8_t *)&device, sizeof(device)) == sizeof(device);
+        if (okay)
+            cachedDevices.push_back(device);
+    }
+    file.close();
+
+    if (!okay) {
+        cachedDevices.clear();
+        return;
+    }
+    LOG_DEBUG("Loaded %u cached I2C devices", (unsigned)cachedDevices.size());
+#endif
+}
+
+void ScanI2CTwoWire::saveCache()
+{
+#ifdef FSCom
+    std::vector<CachedDevice> devices;
+    for (auto &found : foundDevices) {
+        if (devices.size() == I2C_CACHE_MAX_DEVICES)
+            break;
+        devices.push_back({(uint8_t)found.first.port, found.first.address, (uint8_t)found.second});
+    }
+
+    // foundDevices is sorted, and so is the map we saved last time
+    if (devices.size() == cachedDevices.size() &&
+        std::equal(devices.begin(), devices.end(), cachedDevices.begin(), [](const CachedDevice &a, const CachedDevice &b) {
+            return a.port == b.port && a.address == b.address && a.type == b.type;
+        }))
+        return;
+
+    I2CCacheHeader header = {};
+    header.magic = I2C_CACHE_MAGIC;
+    strncpy(header.version, optstr(APP_VERSION), sizeof(header.version));
+    header.count = devices.size();
+
+    FSCom.mkdir("/prefs");
+    auto file = SafeFile(I2C_CACHE_FILE);
+    file.write((uint8_t *)&header, sizeof(header));
+    for (auto &device : devices)
+        file.write((uint8_t *)&device, sizeof(device));
+    if (file.close()) {
+        LOG_INFO("Saved %u I2C devices to %s", header.count, I2C_CACHE_FILE);
+        cachedDevices = devices;
+    } else {
+        LOG_WARN("Can't save I2C device cache");
+    }
+#endif
 }
 
 TwoWire *ScanI2CTwoWire::fetchI2CBus(ScanI2C::DeviceAddress address) const
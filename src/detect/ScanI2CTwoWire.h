@@ -7,6 +7,7 @@
 #include <memory>
 #include <stddef.h>
 #include <stdint.h>
+#include <vector>
 
 #include <Wire.h>
 
@@ -21,6 +22,16 @@ class ScanI2CTwoWire : public ScanI2C
 
     void scanPort(ScanI2C::I2CPort, uint8_t *, uint8_t) override;
 
+    /**
+     * Load the device map saved by a previous boot (of the same firmware version). After this, scanPort(port) only probes
+     * the cached addresses of that port, and falls back to a full scan if any of them changed.
+     * To force a full scan, delete I2C_CACHE_FILE (e.g. with the delete_file admin request) or do a factory reset.
+     */
+    void loadCache();
+
+    /// Save the current device map for the next boot, if it differs from what we loaded
+    void saveCache();
+
     ScanI2C::FoundDevice find(ScanI2C::DeviceType) const override;
 
     TwoWire *fetchI2CBus(ScanI2C::DeviceAddress) const;
@@ -53,6 +64,21 @@ class ScanI2CTwoWire : public ScanI2C
 
     concurrency::Lock lock;
 
+    typedef struct CachedDevice {
+        uint8_t port;
+        uint8_t address;
+        uint8_t type;
+    } CachedDevice;
+
+    // The device map loaded by loadCache()
+    std::vector<CachedDevice> cachedDevices;
+
+    /// Did the scan of the cached addresses on this port find exactly what we cached?
+    bool matchesCache(ScanI2C::I2CPort) const;
+
+    /// Drop everything we found on this port, before a full rescan
+    void forgetPort(ScanI2C::I2CPort);
+
     uint16_t getRegisterValue(const RegisterLocation &, ResponseWidth) const;
 
     DeviceType probeOLED(ScanI2C::DeviceAddress) const;
@@ -62,6 +62,7 @@ static struct uBloxGnssModelInfo {
 
 #define GPS_SOL_EXPIRY_MS 5000 // in millis. give 1 second time to combine different sentences. NMEA Frequency isn't higher anyway
 #define NMEA_MSG_GXGSA "GNGSA" // GSA message (GPGSA, GNGSA etc)
+#define GPS_INIT_POLL_MS 20    // How often we look for answers from the chip while probing and configuring it
 
 // For logging
 static const char *getGPSPowerStateString(GPSPowerState state)
@@ -424,6 +425,90 @@ int GPS::getACK(uint8_t *buffer, uint16_t size, uint8_t requestedClass, uint8_t
     return 0;
 }
 
+void GPS::resetACK()
+{
+    ackLen = 0;
+    ackFrameErrors = 0;
+}
+
+GPS_RESPONSE GPS::pollACK(const char *message)
+{
+    while (_serial_gps->available()) {
+        uint8_t b = _serial_gps->read();
+        ackBuf[ackLen++] = b;
+        if ((ackLen == sizeof(ackBuf) - 1) || (b == '\r')) {
+            bool found = strnstr((char *)ackBuf, message, ackLen) != nullptr;
+            ackLen = 0;
+            if (found) {
+#ifdef GPS_DEBUG
+                LOG_DEBUG("Found: %s", message);
+#endif
+                return GNSS_RESPONSE_OK;
+            }
+        }
+    }
+    return GNSS_RESPONSE_NONE;
+}
+
+GPS_RESPONSE GPS::pollACKCas(uint8_t class_id, uint8_t msg_id)
+{
+    // See getACKCas() for the frame layout
+    while (_serial_gps->available()) {
+        ackBuf[ackLen++] = _serial_gps->read();
+
+        // Keep looking for the CAS frame header (0xBA, 0xCE)
+        if ((ackLen == 2) && !(ackBuf[0] == 0xBA && ackBuf[1] == 0xCE)) {
+            ackBuf[0] = ackBuf[1];
+            ackLen = 1;
+        }
+
+        if (ackLen == CAS_ACK_NACK_MSG_SIZE - 1) {
+            ackLen = 0;
+            if (ackBuf[4] == 0x05 && ackBuf[6] == class_id && ackBuf[7] == msg_id) {
+                return (ackBuf[5] == 0x01) ? GNSS_RESPONSE_OK : GNSS_RESPONSE_NAK;
+            }
+        }
+    }
+    return GNSS_RESPONSE_NONE;
+}
+
+GPS_RESPONSE GPS::pollACK(uint8_t class_id, uint8_t msg_id)
+{
+    // The UBX-ACK-ACK we are waiting for, see getACK()
+    uint8_t buf[10] = {0xB5, 0x62, 0x05, 0x01, 0x02, 0x00, class_id, msg_id, 0x00, 0x00};
+    const char frame_errors[] = "More than 100 frame errors";
+
+    for (int j = 2; j < 8; j++) {
+        buf[8] += buf[j];
+        buf[9] += buf[8];
+    }
+
+    while (_serial_gps->available()) {
+        uint8_t b = _serial_gps->read();
+        if (b == frame_errors[ackFrameErrors]) {
+            if (++ackFrameErrors == 26)
+                return GNSS_RESPONSE_FRAME_ERRORS;
+        } else {
+            ackFrameErrors = 0;
+        }
+
+        if (b == buf[ackLen]) {
+            if (++ackLen == sizeof(buf)) {
+                ackLen = 0;
+                return GNSS_RESPONSE_OK;
+            }
+        } else {
+            if (ackLen == 3 && b == 0x00) { // UBX-ACK-NAK message
+                ackLen = 0;
+                LOG_WARN("Got NAK for class %02X message %02X", class_id, msg_id);
+                return GNSS_RESPONSE_NAK;
+            }
+            ackLen = 0;
+        }
+    }
+    return GNSS_RESPONSE_NONE;
+}
+
 #if GPS_BAUDRATE_FIXED
 // if GPS_BAUDRATE is specified in variant, only try that.
 static const int serialSpeeds[1] = {GPS_BAUDRATE};
@@ -437,33 +522,39 @@ static const int rareSerialSpeeds[3] = {4800, 57600, GPS_BAUDRATE};
  * @brief  Setup the GPS based on the model detected.
  *  We detect the GPS by cycling through a set of baud rates, first common then rare.
  *  For each baud rate, we run GPS::Probe to send commands and match the responses
- *  to known GPS responses.
+ *  to known GPS responses. Once we know the model, we queue its configuration and
+ *  send it one command at a time.
+ *  Every call only does as much as it can without waiting for the chip, and leaves
+ *  in initWaitMs when it wants to be called again.
  * @retval Whether setup reached the end of its potential to configure the GPS.
  */
 bool GPS::setup()
 {
+    initWaitMs = GPS_INIT_POLL_MS;
+    if (!GPSInitStarted) {
+        GPSInitStarted = true;
+        initStartMs = initPhaseStartMs = millis();
+    }
+
     if (!didSerialInit) {
-        int msglen = 0;
         if (tx_gpio && gnssModel == GNSS_MODEL_UNKNOWN) {
-            if (probeTries < 2) {
-                LOG_DEBUG("Probe for GPS at %d", serialSpeeds[speedSelect]);
-                gnssModel = probe(serialSpeeds[speedSelect]);
-                if (gnssModel == GNSS_MODEL_UNKNOWN) {
+            int serialSpeed = (probeTries < 2) ? serialSpeeds[speedSelect] : rareSerialSpeeds[speedSelect];
+            if (probeState == GPS_PROBE_START)
+                LOG_DEBUG("Probe for GPS at %d", serialSpeed);
+            if (!probe(serialSpeed))
+                return false; // Still waiting for an answer
+
+            if (gnssModel == GNSS_MODEL_UNKNOWN) {
+                if (probeTries < 2) {
                     if (++speedSelect == array_count(serialSpeeds)) {
                         speedSelect = 0;
                         ++probeTries;
                     }
-                }
-            }
-            // Rare Serial Speeds
-            if (probeTries == 2) {
-                LOG_DEBUG("Probe for GPS at %d", rareSerialSpeeds[speedSelect]);
-                gnssModel = probe(rareSerialSpeeds[speedSelect]);
-                if (gnssModel == GNSS_MODEL_UNKNOWN) {
-                    if (++speedSelect == array_count(rareSerialSpeeds)) {
-                        LOG_WARN("Give up on GPS probe and set to %d", GPS_BAUDRATE);
-                        return true;
-                    }
+                } else if (++speedSelect == array_count(rareSerialSpeeds)) {
+                    // Rare Serial Speeds exhausted too
+                    LOG_WARN("Give up on GPS probe and set to %d", GPS_BAUDRATE);
+                    logInitPhase("probe");
+                    return true;
                 }
             }
         }
@@ -471,267 +562,291 @@ bool GPS::setup()
         if (gnssModel != GNSS_MODEL_UNKNOWN) {
             setConnected();
         } else {
+            initWaitMs = 2000; // Probe failed, try the next speed in two seconds
             return false;
         }
 
-        if (gnssModel == GNSS_MODEL_MTK) {
-            /*
-             * t-beam-s3-core uses the same L76K GNSS module as t-echo.
-             * Unlike t-echo, L76K uses 9600 baud rate for communication by default.
-             * */
+        if (initSteps.empty()) {
+            logInitPhase("probe");
+            queueInitSteps();
+        }
+        if (!runInitStep())
+            return false;
+
+        LOG_INFO("GPS init: sent %u config commands, %u failed", (unsigned)initSteps.size(), initStepFailures);
+        logInitPhase("config");
+        initSteps.clear();
+        initSteps.shrink_to_fit();
+        didSerialInit = true;
+    }
+
+    notifyDeepSleepObserver.observe(&notifyDeepSleep);
+
+    return true;
+}
+
+void GPS::logInitPhase(const char *phase)
+{
+    uint32_t now = millis();
+    LOG_INFO("GPS init: %s took %ums (%ums since start)", phase, now - initPhaseStartMs, now - initStartMs);
+    initPhaseStartMs = now;
+}
+
+static GPSInitStep nmeaStep(const char *sentence, uint16_t settleMs = 0)
+{
+    return {GPS_STEP_NMEA, sentence, 0, 0, NULL, 0, 0, settleMs, false};
+}
+
+static GPSInitStep waitStep(uint16_t settleMs)
+{
+    return {GPS_STEP_WAIT, "wait", 0, 0, NULL, 0, 0, settleMs, false};
+}
 
+#define UBX_STEP(TYPE, ID, DATA, WHAT, TIMEOUT, ...) {GPS_STEP_UBX, WHAT, TYPE, ID, DATA, sizeof(DATA), TIMEOUT, ##__VA_ARGS__}
+#define CAS_STEP(TYPE, ID, DATA, WHAT, TIMEOUT, ...) {GPS_STEP_CAS, WHAT, TYPE, ID, DATA, sizeof(DATA), TIMEOUT, ##__VA_ARGS__}
+
+void GPS::queueInitSteps()
+{
+    initSteps.clear();
+    initStepIndex = 0;
+    initStepState = GPS_INIT_STEP_SEND;
+    initStepFailures = 0;
+
+    if (gnssModel == GNSS_MODEL_MTK) {
+        /*
+         * t-beam-s3-core uses the same L76K GNSS module as t-echo.
+         * Unlike t-echo, L76K uses 9600 baud rate for communication by default.
+         * */
+        initSteps = {
             // Initialize the L76K Chip, use GPS + GLONASS + BEIDOU
-            _serial_gps->write("$PCAS04,7*1E\r\n");
-            delay(250);
+            nmeaStep("$PCAS04,7*1E\r\n", 250),
             // only ask for RMC and GGA
-            _serial_gps->write("$PCAS03,1,0,0,0,1,0,0,0,0,0,,,0,0*02\r\n");
-            delay(250);
+            nmeaStep("$PCAS03,1,0,0,0,1,0,0,0,0,0,,,0,0*02\r\n", 250),
             // Switch to Vehicle Mode, since SoftRF enables Aviation < 2g
-            _serial_gps->write("$PCAS11,3*1E\r\n");
-            delay(250);
-        } else if (gnssModel == GNSS_MODEL_MTK_L76B) {
-            // Waveshare Pico-GPS hat uses the L76B with 9600 baud
+            nmeaStep("$PCAS11,3*1E\r\n", 250),
+        };
+    } else if (gnssModel == GNSS_MODEL_MTK_L76B) {
+        // Waveshare Pico-GPS hat uses the L76B with 9600 baud
+        initSteps = {
             // Initialize the L76B Chip, use GPS + GLONASS
             // See note in L76_Series_GNSS_Protocol_Specification, chapter 3.29
-            _serial_gps->write("$PMTK353,1,1,0,0,0*2B\r\n");
-            // Above command will reset the GPS and takes longer before it will accept new commands
-            delay(1000);
+            // This will reset the GPS and takes longer before it will accept new commands
+            nmeaStep("$PMTK353,1,1,0,0,0*2B\r\n", 1000),
             // only ask for RMC and GGA (GNRMC and GNGGA)
             // See note in L76_Series_GNSS_Protocol_Specification, chapter 2.1
-            _serial_gps->write("$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*28\r\n");
-            delay(250);
+            nmeaStep("$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*28\r\n", 250),
             // Enable SBAS
-            _serial_gps->write("$PMTK301,2*2E\r\n");
-            delay(250);
+            nmeaStep("$PMTK301,2*2E\r\n", 250),
             // Enable PPS for 2D/3D fix only
-            _serial_gps->write("$PMTK285,3,100*3F\r\n");
-            delay(250);
+            nmeaStep("$PMTK285,3,100*3F\r\n", 250),
             // Switch to Fitness Mode, for running and walking purpose with low speed (<5 m/s)
-            _serial_gps->write("$PMTK886,1*29\r\n");
-            delay(250);
-        } else if (gnssModel == GNSS_MODEL_MTK_PA1616S) {
-            // PA1616S is used in some GPS breakout boards from Adafruit
-            // PA1616S does not have GLONASS capability. PA1616D does, but is not implemented here.
-            _serial_gps->write("$PMTK353,1,0,0,0,0*2A\r\n");
-            // Above command will reset the GPS and takes longer before it will accept new commands
-            delay(1000);
+            nmeaStep("$PMTK886,1*29\r\n", 250),
+        };
+    } else if (gnssModel == GNSS_MODEL_MTK_PA1616S) {
+        // PA1616S is used in some GPS breakout boards from Adafruit
+        // PA1616S does not have GLONASS capability. PA1616D does, but is not implemented here.
+        initSteps = {
+            // This will reset the GPS and takes longer before it will accept new commands
+            nmeaStep("$PMTK353,1,0,0,0,0*2A\r\n", 1000),
             // Only ask for RMC and GGA (GNRMC and GNGGA)
-            _serial_gps->write("$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*28\r\n");
-            delay(250);
+            nmeaStep("$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*28\r\n", 250),
             // Enable SBAS / WAAS
-            _serial_gps->write("$PMTK301,2*2E\r\n");
-            delay(250);
-        } else if (gnssModel == GNSS_MODEL_ATGM336H) {
+            nmeaStep("$PMTK301,2*2E\r\n", 250),
+        };
+    } else if (gnssModel == GNSS_MODEL_ATGM336H) {
+        initSteps = {
             // Set the intial configuration of the device - these _should_ work for most AT6558 devices
-            msglen = makeCASPacket(0x06, 0x07, sizeof(_message_CAS_CFG_NAVX_CONF), _message_CAS_CFG_NAVX_CONF);
-            _serial_gps->write(UBXscratch, msglen);
-            if (getACKCas(0x06, 0x07, 250) != GNSS_RESPONSE_OK) {
-                LOG_WARN("ATGM336H: Could not set Config");
-            }
-
+            CAS_STEP(0x06, 0x07, _message_CAS_CFG_NAVX_CONF, "set ATGM336H config", 250),
             // Set the update frequence to 1Hz
-            msglen = makeCASPacket(0x06, 0x04, sizeof(_message_CAS_CFG_RATE_1HZ), _message_CAS_CFG_RATE_1HZ);
-            _serial_gps->write(UBXscratch, msglen);
-            if (getACKCas(0x06, 0x04, 250) != GNSS_RESPONSE_OK) {
-                LOG_WARN("ATGM336H: Could not set Update Frequency");
-            }
-
-            // Set the NEMA output messages
-            // Ask for only RMC and GGA
-            uint8_t fields[] = {CAS_NEMA_RMC, CAS_NEMA_GGA};
-            for (unsigned int i = 0; i < sizeof(fields); i++) {
-                // Construct a CAS-CFG-MSG packet
-                uint8_t cas_cfg_msg_packet[] = {0x4e, fields[i], 0x01, 0x00};
-                msglen = makeCASPacket(0x06, 0x01, sizeof(cas_cfg_msg_packet), cas_cfg_msg_packet);
-                _serial_gps->write(UBXscratch, msglen);
-                if (getACKCas(0x06, 0x01, 250) != GNSS_RESPONSE_OK) {
-                    LOG_WARN("ATGM336H: Could not enable NMEA MSG: %d", fields[i]);
-                }
-            }
-        } else if (gnssModel == GNSS_MODEL_UC6580) {
-            // The Unicore UC6580 can use a lot of sat systems, enable it to
-            // use GPS L1 & L5 + BDS B1I & B2a + GLONASS L1 + GALILEO E1 & E5a + SBAS + QZSS
-            // This will reset the receiver, so wait a bit afterwards
-            // The paranoid will wait for the OK*04 confirmation response after each command.
-            _serial_gps->write("$CFGSYS,h35155\r\n");
-            delay(750);
+            CAS_STEP(0x06, 0x04, _message_CAS_CFG_RATE_1HZ, "set ATGM336H update frequency", 250),
+            // Set the NEMA output messages, ask for only RMC and GGA
+            CAS_STEP(0x06, 0x01, _message_CAS_CFG_MSG_RMC, "enable NMEA RMC", 250),
+            CAS_STEP(0x06, 0x01, _message_CAS_CFG_MSG_GGA, "enable NMEA GGA", 250),
+        };
+    } else if (gnssModel == GNSS_MODEL_UC6580) {
+        // The Unicore UC6580 can use a lot of sat systems, enable it to
+        // use GPS L1 & L5 + BDS B1I & B2a + GLONASS L1 + GALILEO E1 & E5a + SBAS + QZSS
+        // This will reset the receiver, so wait a bit afterwards
+        // The paranoid will wait for the OK*04 confirmation response after each command.
+        initSteps = {
+            nmeaStep("$CFGSYS,h35155\r\n", 750),
             // Must be done after the CFGSYS command
             // Turn off GSV messages, we don't really care about which and where the sats are, maybe someday.
-            _serial_gps->write("$CFGMSG,0,3,0\r\n");
-            delay(250);
+            nmeaStep("$CFGMSG,0,3,0\r\n", 250),
             // Turn off GSA messages, TinyGPS++ doesn't use this message.
-            _serial_gps->write("$CFGMSG,0,2,0\r\n");
-            delay(250);
+            nmeaStep("$CFGMSG,0,2,0\r\n", 250),
             // Turn off NOTICE __TXT messages, these may provide Unicore some info but we don't care.
-            _serial_gps->write("$CFGMSG,6,0,0\r\n");
-            delay(250);
-            _serial_gps->write("$CFGMSG,6,1,0\r\n");
-            delay(250);
-        } else if (IS_ONE_OF(gnssModel, GNSS_MODEL_AG3335, GNSS_MODEL_AG3352)) {
-
-            _serial_gps->write("$PAIR066,1,0,1,0,0,1*3B\r\n"); // Enable GPS+GALILEO+NAVIC
+            nmeaStep("$CFGMSG,6,0,0\r\n", 250),
+            nmeaStep("$CFGMSG,6,1,0\r\n", 250),
+        };
+    } else if (IS_ONE_OF(gnssModel, GNSS_MODEL_AG3335, GNSS_MODEL_AG3352)) {
+        initSteps = {
+            nmeaStep("$PAIR066,1,0,1,0,0,1*3B\r\n"), // Enable GPS+GALILEO+NAVIC
 
             // Configure NMEA (sentences will output once per fix)
-            _serial_gps->write("$PAIR062,0,1*3F\r\n"); // GGA ON
-            _serial_gps->write("$PAIR062,1,0*3F\r\n"); // GLL OFF
-            _serial_gps->write("$PAIR062,2,0*3C\r\n"); // GSA OFF
-            _serial_gps->write("$PAIR062,3,0*3D\r\n"); // GSV OFF
-            _serial_gps->write("$PAIR062,4,1*3B\r\n"); // RMC ON
-            _serial_gps->write("$PAIR062,5,0*3B\r\n"); // VTG OFF
-            _serial_gps->write("$PAIR062,6,0*38\r\n"); // ZDA ON
-
-            delay(250);
-            _serial_gps->write("$PAIR513*3D\r\n"); // save configuration
-        } else if (gnssModel == GNSS_MODEL_UBLOX6) {
-            clearBuffer();
-            SEND_UBX_PACKET(0x06, 0x02, _message_DISABLE_TXT_INFO, "disable text info messages", 500);
-            SEND_UBX_PACKET(0x06, 0x39, _message_JAM_6_7, "enable interference resistance", 500);
-            SEND_UBX_PACKET(0x06, 0x23, _message_NAVX5, "configure NAVX5 settings", 500);
+            nmeaStep("$PAIR062,0,1*3F\r\n"),      // GGA ON
+            nmeaStep("$PAIR062,1,0*3F\r\n"),      // GLL OFF
+            nmeaStep("$PAIR062,2,0*3C\r\n"),      // GSA OFF
+            nmeaStep("$PAIR062,3,0*3D\r\n"),      // GSV OFF
+            nmeaStep("$PAIR062,4,1*3B\r\n"),      // RMC ON
+            nmeaStep("$PAIR062,5,0*3B\r\n"),      // VTG OFF
+            nmeaStep("$PAIR062,6,0*38\r\n", 250), // ZDA ON
+
+            nmeaStep("$PAIR513*3D\r\n"), // save configuration
+        };
+    } else if (gnssModel == GNSS_MODEL_UBLOX6) {
+        initSteps = {
+            UBX_STEP(0x06, 0x02, _message_DISABLE_TXT_INFO, "disable text info messages", 500),
+            UBX_STEP(0x06, 0x39, _message_JAM_6_7, "enable interference resistance", 500),
+            UBX_STEP(0x06, 0x23, _message_NAVX5, "configure NAVX5 settings", 500),
 
             // Turn off unwanted NMEA messages, set update rate
-            SEND_UBX_PACKET(0x06, 0x08, _message_1HZ, "set GPS update rate", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_GLL, "disable NMEA GLL", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_GSA, "enable NMEA GSA", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_GSV, "disable NMEA GSV", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_VTG, "disable NMEA VTG", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_RMC, "enable NMEA RMC", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_GGA, "enable NMEA GGA", 500);
-
-            clearBuffer();
-            SEND_UBX_PACKET(0x06, 0x11, _message_CFG_RXM_ECO, "enable powersave ECO mode for Neo-6", 500);
-            SEND_UBX_PACKET(0x06, 0x3B, _message_CFG_PM2, "enable powersave details for GPS", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_AID, "disable UBX-AID", 500);
-
-            msglen = makeUBXPacket(0x06, 0x09, sizeof(_message_SAVE), _message_SAVE);
-            _serial_gps->write(UBXscratch, msglen);
-            if (getACK(0x06, 0x09, 2000) != GNSS_RESPONSE_OK) {
-                LOG_WARN("Unable to save GNSS module config");
-            } else {
-                LOG_INFO("GNSS module config saved!");
-            }
-        } else if (IS_ONE_OF(gnssModel, GNSS_MODEL_UBLOX7, GNSS_MODEL_UBLOX8, GNSS_MODEL_UBLOX9)) {
-            if (gnssModel == GNSS_MODEL_UBLOX7) {
-                LOG_DEBUG("Set GPS+SBAS");
-                msglen = makeUBXPacket(0x06, 0x3e, sizeof(_message_GNSS_7), _message_GNSS_7);
-                _serial_gps->write(UBXscratch, msglen);
-            } else { // 8,9
-                msglen = makeUBXPacket(0x06, 0x3e, sizeof(_message_GNSS_8), _message_GNSS_8);
-                _serial_gps->write(UBXscratch, msglen);
-            }
-
-            if (getACK(0x06, 0x3e, 800) == GNSS_RESPONSE_NAK) {
-                // It's not critical if the module doesn't acknowledge this configuration.
-                LOG_DEBUG("reconfigure GNSS - defaults maintained. Is this module GPS-only?");
-            } else {
-                if (gnssModel == GNSS_MODEL_UBLOX7) {
-                    LOG_INFO("GPS+SBAS configured");
-                } else { // 8,9
-                    LOG_INFO("GPS+SBAS+GLONASS+Galileo configured");
-                }
-                // Documentation say, we need wait atleast 0.5s after reconfiguration of GNSS module, before sending next
-                // commands for the M8 it tends to be more... 1 sec should be enough ;>)
-                delay(1000);
-            }
-
-            // Disable Text Info messages //6,7,8,9
-            clearBuffer();
-            SEND_UBX_PACKET(0x06, 0x02, _message_DISABLE_TXT_INFO, "disable text info messages", 500);
-
-            if (gnssModel == GNSS_MODEL_UBLOX8) { // 8
-                clearBuffer();
-                SEND_UBX_PACKET(0x06, 0x39, _message_JAM_8, "enable interference resistance", 500);
+            UBX_STEP(0x06, 0x08, _message_1HZ, "set GPS update rate", 500),
+            UBX_STEP(0x06, 0x01, _message_GLL, "disable NMEA GLL", 500),
+            UBX_STEP(0x06, 0x01, _message_GSA, "enable NMEA GSA", 500),
+            UBX_STEP(0x06, 0x01, _message_GSV, "disable NMEA GSV", 500),
+            UBX_STEP(0x06, 0x01, _message_VTG, "disable NMEA VTG", 500),
+            UBX_STEP(0x06, 0x01, _message_RMC, "enable NMEA RMC", 500),
+            UBX_STEP(0x06, 0x01, _message_GGA, "enable NMEA GGA", 500),
+
+            UBX_STEP(0x06, 0x11, _message_CFG_RXM_ECO, "enable powersave ECO mode for Neo-6", 500),
+            UBX_STEP(0x06, 0x3B, _message_CFG_PM2, "enable powersave details for GPS", 500),
+            UBX_STEP(0x06, 0x01, _message_AID, "disable UBX-AID", 500),
+
+            UBX_STEP(0x06, 0x09, _message_SAVE, "save GNSS module config", 2000),
+        };
+    } else if (IS_ONE_OF(gnssModel, GNSS_MODEL_UBLOX7, GNSS_MODEL_UBLOX8, GNSS_MODEL_UBLOX9)) {
+        // It's not critical if the module doesn't acknowledge the GNSS configuration, is this module GPS-only?
+        // Documentation say, we need wait atleast 0.5s after reconfiguration of GNSS module, before sending next
+        // commands for the M8 it tends to be more... 1 sec should be enough ;>)
+        if (gnssModel == GNSS_MODEL_UBLOX7) {
+            initSteps.push_back(UBX_STEP(0x06, 0x3e, _message_GNSS_7, "configure GPS+SBAS", 800, 1000, true));
+        } else { // 8,9
+            initSteps.push_back(UBX_STEP(0x06, 0x3e, _message_GNSS_8, "configure GPS+SBAS+GLONASS+Galileo", 800, 1000, true));
+        }
 
-                clearBuffer();
-                SEND_UBX_PACKET(0x06, 0x23, _message_NAVX5_8, "configure NAVX5_8 settings", 500);
-            } else { // 6,7,9
-                SEND_UBX_PACKET(0x06, 0x39, _message_JAM_6_7, "enable interference resistance", 500);
-                SEND_UBX_PACKET(0x06, 0x23, _message_NAVX5, "configure NAVX5 settings", 500);
-            }
-            // Turn off unwanted NMEA messages, set update rate
-            SEND_UBX_PACKET(0x06, 0x08, _message_1HZ, "set GPS update rate", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_GLL, "disable NMEA GLL", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_GSA, "enable NMEA GSA", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_GSV, "disable NMEA GSV", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_VTG, "disable NMEA VTG", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_RMC, "enable NMEA RMC", 500);
-            SEND_UBX_PACKET(0x06, 0x01, _message_GGA, "enable NMEA GGA", 500);
-
-            if (ublox_info.protocol_version >= 18) {
-                clearBuffer();
-                SEND_UBX_PACKET(0x06, 0x86, _message_PMS, "enable powersave for GPS", 500);
-                SEND_UBX_PACKET(0x06, 0x3B, _message_CFG_PM2, "enable powersave details for GPS", 500);
+        // Disable Text Info messages //6,7,8,9
+        initSteps.push_back(UBX_STEP(0x06, 0x02, _message_DISABLE_TXT_INFO, "disable text info messages", 500));
 
-                // For M8 we want to enable NMEA vserion 4.10 so we can see the additional sats.
-                if (gnssModel == GNSS_MODEL_UBLOX8) {
-                    clearBuffer();
-                    SEND_UBX_PACKET(0x06, 0x17, _message_NMEA, "enable NMEA 4.10", 500);
-                }
-            } else {
-                SEND_UBX_PACKET(0x06, 0x11, _message_CFG_RXM_PSM, "enable powersave mode for GPS", 500);
-                SEND_UBX_PACKET(0x06, 0x3B, _message_CFG_PM2, "enable powersave details for GPS", 500);
+        if (gnssModel == GNSS_MODEL_UBLOX8) { // 8
+            initSteps.push_back(UBX_STEP(0x06, 0x39, _message_JAM_8, "enable interference resistance", 500));
+            initSteps.push_back(UBX_STEP(0x06, 0x23, _message_NAVX5_8, "configure NAVX5_8 settings", 500));
+        } else { // 6,7,9
+            initSteps.push_back(UBX_STEP(0x06, 0x39, _message_JAM_6_7, "enable interference resistance", 500));
+            initSteps.push_back(UBX_STEP(0x06, 0x23, _message_NAVX5, "configure NAVX5 settings", 500));
+        }
+        // Turn off unwanted NMEA messages, set update rate
+        initSteps.push_back(UBX_STEP(0x06, 0x08, _message_1HZ, "set GPS update rate", 500));
+        initSteps.push_back(UBX_STEP(0x06, 0x01, _message_GLL, "disable NMEA GLL", 500));
+        initSteps.push_back(UBX_STEP(0x06, 0x01, _message_GSA, "enable NMEA GSA", 500));
+        initSteps.push_back(UBX_STEP(0x06, 0x01, _message_GSV, "disable NMEA GSV", 500));
+        initSteps.push_back(UBX_STEP(0x06, 0x01, _message_VTG, "disable NMEA VTG", 500));
+        initSteps.push_back(UBX_STEP(0x06, 0x01, _message_RMC, "enable NMEA RMC", 500));
+        initSteps.push_back(UBX_STEP(0x06, 0x01, _message_GGA, "enable NMEA GGA", 500));
+
+        if (ublox_info.protocol_version >= 18) {
+            initSteps.push_back(UBX_STEP(0x06, 0x86, _message_PMS, "enable powersave for GPS", 500));
+            initSteps.push_back(UBX_STEP(0x06, 0x3B, _message_CFG_PM2, "enable powersave details for GPS", 500));
+
+            // For M8 we want to enable NMEA vserion 4.10 so we can see the additional sats.
+            if (gnssModel == GNSS_MODEL_UBLOX8) {
+                initSteps.push_back(UBX_STEP(0x06, 0x17, _message_NMEA, "enable NMEA 4.10", 500));
             }
+        } else {
+            initSteps.push_back(UBX_STEP(0x06, 0x11, _message_CFG_RXM_PSM, "enable powersave mode for GPS", 500));
+            initSteps.push_back(UBX_STEP(0x06, 0x3B, _message_CFG_PM2, "enable powersave details for GPS", 500));
+        }
 
-            msglen = makeUBXPacket(0x06, 0x09, sizeof(_message_SAVE), _message_SAVE);
-            _serial_gps->write(UBXscratch, msglen);
-            if (getACK(0x06, 0x09, 2000) != GNSS_RESPONSE_OK) {
-                LOG_WARN("Unable to save GNSS module config");
-            } else {
-                LOG_INFO("GNSS module configuration saved!");
-            }
-        } else if (gnssModel == GNSS_MODEL_UBLOX10) {
-            delay(1000);
-            clearBuffer();
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_DISABLE_NMEA_RAM, "disable NMEA messages in M10 RAM", 300);
-            delay(750);
-            clearBuffer();
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_DISABLE_NMEA_BBR, "disable NMEA messages in M10 BBR", 300);
-            delay(750);
-            clearBuffer();
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_DISABLE_TXT_INFO_RAM, "disable Info messages for M10 GPS RAM", 300);
-            delay(750);
+        initSteps.push_back(UBX_STEP(0x06, 0x09, _message_SAVE, "save GNSS module config", 2000));
+    } else if (gnssModel == GNSS_MODEL_UBLOX10) {
+        initSteps = {
+            waitStep(1000),
+            UBX_STEP(0x06, 0x8A, _message_VALSET_DISABLE_NMEA_RAM, "disable NMEA messages in M10 RAM", 300, 750),
+            UBX_STEP(0x06, 0x8A, _message_VALSET_DISABLE_NMEA_BBR, "disable NMEA messages in M10 BBR", 300, 750),
+            UBX_STEP(0x06, 0x8A, _message_VALSET_DISABLE_TXT_INFO_RAM, "disable Info messages for M10 GPS RAM", 300, 750),
             // Next disable Info txt messages in BBR layer
-            clearBuffer();
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_DISABLE_TXT_INFO_BBR, "disable Info messages for M10 GPS BBR", 300);
-            delay(750);
+            UBX_STEP(0x06, 0x8A, _message_VALSET_DISABLE_TXT_INFO_BBR, "disable Info messages for M10 GPS BBR", 300, 750),
             // Do M10 configuration for Power Management.
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_PM_RAM, "enable powersave for M10 GPS RAM", 300);
-            delay(750);
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_PM_BBR, "enable powersave for M10 GPS BBR", 300);
-            delay(750);
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_ITFM_RAM, "enable jam detection M10 GPS RAM", 300);
-            delay(750);
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_ITFM_BBR, "enable jam detection M10 GPS BBR", 300);
-            delay(750);
+            UBX_STEP(0x06, 0x8A, _message_VALSET_PM_RAM, "enable powersave for M10 GPS RAM", 300, 750),
+            UBX_STEP(0x06, 0x8A, _message_VALSET_PM_BBR, "enable powersave for M10 GPS BBR", 300, 750),
+            UBX_STEP(0x06, 0x8A, _message_VALSET_ITFM_RAM, "enable jam detection M10 GPS RAM", 300, 750),
+            UBX_STEP(0x06, 0x8A, _message_VALSET_ITFM_BBR, "enable jam detection M10 GPS BBR", 300, 750),
             // Here is where the init commands should go to do further M10 initialization.
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_DISABLE_SBAS_RAM, "disable SBAS M10 GPS RAM", 300);
-            delay(750); // will cause a receiver restart so wait a bit
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_DISABLE_SBAS_BBR, "disable SBAS M10 GPS BBR", 300);
-            delay(750); // will cause a receiver restart so wait a bit
+            // Disabling SBAS will cause a receiver restart so wait a bit
+            UBX_STEP(0x06, 0x8A, _message_VALSET_DISABLE_SBAS_RAM, "disable SBAS M10 GPS RAM", 300, 750),
+            UBX_STEP(0x06, 0x8A, _message_VALSET_DISABLE_SBAS_BBR, "disable SBAS M10 GPS BBR", 300, 750),
 
             // Done with initialization, Now enable wanted NMEA messages in BBR layer so they will survive a periodic
             // sleep.
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_ENABLE_NMEA_BBR, "enable messages for M10 GPS BBR", 300);
-            delay(750);
+            UBX_STEP(0x06, 0x8A, _message_VALSET_ENABLE_NMEA_BBR, "enable messages for M10 GPS BBR", 300, 750),
             // Next enable wanted NMEA messages in RAM layer
-            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_ENABLE_NMEA_RAM, "enable messages for M10 GPS RAM", 500);
-            delay(750);
+            UBX_STEP(0x06, 0x8A, _message_VALSET_ENABLE_NMEA_RAM, "enable messages for M10 GPS RAM", 500, 750),
 
             // As the M10 has no flash, the best we can do to preserve the config is to set it in RAM and BBR.
             // BBR will survive a restart, and power off for a while, but modules with small backup
             // batteries or super caps will not retain the config for a long power off time.
-            msglen = makeUBXPacket(0x06, 0x09, sizeof(_message_SAVE_10), _message_SAVE_10);
-            _serial_gps->write(UBXscratch, msglen);
-            if (getACK(0x06, 0x09, 2000) != GNSS_RESPONSE_OK) {
-                LOG_WARN("Unable to save GNSS module config");
-            } else {
-                LOG_INFO("GNSS module configuration saved!");
+            UBX_STEP(0x06, 0x09, _message_SAVE_10, "save GNSS module config", 2000),
+        };
+    }
+}
+
+bool GPS::runInitStep()
+{
+    while (initStepIndex < initSteps.size()) {
+        const GPSInitStep &step = initSteps[initStepIndex];
+
+        switch (initStepState) {
+        case GPS_INIT_STEP_SEND: {
+            uint8_t msglen = 0;
+            if (step.type == GPS_STEP_UBX) {
+                msglen = makeUBXPacket(step.classId, step.msgId, step.payloadSize, step.payload);
+            } else if (step.type == GPS_STEP_CAS) {
+                msglen = makeCASPacket(step.classId, step.msgId, step.payloadSize, step.payload);
             }
+
+            if (msglen) {
+                clearBuffer();
+                resetACK();
+                _serial_gps->write(UBXscratch, msglen);
+            } else if (step.type == GPS_STEP_NMEA) {
+                _serial_gps->write(step.what);
+            }
+            initStepStartMs = millis();
+            initStepState = step.ackTimeoutMs ? GPS_INIT_STEP_WAIT_ACK : GPS_INIT_STEP_SETTLE;
+            break;
         }
-        didSerialInit = true;
-    }
 
-    notifyDeepSleepObserver.observe(&notifyDeepSleep);
+        case GPS_INIT_STEP_WAIT_ACK: {
+            GPS_RESPONSE response =
+                (step.type == GPS_STEP_CAS) ? pollACKCas(step.classId, step.msgId) : pollACK(step.classId, step.msgId);
+            if (response == GNSS_RESPONSE_NONE && Throttle::isWithinTimespanMs(initStepStartMs, step.ackTimeoutMs))
+                return false; // Let everybody else run while the chip answers
 
+            if (response == GNSS_RESPONSE_NAK && step.optional) {
+                LOG_DEBUG("%s rejected, defaults maintained", step.what);
+                initStepIndex++; // Nothing changed, so no need to let it settle
+                initStepState = GPS_INIT_STEP_SEND;
+                break;
+            }
+            if (response != GNSS_RESPONSE_OK) {
+                LOG_WARN(failMessage, step.what);
+                initStepFailures++;
+            }
+            initStepStartMs = millis();
+            initStepState = GPS_INIT_STEP_SETTLE;
+            break;
+        }
+
+        case GPS_INIT_STEP_SETTLE:
+            if (Throttle::isWithinTimespanMs(initStepStartMs, step.settleMs)) {
+                initWaitMs = step.settleMs - (millis() - initStepStartMs);
+                return false;
+            }
+            initStepIndex++;
+            initStepState = GPS_INIT_STEP_SEND;
+            break;
+        }
+    }
     return true;
 }
 
@@ -1011,7 +1126,7 @@ int32_t GPS::runOnce()
             return disable();
         }
         if (!setup())
-            return 2000; // Setup failed, re-run in two seconds
+            return initWaitMs; // Still probing or configuring, come back when the next step is due
 
         // We have now loaded our saved preferences from flash
         if (config.position.gps_mode != meshtastic_Config_PositionConfig_GpsMode_ENABLED) {
@@ -1024,6 +1139,7 @@ int32_t GPS::runOnce()
                 devicestate.did_gps_reset = true;
                 nodeDB->saveToDisk(SEGMENT_DEVICESTATE);
             }
+            logInitPhase("factory reset");
         }
         GPSInitFinished = true;
         publishUpdate();
@@ -1125,85 +1241,137 @@ int GPS::prepareDeepSleep(void *unused)
 static const char *PROBE_MESSAGE = "Trying %s (%s)...";
 static const char *DETECTED_MESSAGE = "%s detected, using %s Module";
 
-#define PROBE_SIMPLE(CHIP, TOWRITE, RESPONSE, DRIVER, TIMEOUT, ...)                                                              \
-    do {                                                                                                                         \
-        LOG_DEBUG(PROBE_MESSAGE, TOWRITE, CHIP);                                                                                 \
-        clearBuffer();                                                                                                           \
-        _serial_gps->write(TOWRITE "\r\n");                                                                                      \
-        if (getACK(RESPONSE, TIMEOUT) == GNSS_RESPONSE_OK) {                                                                     \
-            LOG_INFO(DETECTED_MESSAGE, CHIP, #DRIVER);                                                                           \
-            return DRIVER;                                                                                                       \
-        }                                                                                                                        \
-    } while (0)
-
-GnssModel_t GPS::probe(int serialSpeed)
-{
-#if defined(ARCH_NRF52) || defined(ARCH_PORTDUINO) || defined(ARCH_STM32WL)
-    _serial_gps->end();
-    _serial_gps->begin(serialSpeed);
-#elif defined(ARCH_RP2040)
-    _serial_gps->end();
-    _serial_gps->setFIFOSize(256);
-    _serial_gps->begin(serialSpeed);
-#else
-    if (_serial_gps->baudRate() != serialSpeed) {
-        LOG_DEBUG("Set Baud to %i", serialSpeed);
-        _serial_gps->updateBaudRate(serialSpeed);
-    }
-#endif
-
-    memset(&ublox_info, 0, sizeof(ublox_info));
-    uint8_t buffer[768] = {0};
-    delay(100);
+#define GPS_PROBE_TIMEOUT_MS 500
 
-    // Close all NMEA sentences, valid for L76K, ATGM336H (and likely other AT6558 devices)
-    _serial_gps->write("$PCAS03,0,0,0,0,0,0,0,0,0,0,,,0,0*02\r\n");
-    delay(20);
-    // Close NMEA sequences on Ublox
-    _serial_gps->write("$PUBX,40,GLL,0,0,0,0,0,0*5C\r\n");
-    _serial_gps->write("$PUBX,40,GSV,0,0,0,0,0,0*59\r\n");
-    _serial_gps->write("$PUBX,40,VTG,0,0,0,0,0,0*5E\r\n");
-    delay(20);
+#define NMEA_PROBE(CHIP, PREAMBLE, QUERY, RESPONSE, DRIVER) {CHIP, PREAMBLE, QUERY, RESPONSE, DRIVER, #DRIVER}
 
+/// Chips we recognize by an NMEA query, tried in this order at each baud rate (u-blox comes last)
+static const struct {
+    const char *chip;
+    const char *preamble; // Written once before the query, if set
+    const char *query;
+    const char *response;
+    GnssModel_t model;
+    const char *modelName;
+} nmeaProbes[] = {
     // Unicore UFirebirdII Series: UC6580, UM620, UM621, UM670A, UM680A, or UM681A
-    PROBE_SIMPLE("UC6580", "$PDTINFO", "UC6580", GNSS_MODEL_UC6580, 500);
-    PROBE_SIMPLE("UM600", "$PDTINFO", "UM600", GNSS_MODEL_UC6580, 500);
-    PROBE_SIMPLE("ATGM336H", "$PCAS06,1*1A", "$GPTXT,01,01,02,HW=ATGM336H", GNSS_MODEL_ATGM336H, 500);
+    NMEA_PROBE("UC6580", NULL, "$PDTINFO", "UC6580", GNSS_MODEL_UC6580),
+    NMEA_PROBE("UM600", NULL, "$PDTINFO", "UM600", GNSS_MODEL_UC6580),
+    NMEA_PROBE("ATGM336H", NULL, "$PCAS06,1*1A", "$GPTXT,01,01,02,HW=ATGM336H", GNSS_MODEL_ATGM336H),
     /* ATGM332D series (-11(GPS), -21(BDS), -31(GPS+BDS), -51(GPS+GLONASS), -71-0(GPS+BDS+GLONASS))
     based on AT6558 */
-    PROBE_SIMPLE("ATGM332D", "$PCAS06,1*1A", "$GPTXT,01,01,02,HW=ATGM332D", GNSS_MODEL_ATGM336H, 500);
+    NMEA_PROBE("ATGM332D", NULL, "$PCAS06,1*1A", "$GPTXT,01,01,02,HW=ATGM332D", GNSS_MODEL_ATGM336H),
 
-    /* Airoha (Mediatek) AG3335A/M/S, A3352Q, Quectel L89 2.0, SimCom SIM65M */
-    _serial_gps->write("$PAIR062,2,0*3C\r\n"); // GSA OFF to reduce volume
-    _serial_gps->write("$PAIR062,3,0*3D\r\n"); // GSV OFF to reduce volume
-    _serial_gps->write("$PAIR513*3D\r\n");     // save configuration
-    PROBE_SIMPLE("AG3335", "$PAIR021*39", "$PAIR021,AG3335", GNSS_MODEL_AG3335, 500);
-    PROBE_SIMPLE("AG3352", "$PAIR021*39", "$PAIR021,AG3352", GNSS_MODEL_AG3352, 500);
-    PROBE_SIMPLE("LC86", "$PQTMVERNO*58", "$PQTMVERNO,LC86", GNSS_MODEL_AG3352, 500);
+    /* Airoha (Mediatek) AG3335A/M/S, A3352Q, Quectel L89 2.0, SimCom SIM65M
+       GSA and GSV OFF to reduce volume, then save configuration */
+    NMEA_PROBE("AG3335", "$PAIR062,2,0*3C\r\n$PAIR062,3,0*3D\r\n$PAIR513*3D\r\n", "$PAIR021*39", "$PAIR021,AG3335",
+               GNSS_MODEL_AG3335),
+    NMEA_PROBE("AG3352", NULL, "$PAIR021*39", "$PAIR021,AG3352", GNSS_MODEL_AG3352),
+    NMEA_PROBE("LC86", NULL, "$PQTMVERNO*58", "$PQTMVERNO,LC86", GNSS_MODEL_AG3352),
 
-    PROBE_SIMPLE("L76K", "$PCAS06,0*1B", "$GPTXT,01,01,02,SW=", GNSS_MODEL_MTK, 500);
+    NMEA_PROBE("L76K", NULL, "$PCAS06,0*1B", "$GPTXT,01,01,02,SW=", GNSS_MODEL_MTK),
 
     // Close all NMEA sentences, valid for L76B MTK platform (Waveshare Pico GPS)
-    _serial_gps->write("$PMTK514,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*2E\r\n");
-    delay(20);
+    NMEA_PROBE("L76B", "$PMTK514,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*2E\r\n", "$PMTK605*31", "Quectel-L76B",
+               GNSS_MODEL_MTK_L76B),
+    NMEA_PROBE("PA1616S", NULL, "$PMTK605*31", "1616S", GNSS_MODEL_MTK_PA1616S),
+};
 
-    PROBE_SIMPLE("L76B", "$PMTK605*31", "Quectel-L76B", GNSS_MODEL_MTK_L76B, 500);
-    PROBE_SIMPLE("PA1616S", "$PMTK605*31", "1616S", GNSS_MODEL_MTK_PA1616S, 500);
+bool GPS::probe(int serialSpeed)
+{
+    while (true) {
+        switch (probeState) {
+        case GPS_PROBE_START:
+#if defined(ARCH_NRF52) || defined(ARCH_PORTDUINO) || defined(ARCH_STM32WL)
+            _serial_gps->end();
+            _serial_gps->begin(serialSpeed);
+#elif defined(ARCH_RP2040)
+            _serial_gps->end();
+            _serial_gps->setFIFOSize(256);
+            _serial_gps->begin(serialSpeed);
+#else
+            if (_serial_gps->baudRate() != serialSpeed) {
+                LOG_DEBUG("Set Baud to %i", serialSpeed);
+                _serial_gps->updateBaudRate(serialSpeed);
+            }
+#endif
+            memset(&ublox_info, 0, sizeof(ublox_info));
+            probeState = GPS_PROBE_QUIET;
+            initWaitMs = 100;
+            return false;
 
-    uint8_t cfg_rate[] = {0xB5, 0x62, 0x06, 0x08, 0x00, 0x00, 0x00, 0x00};
-    UBXChecksum(cfg_rate, sizeof(cfg_rate));
-    clearBuffer();
-    _serial_gps->write(cfg_rate, sizeof(cfg_rate));
-    // Check that the returned response class and message ID are correct
-    GPS_RESPONSE response = getACK(0x06, 0x08, 750);
-    if (response == GNSS_RESPONSE_NONE) {
-        LOG_WARN("No GNSS Module (baudrate %d)", serialSpeed);
-        return GNSS_MODEL_UNKNOWN;
-    } else if (response == GNSS_RESPONSE_FRAME_ERRORS) {
-        LOG_INFO("UBlox Frame Errors (baudrate %d)", serialSpeed);
+        case GPS_PROBE_QUIET:
+            // Close all NMEA sentences, valid for L76K, ATGM336H (and likely other AT6558 devices)
+            _serial_gps->write("$PCAS03,0,0,0,0,0,0,0,0,0,0,,,0,0*02\r\n");
+            // Close NMEA sequences on Ublox
+            _serial_gps->write("$PUBX,40,GLL,0,0,0,0,0,0*5C\r\n");
+            _serial_gps->write("$PUBX,40,GSV,0,0,0,0,0,0*59\r\n");
+            _serial_gps->write("$PUBX,40,VTG,0,0,0,0,0,0*5E\r\n");
+            probeIndex = 0;
+            probeState = GPS_PROBE_QUERY;
+            initWaitMs = 40;
+            return false;
+
+        case GPS_PROBE_QUERY:
+            if (nmeaProbes[probeIndex].preamble)
+                _serial_gps->write(nmeaProbes[probeIndex].preamble);
+            LOG_DEBUG(PROBE_MESSAGE, nmeaProbes[probeIndex].query, nmeaProbes[probeIndex].chip);
+            clearBuffer();
+            resetACK();
+            _serial_gps->write(nmeaProbes[probeIndex].query);
+            _serial_gps->write("\r\n");
+            initStepStartMs = millis();
+            probeState = GPS_PROBE_WAIT_NMEA;
+            return false;
+
+        case GPS_PROBE_WAIT_NMEA:
+            if (pollACK(nmeaProbes[probeIndex].response) == GNSS_RESPONSE_OK) {
+                LOG_INFO(DETECTED_MESSAGE, nmeaProbes[probeIndex].chip, nmeaProbes[probeIndex].modelName);
+                gnssModel = nmeaProbes[probeIndex].model;
+                probeState = GPS_PROBE_START;
+                return true;
+            }
+            if (Throttle::isWithinTimespanMs(initStepStartMs, GPS_PROBE_TIMEOUT_MS))
+                return false;
+            probeState = (++probeIndex < array_count(nmeaProbes)) ? GPS_PROBE_QUERY : GPS_PROBE_UBLOX;
+            break;
+
+        case GPS_PROBE_UBLOX: {
+            uint8_t cfg_rate[] = {0xB5, 0x62, 0x06, 0x08, 0x00, 0x00, 0x00, 0x00};
+            UBXChecksum(cfg_rate, sizeof(cfg_rate));
+            clearBuffer();
+            resetACK();
+            _serial_gps->write(cfg_rate, sizeof(cfg_rate));
+            initStepStartMs = millis();
+            probeState = GPS_PROBE_WAIT_UBLOX;
+            return false;
+        }
+
+        case GPS_PROBE_WAIT_UBLOX: {
+            // Check that the returned response class and message ID are correct
+            GPS_RESPONSE response = pollACK(0x06, 0x08);
+            if (response == GNSS_RESPONSE_NONE && Throttle::isWithinTimespanMs(initStepStartMs, 750))
+                return false;
+
+            probeState = GPS_PROBE_START;
+            if (response == GNSS_RESPONSE_NONE) {
+                LOG_WARN("No GNSS Module (baudrate %d)", serialSpeed);
+                gnssModel = GNSS_MODEL_UNKNOWN;
+            } else {
+                if (response == GNSS_RESPONSE_FRAME_ERRORS) {
+                    LOG_INFO("UBlox Frame Errors (baudrate %d)", serialSpeed);
+                }
+                gnssModel = probeUblox(serialSpeed);
+            }
+            return true;
+        }
+        }
     }
+}
 
-    memset(buffer, 0, sizeof(buffer));
+GnssModel_t GPS::probeUblox(int serialSpeed)
+{
+    uint8_t buffer[768] = {0};
     uint8_t _message_MONVER[8] = {
         0xB5, 0x62, // Sync message for UBX protocol
         0x0A, 0x04, // Message class and ID (UBX-MON-VER)
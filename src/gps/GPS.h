@@ -10,6 +10,7 @@
 #include "input/RotaryEncoderInterruptImpl1.h"
 #include "input/UpDownInterruptImpl1.h"
 #include "modules/PositionModule.h"
+#include <vector>
 
 // Allow defining the polarity of the ENABLE output.  default is active high
 #ifndef GPS_EN_ACTIVE
@@ -39,6 +40,27 @@ typedef enum {
     GNSS_RESPONSE_OK,
 } GPS_RESPONSE;
 
+/// Kinds of commands in the chip configuration sequence, see GPS::runInitStep()
+enum GPSInitStepType : uint8_t {
+    GPS_STEP_NMEA, // Write an NMEA sentence
+    GPS_STEP_UBX,  // Write a UBX packet and optionally wait for its UBX-ACK
+    GPS_STEP_CAS,  // Write a CAS packet and optionally wait for its CAS-ACK
+    GPS_STEP_WAIT  // Just give the chip some time
+};
+
+/// One command of the chip configuration sequence
+struct GPSInitStep {
+    GPSInitStepType type;
+    const char *what; // The sentence for GPS_STEP_NMEA, otherwise a description for the log
+    uint8_t classId;
+    uint8_t msgId;
+    const uint8_t *payload;
+    uint8_t payloadSize;
+    uint16_t ackTimeoutMs; // 0 if the chip doesn't answer this command
+    uint16_t settleMs;     // Time the chip needs before it accepts the next command
+    bool optional;         // Some modules NAK this, that's fine: no warning and no settle time
+};
+
 enum GPSPowerState : uint8_t {
     GPS_ACTIVE,    // Awake and want a position
     GPS_IDLE,      // Awake, but not wanting another position yet
@@ -70,7 +92,8 @@ class GPS : private concurrency::OSThread
     Observable<const meshtastic::GPSStatus *> newStatus;
 
     /**
-     * Returns true if we succeeded
+     * Advance probing and configuring the GPS by one step, without blocking.
+     * Returns true once we are done, otherwise runOnce() calls us again after initWaitMs.
      */
     virtual bool setup();
 
@@ -174,7 +197,38 @@ class GPS : private concurrency::OSThread
     bool hasGPS = false; // Do we have a GPS we are talking to
 
     bool GPSInitFinished = false; // Init thread finished?
-    bool GPSInitStarted = false;  // Init thread finished?
+    bool GPSInitStarted = false;  // Init thread started?
+
+    /// Where probe() is at for the current baud rate
+    enum GPSProbeState : uint8_t {
+        GPS_PROBE_START,      // Switch to the baud rate
+        GPS_PROBE_QUIET,      // Ask all known chips to stop their NMEA chatter
+        GPS_PROBE_QUERY,      // Send the query of nmeaProbes[probeIndex]
+        GPS_PROBE_WAIT_NMEA,  // Wait for its answer
+        GPS_PROBE_UBLOX,      // Send UBX-CFG-RATE
+        GPS_PROBE_WAIT_UBLOX, // Wait for a u-blox to acknowledge it
+    };
+
+    /// Where runInitStep() is at for initSteps[initStepIndex]
+    enum GPSInitStepState : uint8_t { GPS_INIT_STEP_SEND, GPS_INIT_STEP_WAIT_ACK, GPS_INIT_STEP_SETTLE };
+
+    GPSProbeState probeState = GPS_PROBE_START;
+    uint8_t probeIndex = 0;
+
+    std::vector<GPSInitStep> initSteps; // Chip specific configuration, queued once we know the model
+    size_t initStepIndex = 0;
+    GPSInitStepState initStepState = GPS_INIT_STEP_SEND;
+    uint8_t initStepFailures = 0;
+
+    uint32_t initStepStartMs = 0;  // When the current probe query or init command was sent
+    uint32_t initStartMs = 0;      // For the boot timing log
+    uint32_t initPhaseStartMs = 0; // For the boot timing log
+    int32_t initWaitMs = 0;        // How long runOnce() should wait before calling setup() again
+
+    // State of the pollACK() functions, so an answer can be matched across several runOnce() calls
+    uint8_t ackBuf[128] = {0};
+    uint16_t ackLen = 0;
+    uint8_t ackFrameErrors = 0;
 
     GPSPowerState powerState = GPS_OFF; // GPS_ACTIVE if we want a location right now
 
@@ -204,6 +258,23 @@ class GPS : private concurrency::OSThread
 
     GPS_RESPONSE getACKCas(uint8_t class_id, uint8_t msg_id, uint32_t waitMillis);
 
+    /** Non-blocking versions of getACK(), they only consume what the chip already sent us.
+     * Return GNSS_RESPONSE_NONE while the answer is still incomplete, call resetACK() before sending the command.
+     */
+    GPS_RESPONSE pollACK(uint8_t class_id, uint8_t msg_id);
+    GPS_RESPONSE pollACK(const char *message);
+    GPS_RESPONSE pollACKCas(uint8_t class_id, uint8_t msg_id);
+    void resetACK();
+
+    /// Fill initSteps with the configuration for gnssModel
+    void queueInitSteps();
+
+    /// Work on the queued configuration until we need to wait for the chip, returns true once all of it was sent
+    bool runInitStep();
+
+    /// Log how long the init phase that just finished took, and start timing the next one
+    void logInitPhase(const char *phase);
+
     /// Prepare the GPS for the cpu entering deep sleep, expect to be gone for at least 100s of msecs
     /// always returns 0 to indicate okay to sleep
     int prepareDeepSleep(void *unused);
@@ -231,8 +302,13 @@ class GPS : private concurrency::OSThread
 
     virtual int32_t runOnce() override;
 
-    // Get GNSS model
-    GnssModel_t probe(int serialSpeed);
+    /** Look for a GNSS chip at serialSpeed, one query at a time.
+     * Returns true once probing at this speed is finished, gnssModel then holds the result.
+     */
+    bool probe(int serialSpeed);
+
+    // Identify a u-blox that acknowledged our probe
+    GnssModel_t probeUblox(int serialSpeed);
 
     // delay counter to allow more sats before fixed position stops GPS thread
     uint8_t fixeddelayCtr = 0;
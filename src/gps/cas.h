@@ -35,6 +35,11 @@ static const uint8_t _message_CAS_CFG_RATE_1HZ[] = {
     0x00, 0x00  // Reserved
 };
 
+// CFG-MSG (0x06, 0x01)
+// Output a single NMEA sentence (class 0x4e) once per fix
+static const uint8_t _message_CAS_CFG_MSG_RMC[] = {0x4e, CAS_NEMA_RMC, 0x01, 0x00};
+static const uint8_t _message_CAS_CFG_MSG_GGA[] = {0x4e, CAS_NEMA_GGA, 0x01, 0x00};
+
 // CFG-NAVX (0x06, 0x07)
 // Initial ATGM33H-5N configuration, Updates for Dynamic Mode, Fix Mode, and SV system
 // Qwirk: The ATGM33H-5N-31 should only support GPS+BDS, however it will happily enable
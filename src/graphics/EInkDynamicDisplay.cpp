@@ -3,23 +3,36 @@
 
 #if defined(USE_EINK) && defined(USE_EINK_DYNAMICDISPLAY)
 #include "EInkDynamicDisplay.h"
+#include <algorithm>
 
 // Constructor
 EInkDynamicDisplay::EInkDynamicDisplay(uint8_t address, int sda, int scl, OLEDDISPLAY_GEOMETRY geometry, HW_I2C i2cBus)
     : EInkDisplay(address, sda, scl, geometry, i2cBus), NotifiedWorkerThread("EInkDynamicDisplay")
 {
+    // Split the image buffer into tiles, for tracking which parts of the image change
+    tilePagesTotal = std::min<uint16_t>((displayHeight + 7) / 8, displayBufferSize / displayWidth);
+    tileCols = (displayWidth + tileWidth - 1) / tileWidth;
+    tileCount = tileCols * ((tilePagesTotal + tilePages - 1) / tilePages);
+    tileHashes = new uint32_t[tileCount]();
+    previousTileHashes = new uint32_t[tileCount]();
+
     // If tracking ghost pixels, grab memory
 #ifdef EINK_LIMIT_GHOSTING_PX
     dirtyPixels = new uint8_t[EInkDisplay::displayBufferSize](); // Init with zeros
+    tileGhostPixels = new uint16_t[tileCount]();
 #endif
 }
 
 // Destructor
 EInkDynamicDisplay::~EInkDynamicDisplay()
 {
+    delete[] tileHashes;
+    delete[] previousTileHashes;
+
     // If we were tracking ghost pixels, free the memory
 #ifdef EINK_LIMIT_GHOSTING_PX
     delete[] dirtyPixels;
+    delete[] tileGhostPixels;
 #endif
 }
 
@@ -49,9 +62,17 @@ void EInkDynamicDisplay::configForFastRefresh()
 {
     // Variant-specific code can go here
 #if defined(PRIVATE_HW)
-#else
-    // Otherwise:
+#elif defined(EINK_FAST_REFRESH_FULL_WINDOW)
     adafruitDisplay->setPartialWindow(0, 0, adafruitDisplay->width(), adafruitDisplay->height());
+#else
+    // Otherwise: only the tiles which changed. GxEPD2 clips anything we draw outside this window, and sends less over SPI
+    // Demanded fast-refreshes (e.g. waking from deep sleep) redraw the whole panel, whatever we think is already shown
+    if (reason == FLAGGED_DEMAND_FAST)
+        adafruitDisplay->setPartialWindow(0, 0, adafruitDisplay->width(), adafruitDisplay->height());
+    else {
+        adafruitDisplay->setPartialWindow(windowX, windowY, windowW, windowH);
+        LOG_DEBUG("Fast-refresh window %hu,%hu %hux%hu", windowX, windowY, windowW, windowH);
+    }
 #endif
 }
 
@@ -69,8 +90,8 @@ void EInkDynamicDisplay::configForFullRefresh()
 // Run any relevant GxEPD2 code, so next update will use correct refresh type
 void EInkDynamicDisplay::applyRefreshMode()
 {
-    // Change from FULL to FAST
-    if (currentConfig == FULL && refresh == FAST) {
+    // Change from FULL to FAST, or move the partial window over the region this frame changes
+    if (refresh == FAST) {
         configForFastRefresh();
         currentConfig = FAST;
     }
@@ -367,15 +388,59 @@ void EInkDynamicDisplay::resetRateLimiting()
     previousRunMs = millis();
 }
 
-// Generate a hash of this frame, to compare against previous update
+// Hash this frame tile by tile, to compare against previous update, and find the region of the panel which changed
 void EInkDynamicDisplay::hashImage()
 {
     imageHash = 0;
 
-    // Sum all bytes of the image buffer together
-    for (uint16_t b = 0; b < (displayWidth / 8) * displayHeight; b++) {
-        imageHash ^= buffer[b] << b;
+    // Bounding box of the tiles which changed, in image buffer coordinates
+    uint16_t x0 = displayWidth, y0 = displayHeight, x1 = 0, y1 = 0;
+
+    for (uint16_t t = 0; t < tileCount; t++) {
+        tileHashes[t] = hashTile(t);
+        imageHash = (imageHash * 31) ^ tileHashes[t];
+
+        if (tileHashes[t] != previousTileHashes[t]) {
+            const uint16_t x = (t % tileCols) * tileWidth;
+            const uint16_t y = (t / tileCols) * tilePages * 8;
+            x0 = std::min(x0, x);
+            y0 = std::min(y0, y);
+            x1 = std::max<uint16_t>(x1, std::min<uint16_t>(displayWidth, x + tileWidth));
+            y1 = std::max<uint16_t>(y1, std::min<uint16_t>(displayHeight, y + tilePages * 8));
+        }
+    }
+
+    // Nothing changed (frame might still be redrawn, e.g. COSMETIC): the window is the whole panel
+    if (x1 == 0) {
+        x0 = y0 = 0;
+        x1 = displayWidth;
+        y1 = displayHeight;
     }
+
+    // EInkDisplay::forceDisplay() handles flip itself, so the window must be flipped to match
+    const bool flipped = config.display.flip_screen;
+    windowX = flipped ? displayWidth - x1 : x0;
+    windowY = flipped ? displayHeight - y1 : y0;
+    windowW = x1 - x0;
+    windowH = y1 - y0;
+}
+
+// Generate a hash of one tile of this frame (FNV-1a)
+uint32_t EInkDynamicDisplay::hashTile(uint16_t tile)
+{
+    const uint16_t x0 = (tile % tileCols) * tileWidth;
+    const uint16_t x1 = std::min<uint16_t>(displayWidth, x0 + tileWidth);
+    const uint16_t page0 = (tile / tileCols) * tilePages;
+    const uint16_t page1 = std::min<uint16_t>(tilePagesTotal, page0 + tilePages);
+
+    uint32_t hash = 2166136261UL;
+    for (uint16_t page = page0; page < page1; page++) {
+        for (uint16_t x = x0; x < x1; x++) {
+            hash ^= buffer[x + page * displayWidth];
+            hash *= 16777619UL;
+        }
+    }
+    return hash;
 }
 
 // Store the results of determineMode() for future use, and reset for next call
@@ -388,6 +453,7 @@ void EInkDynamicDisplay::storeAndReset()
     // Only store image hash if the display will update
     if (refresh != SKIPPED) {
         previousImageHash = imageHash;
+        memcpy(previousTileHashes, tileHashes, tileCount * sizeof(uint32_t));
     }
 
     frameFlags = BACKGROUND;
@@ -405,24 +471,33 @@ void EInkDynamicDisplay::countGhostPixels()
     // Start a new count
     ghostPixelCount = 0;
 
-    // Check new image, bit by bit, for any white pixels at locations marked "dirty"
-    for (uint16_t i = 0; i < displayBufferSize; i++) {
-        for (uint8_t bit = 0; bit < 7; bit++) {
-
-            const bool dirty = (dirtyPixels[i] >> bit) & 1;       // Has pixel location been drawn to since full-refresh?
-            const bool shouldBeBlank = !((buffer[i] >> bit) & 1); // Is pixel location white in the new image?
-
-            // If pixel is (or has been) black since last full-refresh, and now is white: ghosting
-            if (dirty && shouldBeBlank)
-                ghostPixelCount++;
-
-            // Update the dirty status for this pixel - will this location become a ghost if set white in future?
-            if (!dirty && !shouldBeBlank)
-                dirtyPixels[i] |= (1 << bit);
+    for (uint16_t t = 0; t < tileCount; t++) {
+        // Recount only the tiles which changed since the last update. Nothing new can have been drawn in the others
+        if (tileHashes[t] != previousTileHashes[t]) {
+            const uint16_t x0 = (t % tileCols) * tileWidth;
+            const uint16_t x1 = std::min<uint16_t>(displayWidth, x0 + tileWidth);
+            const uint16_t page0 = (t / tileCols) * tilePages;
+            const uint16_t page1 = std::min<uint16_t>(tilePagesTotal, page0 + tilePages);
+
+            uint16_t count = 0;
+            for (uint16_t page = page0; page < page1; page++) {
+                for (uint16_t x = x0; x < x1; x++) {
+                    const uint32_t i = x + page * displayWidth;
+
+                    // If pixel is (or has been) black since last full-refresh, and now is white: ghosting
+                    count += __builtin_popcount(dirtyPixels[i] & ~buffer[i]);
+
+                    // Mark the black pixels as dirty - these locations become ghosts if set white in future
+                    dirtyPixels[i] |= buffer[i];
+                }
+            }
+            tileGhostPixels[t] = count;
         }
+
+        ghostPixelCount += tileGhostPixels[t];
     }
 
-    LOG_DEBUG("ghostPixels=%hu, ", ghostPixelCount);
+    LOG_DEBUG("ghostPixels=%u, ", (unsigned)ghostPixelCount);
 }
 
 // Check if ghost pixel count exceeds the defined limit
@@ -447,6 +522,7 @@ void EInkDynamicDisplay::resetGhostPixelTracking()
 {
     // Copy the current frame into dirtyPixels[] from the display buffer
     memcpy(dirtyPixels, EInkDisplay::buffer, EInkDisplay::displayBufferSize);
+    memset(tileGhostPixels, 0, tileCount * sizeof(uint16_t));
 }
 #endif // EINK_LIMIT_GHOSTING_PX
 
@@ -69,7 +69,7 @@ class EInkDynamicDisplay : public EInkDisplay, protected concurrency::NotifiedWo
     const uint32_t intervalPollAsyncRefresh = 100;
 
     void onNotify(uint32_t notification) override; // Handle any async tasks - overrides NotifiedWorkerThread
-    void configForFastRefresh();                   // GxEPD2 code to set fast-refresh
+    void configForFastRefresh();                   // GxEPD2 code to set fast-refresh (of the changed region only)
     void configForFullRefresh();                   // GxEPD2 code to set full-refresh
     bool determineMode();                          // Assess situation, pick a refresh type
     void applyRefreshMode();                       // Run any relevant GxEPD2 code, so next update will use correct refresh type
@@ -87,9 +87,10 @@ class EInkDynamicDisplay : public EInkDisplay, protected concurrency::NotifiedWo
     void checkConsecutiveFastRefreshes(); // Too many fast-refreshes consecutively?
     void checkFastRequested();            // Was the flag set for RESPONSIVE, or only BACKGROUND?
 
-    void resetRateLimiting(); // Set previousRunMs - this now counts as an update, for rate-limiting
-    void hashImage();         // Generate a hashed version of this frame, to compare against previous update
-    void storeAndReset();     // Keep results of determineMode() for later, tidy-up for next call
+    void resetRateLimiting();         // Set previousRunMs - this now counts as an update, for rate-limiting
+    void hashImage();                 // Hash this frame tile by tile, and find the region which changed since previous update
+    uint32_t hashTile(uint16_t tile); // Generate a hashed version of one tile of this frame
+    void storeAndReset();             // Keep results of determineMode() for later, tidy-up for next call
 
     // What we are determining for this frame
     frameFlagTypes frameFlags = BACKGROUND; // Frame characteristics - determineMode() input
@@ -108,6 +109,20 @@ class EInkDynamicDisplay : public EInkDisplay, protected concurrency::NotifiedWo
     uint32_t fastRefreshCount = 0;     // How many fast-refreshes consecutively since last full refresh?
     refreshTypes currentConfig = FULL; // Which refresh type is GxEPD2 currently configured for
 
+    // Track changes tile by tile, so a fast-refresh only needs to cover the part of the panel which changed (e.g. the clock)
+    // Optional: -D EINK_FAST_REFRESH_FULL_WINDOW, if a panel misbehaves when fast-refreshing a partial window
+    static constexpr uint16_t tileWidth = 32; // Tile width, in px
+    static constexpr uint16_t tilePages = 4;  // Tile height, in 8px pages of the image buffer
+    uint16_t tilePagesTotal = 0;              // Height of the image buffer, in 8px pages
+    uint16_t tileCols = 0;                    // Number of tiles across the image
+    uint16_t tileCount = 0;                   // Number of tiles in the image
+    uint32_t *tileHashes;                     // Hash of each tile of this frame (dynamically allocated mem)
+    uint32_t *previousTileHashes;             // Hash of each tile at the previous update (dynamically allocated mem)
+    uint16_t windowX = 0;                     // Region of the panel covered by the changed tiles. Fast-refresh only this
+    uint16_t windowY = 0;
+    uint16_t windowW = 0;
+    uint16_t windowH = 0;
+
     // Optional - track ghosting, pixel by pixel
     // May 2024: no longer used by any display. Kept for possible future use.
 #ifdef EINK_LIMIT_GHOSTING_PX
@@ -115,6 +130,7 @@ class EInkDynamicDisplay : public EInkDisplay, protected concurrency::NotifiedWo
     void checkExcessiveGhosting();  // Check if ghosting exceeds defined limit
     void resetGhostPixelTracking(); // Clear the dirty pixels array. Call when full-refresh cleans the display.
     uint8_t *dirtyPixels;           // Any pixels that have been black since last full-refresh (dynamically allocated mem)
+    uint16_t *tileGhostPixels;      // Ghost pixels per tile, only recounted for tiles which changed (dynamically allocated mem)
     uint32_t ghostPixelCount = 0;   // Number of pixels with problematic ghosting. Retained here for LOG_DEBUG use
 #endif
 
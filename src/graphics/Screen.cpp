@@ -80,6 +80,10 @@ namespace graphics
 
 // A text message frame + debug frame + all the node infos
 FrameCallback *normalFrames;
+
+// Hashes everything a frame reads, see Screen::isFrameUpToDate(). Kept alongside normalFrames, NULL if always redrawn
+typedef uint32_t (*FrameVersionCallback)(OLEDDisplayUiState *state);
+static FrameVersionCallback *normalFrameVersions;
 static uint32_t targetFramerate = IDLE_FRAMERATE;
 
 uint32_t logo_timeout = 5000; // 4 seconds for EACH logo
@@ -1472,6 +1476,65 @@ static void drawNodeInfo(OLEDDisplay *display, OLEDDisplayUiState *state, int16_
     screen->drawColumns(display, x, y, fields);
 }
 
+// FNV-1a, for hashing what a frame shows into its version
+static uint32_t hashVersion(uint32_t version, const void *data, size_t len)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < len; i++)
+        version = (version ^ bytes[i]) * 16777619UL;
+    return version;
+}
+#define HASH_VERSION(version, field) hashVersion(version, &(field), sizeof(field))
+
+// Everything drawNodeInfo reads. Spares the distance and bearing math while the node frame is shown but nothing moved
+static uint32_t nodeInfoVersion(OLEDDisplayUiState *state)
+{
+    const meshtastic_NodeInfoLite *node = nodeDB->getMeshNodeByIndex(nodeIndex);
+    const meshtastic_NodeInfoLite *ourNode = nodeDB->getMeshNode(nodeDB->getNodeNum());
+    if (!node)
+        return 0;
+
+    char lastStr[20];
+    screen->getTimeAgoStr(sinceLastSeen(node), lastStr, sizeof(lastStr));
+    uint32_t version = hashVersion(2166136261UL, lastStr, strlen(lastStr));
+
+    version = HASH_VERSION(version, node->num);
+    version = HASH_VERSION(version, node->snr);
+    version = HASH_VERSION(version, node->hops_away);
+    version = HASH_VERSION(version, node->position.latitude_i);
+    version = HASH_VERSION(version, node->position.longitude_i);
+    if (ourNode) {
+        version = HASH_VERSION(version, ourNode->position.latitude_i);
+        version = HASH_VERSION(version, ourNode->position.longitude_i);
+    }
+    if (screen->hasHeading()) {
+        long heading = screen->getHeading();
+        version = HASH_VERSION(version, heading);
+    }
+    return version;
+}
+
+// Everything drawTextMessageFrame reads. The header shows seconds for the first minute, then minutes (or a timestamp)
+static uint32_t textMessageVersion(OLEDDisplayUiState *state)
+{
+    const meshtastic_MeshPacket &mp = devicestate.rx_text_message;
+    uint32_t seconds = sinceReceived(&mp);
+    uint32_t shownTime = seconds < 60 ? seconds : 60 + seconds / 60;
+
+    uint32_t version = HASH_VERSION(2166136261UL, mp.id);
+    return HASH_VERSION(version, shownTime);
+}
+
+// Frames which only show slow changing data get a version callback. Everything else (clock, debug info, modules) is live
+static FrameVersionCallback getFrameVersionCallback(FrameCallback frame)
+{
+    if (frame == drawNodeInfo)
+        return nodeInfoVersion;
+    if (frame == drawTextMessageFrame)
+        return textMessageVersion;
+    return NULL;
+}
+
 #if defined(ESP_PLATFORM) && defined(USE_ST7789)
 SPIClass SPI1(HSPI);
 #endif
@@ -1480,6 +1543,7 @@ Screen::Screen(ScanI2C::DeviceAddress address, meshtastic_Config_DisplayConfig_O
     : concurrency::OSThread("Screen"), address_found(address), model(screenType), geometry(geometry), cmdQueue(32)
 {
     graphics::normalFrames = new FrameCallback[MAX_NUM_NODES + NUM_EXTRA_FRAMES];
+    graphics::normalFrameVersions = new FrameVersionCallback[MAX_NUM_NODES + NUM_EXTRA_FRAMES];
 #if defined(USE_SH1106) || defined(USE_SH1107) || defined(USE_SH1107_128_64)
     dispdev = new SH1106Wire(address.address, -1, -1, geometry,
                              (address.port == ScanI2C::I2CPort::WIRE1) ? HW_I2C::I2C_TWO : HW_I2C::I2C_ONE);
@@ -1529,6 +1593,7 @@ Screen::Screen(ScanI2C::DeviceAddress address, meshtastic_Config_DisplayConfig_O
 Screen::~Screen()
 {
     delete[] graphics::normalFrames;
+    delete[] graphics::normalFrameVersions;
 }
 
 /**
@@ -1582,6 +1647,7 @@ void Screen::handleSetOn(bool on, FrameCallback einkScreensaver)
 #endif
 #endif
             enabled = true;
+            damageFrame();
             setInterval(0); // Draw ASAP
             runASAP = true;
         } else {
@@ -1868,7 +1934,13 @@ int32_t Screen::runOnce()
 
     // this must be before the frameState == FIXED check, because we always
     // want to draw at least one FIXED frame before doing forceDisplay
-    ui->update();
+    // Nothing to draw if the frame on screen already shows the latest data though
+    if (!isFrameUpToDate()) {
+        uint32_t lastUpdate = ui->getUiState()->lastUpdate;
+        ui->update();
+        if (ui->getUiState()->lastUpdate != lastUpdate)
+            markFrameDrawn();
+    }
 
     // Switch to a low framerate (to save CPU) when we are not in transition
     // but we should only call setTargetFPS when framestate changes, because
@@ -1907,6 +1979,29 @@ int32_t Screen::runOnce()
     return (1000 / targetFramerate);
 }
 
+bool Screen::isFrameUpToDate()
+{
+    OLEDDisplayUiState *state = ui->getUiState();
+
+    // Only for the normal frames while idle. Animations and redraw requests (setFastFramerate) always draw
+    if (!showingNormalScreen || state->frameState != FIXED || targetFramerate != IDLE_FRAMERATE)
+        return false;
+
+    FrameVersionCallback version = normalFrameVersions[state->currentFrame];
+    return version && drawnFrame == state->currentFrame && drawnDamageVersion == damageVersion &&
+           drawnFrameVersion == version(state);
+}
+
+void Screen::markFrameDrawn()
+{
+    OLEDDisplayUiState *state = ui->getUiState();
+    FrameVersionCallback version = showingNormalScreen ? normalFrameVersions[state->currentFrame] : NULL;
+
+    drawnFrame = state->frameState == FIXED ? state->currentFrame : -1; // Mid-transition, no single frame is on screen
+    drawnFrameVersion = version ? version(state) : 0;
+    drawnDamageVersion = damageVersion;
+}
+
 void Screen::drawDebugInfoTrampoline(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y)
 {
     Screen *screen2 = reinterpret_cast<Screen *>(state->userData);
@@ -2105,6 +2200,10 @@ void Screen::setFrames(FrameFocus focus)
     fsi.frameCount = numframes; // Total framecount is used to apply FOCUS_PRESERVE
     LOG_DEBUG("Finished build frames. numframes: %d", numframes);
 
+    for (size_t i = 0; i < numframes; i++)
+        normalFrameVersions[i] = getFrameVersionCallback(normalFrames[i]);
+    damageFrame();
+
     ui->setFrames(normalFrames, numframes);
     ui->enableAllIndicators();
 
@@ -2345,6 +2444,8 @@ void Screen::handleShowNextFrame()
 
 void Screen::setFastFramerate()
 {
+    damageFrame();
+
     // We are about to start a transition so speed up fps
     targetFramerate = SCREEN_TRANSITION_FRAMERATE;
 
@@ -2648,6 +2749,7 @@ void DebugInfo::drawFrameSettings(OLEDDisplay *display, OLEDDisplayUiState *stat
 int Screen::handleStatusUpdate(const meshtastic::Status *arg)
 {
     // LOG_DEBUG("Screen got status update %d", arg->getStatusType());
+    damageFrame(); // e.g. a node's name changed, which the frame versions don't cover
     switch (arg->getStatusType()) {
     case STATUS_TYPE_NODE:
         if (showingNormalScreen && nodeStatus->getLastNumTotal() != nodeStatus->getNumTotal()) {
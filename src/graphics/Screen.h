@@ -545,6 +545,20 @@ class Screen : public concurrency::OSThread
     /// Try to start drawing ASAP
     void setFastFramerate();
 
+    /**
+     * Damage tracking: some frames (node info, text message) have a version callback, which hashes everything the frame
+     * reads (its NodeDB entry, our GPS fix, the message, the "time ago" it shows). While the version of the frame on screen
+     * and our damage counter stay the same, the frame is not drawn again and the display is not flushed.
+     */
+    bool isFrameUpToDate();                 // Was the current frame already drawn, with the data it would show now?
+    void markFrameDrawn();                  // Remember what we just drew
+    void damageFrame() { damageVersion++; } // Something outside the frame version callbacks changed, draw again
+
+    uint32_t damageVersion = 0;      // Bumped on status updates, frameset changes and redraw requests
+    int16_t drawnFrame = -1;         // Frame (index) on screen, -1 if unknown
+    uint32_t drawnFrameVersion = 0;  // Version of that frame, when it was drawn
+    uint32_t drawnDamageVersion = 0; // damageVersion, when it was drawn
+
     // Sets frame up for immediate drawing
     void setFrameImmediateDraw(FrameCallback *drawFrames);
 
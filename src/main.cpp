@@ -3,9 +3,12 @@
 #if !MESHTASTIC_EXCLUDE_GPS
 #include "GPS.h"
 #endif
+#include "BootTimeline.h"
 #include "MeshRadio.h"
 #include "MeshService.h"
+#include "MeshTopology.h"
 #include "NodeDB.h"
+#include "PacketAggregator.h"
 #include "PowerFSM.h"
 #include "PowerMon.h"
 #include "ReliableRouter.h"
@@ -31,6 +34,7 @@
 #include "graphics/RAKled.h"
 #include "graphics/Screen.h"
 #include "main.h"
+#include "mesh/RadioTask.h"
 #include "mesh/generated/meshtastic/config.pb.h"
 #include "meshUtils.h"
 #include "modules/Modules.h"
@@ -91,6 +95,7 @@ NRF52Bluetooth *nrf52Bluetooth = nullptr;
 #include "linux/LinuxHardwareI2C.h"
 #include "mesh/raspihttp/PiWebServer.h"
 #include "platform/portduino/PortduinoGlue.h"
+#include "platform/portduino/ReceivePipeline.h"
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -214,6 +219,9 @@ static OSThread *powerFSMthread;
 static OSThread *ambientLightingThread;
 
 RadioInterface *rIf = NULL;
+#ifdef ARCH_PORTDUINO
+static RadioInterface *rIf2 = NULL; // A second radio, for gateways between two presets or frequency slots
+#endif
 
 /**
  * Some platforms (nrf52) might provide an alterate version that suppresses calling delay from sleep.
@@ -327,6 +335,7 @@ void setup()
     LOG_INFO("Wait for peripherals to stabilize");
     delay(PERIPHERAL_WARMUP_MS);
 #endif
+    bootTimeline.mark("Peripheral power");
 
 #ifdef BUTTON_PIN
 #ifdef ARCH_ESP32
@@ -352,6 +361,7 @@ void setup()
     ledPeriodic = new Periodic("Blink", ledBlinker);
 
     fsInit();
+    bootTimeline.mark("Filesystem");
 
 #if defined(_SEEED_XIAO_NRF52840_SENSE_H_)
 
@@ -425,11 +435,13 @@ void setup()
     power->setStatusHandler(powerStatus);
     powerStatus->observe(&power->newStatus);
     power->setup(); // Must be after status handler is installed, so that handler gets notified of the initial configuration
+    bootTimeline.mark("Power");
 
 #if !MESHTASTIC_EXCLUDE_I2C
     // We need to scan here to decide if we have a screen for nodeDB.init() and because power has been applied to
     // accessories
     auto i2cScanner = std::unique_ptr<ScanI2CTwoWire>(new ScanI2CTwoWire());
+    i2cScanner->loadCache();
 #if HAS_WIRE
     LOG_INFO("Scan for i2c devices");
 #endif
@@ -463,6 +475,8 @@ void setup()
     i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
 #endif
 
+    i2cScanner->saveCache();
+
     auto i2cCount = i2cScanner->countDevices();
     if (i2cCount == 0) {
         LOG_INFO("No I2C devices found");
@@ -601,6 +615,7 @@ void setup()
     scannerToSensorsMap(i2cScanner, ScanI2C::DeviceType::CGRADSENS, meshtastic_TelemetrySensorType_RADSENS);
 
     i2cScanner.reset();
+    bootTimeline.mark("I2C scan");
 #endif
 
 #ifdef HAS_SDCARD
@@ -631,12 +646,14 @@ void setup()
 #ifdef ARCH_RP2040
     rp2040Setup();
 #endif
+    bootTimeline.mark("Platform");
 
     initSPI(); // needed here before reading from littleFS
 
     // We do this as early as possible because this loads preferences from flash
     // but we need to do this after main cpu init (esp32setup), because we need the random seed set
     nodeDB = new NodeDB;
+    bootTimeline.mark("NodeDB");
 
     // If we're taking on the repeater role, use flood router and turn off 3V3_S rail because peripherals are not needed
     if (config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER) {
@@ -646,6 +663,10 @@ void setup()
 #endif
     } else
         router = new ReliableRouter();
+#ifdef ARCH_PORTDUINO
+    if (settingsMap[receive_workers] > 0)
+        receivePipeline = new ReceivePipeline(settingsMap[receive_workers]);
+#endif
 
 #if HAS_BUTTON || defined(ARCH_PORTDUINO)
     // Buttons. Moved here cause we need NodeDB to be initialized
@@ -719,6 +740,7 @@ void setup()
     LOG_DEBUG("SPI.begin(SCK=%d, MISO=%d, MOSI=%d, NSS=%d)", LORA_SCK, LORA_MISO, LORA_MOSI, LORA_CS);
     SPI.setFrequency(4000000);
 #endif
+    bootTimeline.mark("SPI");
 
     // Initialize the screen first so we can show the logo while we start up everything else.
     screen = new graphics::Screen(screen_found, screen_model, screen_geometry);
@@ -765,6 +787,8 @@ void setup()
 
 #endif
 
+    bootTimeline.mark("GPS");
+
     nodeStatus->observe(&nodeDB->newStatus);
 
 #ifdef HAS_I2S
@@ -774,8 +798,11 @@ void setup()
     service = new MeshService();
     service->init();
 
+    bootTimeline.mark("Mesh service");
+
     // Now that the mesh service is created, create any modules
     setupModules();
+    bootTimeline.mark("Modules");
 
 #ifdef LED_PIN
     // Turn LED off after boot, if heartbeat by config
@@ -806,6 +833,7 @@ void setup()
 #endif
 
     screen->print("Started...\n");
+    bootTimeline.mark("Screen");
 
 #ifdef PIN_PWR_DELAY_MS
     // This may be required to give the peripherals time to power up.
@@ -876,6 +904,38 @@ void setup()
         }
     }
 
+    // It shares the SPI bus and the RF switch and TCXO settings with the first one
+    if (rIf && (settingsStrings[lora2_module] == "sx1262" || settingsStrings[lora2_module] == "sx1268")) {
+        LOG_DEBUG("Activate second %s radio on SPI port %s", settingsStrings[lora2_module].c_str(),
+                  settingsStrings[spidev].c_str());
+        LockingArduinoHal *RadioLibHAL = new LockingArduinoHal(SPI, spiSettings);
+        if (settingsStrings[lora2_module] == "sx1268")
+            rIf2 = new SX1268Interface(RadioLibHAL, settingsMap[lora2_cs], settingsMap[lora2_irq], settingsMap[lora2_reset],
+                                       settingsMap[lora2_busy]);
+        else
+            rIf2 = new SX1262Interface(RadioLibHAL, settingsMap[lora2_cs], settingsMap[lora2_irq], settingsMap[lora2_reset],
+                                       settingsMap[lora2_busy]);
+
+        RadioModemOverrides overrides = {};
+        if (settingsMap[lora2_modem_preset] >= 0) {
+            overrides.has_modem_preset = true;
+            overrides.modem_preset = (meshtastic_Config_LoRaConfig_ModemPreset)settingsMap[lora2_modem_preset];
+        }
+        overrides.channel_num = settingsMap[lora2_channel_num];
+        overrides.override_frequency = settingsMap[lora2_frequency_khz] / 1000.0f;
+        rIf2->setModemOverrides(overrides);
+        rIf2->bridgeMode = (RadioBridgeMode)settingsMap[lora2_bridge];
+
+        if (!rIf2->init()) {
+            LOG_WARN("No second radio");
+            delete rIf2;
+            rIf2 = NULL;
+        } else {
+            LOG_INFO("Second radio init success");
+            rIf->bridgeMode = rIf2->bridgeMode; // Bridge both ways
+        }
+    }
+
 #elif defined(HW_SPI1_DEVICE)
     LockingArduinoHal *RadioLibHAL = new LockingArduinoHal(SPI1, spiSettings);
 #else // HW_SPI1_DEVICE
@@ -1065,10 +1125,13 @@ void setup()
         }
     }
 
+    bootTimeline.mark("Radio");
+
     lateInitVariant(); // Do board specific init (see extra_variants/README.md for documentation)
 
 #if !MESHTASTIC_EXCLUDE_MQTT
-    mqttInit();
+    // Nothing to talk to before the network is up anyway
+    bootTimeline.defer("MQTT", mqttInit);
 #endif
 
 #ifdef RF95_FAN_EN
@@ -1093,25 +1156,47 @@ void setup()
 
 #if defined(ARCH_ESP32) && !MESHTASTIC_EXCLUDE_WEBSERVER
     // Start web server thread.
-    webServerThread = new WebServerThread();
+    bootTimeline.defer("Web server", [] { webServerThread = new WebServerThread(); });
 #endif
 
 #ifdef ARCH_PORTDUINO
 #if __has_include(<ulfius.h>)
     if (settingsMap[webserverport] != -1) {
-        piwebServerThread = new PiWebServerThread();
+        bootTimeline.defer("Web server", [] { piwebServerThread = new PiWebServerThread(); });
     }
 #endif
     initApiServer(TCPPort);
 #endif
 
-    // Start airtime logger thread.
+    // Start airtime logger.
     airTime = new AirTime();
 
+#if MESH_TOPOLOGY_MAX_EDGES > 0
+    meshTopology = new MeshTopology();
+#endif
+
     if (!rIf)
         RECORD_CRITICALERROR(meshtastic_CriticalErrorCode_NO_RADIO);
     else {
         router->addInterface(rIf);
+#ifdef ARCH_PORTDUINO
+        if (rIf2)
+            router->addInterface(rIf2);
+#endif
+
+#if HAS_RADIO_TASK
+        // Opt-in: keep the radio on a core of its own, away from the UI and networking
+        if (RadioLibInterface::instance) {
+            radioTask = new RadioTask(USERPREFS_RADIO_TASK_CORE);
+            radioTask->adopt(RadioLibInterface::instance);
+            radioTask->start();
+        }
+#endif
+
+#ifdef USERPREFS_PACKET_AGGREGATION_WINDOW_MS
+        // Opt-in: let our small periodic packets share LoRa frames
+        packetAggregator = new PacketAggregator(USERPREFS_PACKET_AGGREGATION_WINDOW_MS);
+#endif
 
         // Log bit rate to debug output
         LOG_DEBUG("LoRA bitrate = %f bytes / sec", (float(meshtastic_Constants_DATA_PAYLOAD_LEN) /
@@ -1123,6 +1208,7 @@ void setup()
     PowerFSM_setup(); // we will transition to ON in a couple of seconds, FIXME, only do this for cold boots, not waking from SDS
     powerFSMthread = new PowerFSMThread();
     setCPUFast(false); // 80MHz is fine for our slow peripherals
+    bootTimeline.setupDone();
 }
 #endif
 uint32_t rebootAtMsec;   // If not zero we will reboot at this time (used to reboot shortly after the update completes)
@@ -1212,11 +1298,18 @@ void loop()
 
     service->loop();
 
+#if HAS_RADIO_TASK
+    // The radio task interrupts mainDelay when it has something for us
+    if (radioTask)
+        radioTask->forwardReceived();
+#endif
+
     long delayMsec = mainController.runOrDelay();
 
     // We want to sleep as long as possible here - because it saves power
     if (!runASAP && loopCanSleep()) {
-        mainDelay.delay(delayMsec);
+        bool interrupted = !mainDelay.delay(delayMsec);
+        concurrency::OSThread::noteWakeup(interrupted);
     }
 }
 #endif
\ No newline at end of file
@@ -72,6 +72,7 @@ meshtastic_Channel &Channels::fixupChannel(ChannelIndex chIndex)
     }
 
     hashes[chIndex] = generateHash(chIndex);
+    generation++;
 
     return ch;
 }
@@ -313,6 +314,7 @@ void Channels::setChannel(const meshtastic_Channel &c)
                 channelFile.channels[i].role = meshtastic_Channel_Role_SECONDARY;
 
     old = c; // slam in the new settings/role
+    generation++;
 }
 
 bool Channels::anyMqttEnabled()
@@ -394,6 +396,21 @@ bool Channels::decryptForHash(ChannelIndex chIndex, ChannelHash channelHash)
     }
 }
 
+uint8_t Channels::getKeysForHash(ChannelHash channelHash, ChannelIndex *chIndexes, CryptoKey *keys)
+{
+    uint8_t numKeys = 0;
+    for (ChannelIndex i = 0; i < getNumChannels(); i++) {
+        if (getHash(i) != channelHash)
+            continue;
+        CryptoKey key = getKey(i);
+        if (key.length < 0)
+            continue;
+        chIndexes[numKeys] = i;
+        keys[numKeys++] = key;
+    }
+    return numKeys;
+}
+
 /** Given a channel index setup crypto for encoding that channel (or the primary channel if that channel is unsecured)
  *
  * This method is called before encoding outbound packets
@@ -28,6 +28,9 @@ class Channels
     /// the precomputed hashes for each of our channels, or -1 for invalid
     int16_t hashes[MAX_NUM_CHANNELS] = {};
 
+    /// Bumped whenever any channel settings might have changed, lets callers cache things derived from the channel table
+    uint32_t generation = 1;
+
   public:
     Channels() {}
 
@@ -61,6 +64,10 @@ class Channels
 
     ChannelIndex getNumChannels() { return channelFile.channels_count; }
 
+    /** A counter that changes whenever channel settings might have changed.  Anything derived from the channel table (names,
+     * roles) can be cached until this changes. */
+    uint32_t getGeneration() const { return generation; }
+
     /// Called by NodeDB on initial boot when the radio config settings are unset.  Set a default single channel config.
     void initDefaults();
 
@@ -75,6 +82,14 @@ class Channels
      */
     bool decryptForHash(ChannelIndex chIndex, ChannelHash channelHash);
 
+    /** Find the keys of all channels with the given hash, for decoding inbound packets without touching the crypto engine
+     *
+     * @param chIndexes filled in with the matching channel indexes, room for MAX_NUM_CHANNELS
+     * @param keys filled in with their keys, room for MAX_NUM_CHANNELS
+     * @return the number of matching channels
+     */
+    uint8_t getKeysForHash(ChannelHash channelHash, ChannelIndex *chIndexes, CryptoKey *keys);
+
     /** Given a channel index setup crypto for encoding that channel (or the primary channel if that channel is unsecured)
      *
      * This method is called before encoding outbound packets
@@ -2,6 +2,7 @@
 #include "../userPrefs.h"
 #include "configuration.h"
 #include "mesh-pb-constants.h"
+#include "modules/Telemetry/TelemetryDeadband.h"
 
 FloodingRouter::FloodingRouter() {}
 
@@ -26,7 +27,7 @@ bool FloodingRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
         if (config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER &&
             config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER) {
             // cancel rebroadcast of this message *if* there was already one, unless we're a router/repeater!
-            if (Router::cancelSending(p->from, p->id))
+            if (cancelRelay(p->from, p->id, rxIface))
                 txRelayCanceled++;
         }
 
@@ -46,6 +47,36 @@ bool FloodingRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
     return Router::shouldFilterReceived(p);
 }
 
+bool FloodingRouter::shouldDropReceivedHeader(const PacketHeader &h, uint32_t airtimeMsec, RadioInterface *radio)
+{
+    if (wantsEveryFrame())
+        return false;
+    if (Router::shouldDropReceivedHeader(h, airtimeMsec, radio))
+        return true;
+
+    // Repeated reliable transmissions might still need a rebroadcast or an ACK from us, leave them to shouldFilterReceived()
+    uint8_t hopLimit = h.flags & PACKET_FLAGS_HOP_LIMIT_MASK;
+    uint8_t hopStart = (h.flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
+    if (hopStart > 0 && hopStart == hopLimit)
+        return false;
+
+    // Only look, a new packet gets its record when shouldFilterReceived() sees it
+    if (!wasSeenRecently(h.from, h.id, false))
+        return false;
+    wasSeenRecently(h.from, h.id); // Refresh the record, as shouldFilterReceived() would have
+
+    LOG_DEBUG("Ignore dupe incoming frame fr=0x%x,id=0x%x before decoding", h.from, h.id);
+    rxDupe++;
+    rxEarlyDupe++;
+    if (config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER &&
+        config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER) {
+        // cancel rebroadcast of this message *if* there was already one, unless we're a router/repeater!
+        if (cancelRelay(h.from, h.id, radio))
+            txRelayCanceled++;
+    }
+    return true;
+}
+
 bool FloodingRouter::isRebroadcaster()
 {
     return config.device.role != meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE &&
@@ -58,6 +89,8 @@ bool FloodingRouter::perhapsRebroadcast(const meshtastic_MeshPacket *p)
         if (p->id != 0) {
             if (isRebroadcaster()) {
                 meshtastic_MeshPacket *tosend = packetPool.allocCopy(*p); // keep a copy because we will be sending it
+                telemetryDeltaCache.restoreForRelay(tosend);             // pass on the compact report, not what we made of it
+                restoreCompressedForRelay(tosend);                        // likewise compressed text
 
                 tosend->hop_limit--; // bump down the hop count
 #if USERPREFS_EVENT_MODE
@@ -49,6 +49,11 @@ class FloodingRouter : public Router, protected PacketHistory
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
+    /**
+     * Also drop duplicates we recognize from the raw header, with the same bookkeeping as shouldFilterReceived()
+     */
+    virtual bool shouldDropReceivedHeader(const PacketHeader &h, uint32_t airtimeMsec, RadioInterface *radio) override;
+
   protected:
     /**
      * Should this incoming filter be dropped?
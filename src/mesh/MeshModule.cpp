@@ -7,6 +7,9 @@
 #include <assert.h>
 
 std::vector<MeshModule *> *MeshModule::modules;
+std::unordered_map<uint32_t, std::vector<MeshModule *>> *MeshModule::portModules;
+std::vector<MeshModule *> *MeshModule::anyPortModules;
+bool MeshModule::dispatchTableDirty = true;
 
 const meshtastic_MeshPacket *MeshModule::currentRequest;
 
@@ -23,6 +26,7 @@ MeshModule::MeshModule(const char *_name) : name(_name)
         modules = new std::vector<MeshModule *>();
 
     modules->push_back(this);
+    dispatchTableDirty = true;
 }
 
 void MeshModule::setup() {}
@@ -72,11 +76,55 @@ meshtastic_MeshPacket *MeshModule::allocErrorResponse(meshtastic_Routing_Error e
     return r;
 }
 
+void MeshModule::buildDispatchTable()
+{
+    if (!portModules)
+        portModules = new std::unordered_map<uint32_t, std::vector<MeshModule *>>();
+    if (!anyPortModules)
+        anyPortModules = new std::vector<MeshModule *>();
+
+    portModules->clear();
+    anyPortModules->clear();
+    for (size_t i = 0; i < modules->size(); i++) {
+        MeshModule *pi = (*modules)[i];
+        pi->registrationOrder = i;
+
+        meshtastic_PortNum portNum = pi->getDispatchPortNum();
+        if (portNum == meshtastic_PortNum_UNKNOWN_APP)
+            anyPortModules->push_back(pi);
+        else
+            (*portModules)[portNum].push_back(pi);
+    }
+    dispatchTableDirty = false;
+
+    LOG_DEBUG("Module dispatch table built, %u portnums, %u modules see every packet", (unsigned)portModules->size(),
+              (unsigned)anyPortModules->size());
+}
+
+bool MeshModule::isBoundChannel(ChannelIndex chIndex)
+{
+    // Only compare channel names again if the channel table has changed since we last looked
+    if (boundChannelGeneration != channels.getGeneration()) {
+        boundChannelMask = 0;
+        for (ChannelIndex i = 0; i < channels.getNumChannels() && i < 32; i++)
+            if (strcasecmp(channels.getByIndex(i).settings.name, boundChannel) == 0)
+                boundChannelMask |= (1UL << i);
+        boundChannelGeneration = channels.getGeneration();
+    }
+
+    return chIndex < 32 && (boundChannelMask & (1UL << chIndex));
+}
+
 void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
 {
     // LOG_DEBUG("In call modules");
     bool moduleFound = false;
 
+    if (!modules)
+        return;
+    if (dispatchTableDirty)
+        buildDispatchTable();
+
     // We now allow **encrypted** packets to pass through the modules
     bool isDecoded = mp.which_payload_variant == meshtastic_MeshPacket_decoded_tag;
 
@@ -88,8 +136,22 @@ void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
     auto ourNodeNum = nodeDB->getNodeNum();
     bool toUs = isBroadcast(mp.to) || isToUs(&mp);
 
-    for (auto i = modules->begin(); i != modules->end(); ++i) {
-        auto &pi = **i;
+    // Only modules registered for this portnum and modules that see every portnum are candidates.  We can't know the portnum
+    // of encrypted packets, so only the latter are considered for those.
+    static const std::vector<MeshModule *> noModules;
+    const std::vector<MeshModule *> *forPort = &noModules;
+    if (isDecoded) {
+        auto found = portModules->find(mp.decoded.portnum);
+        if (found != portModules->end())
+            forPort = &found->second;
+    }
+
+    // Merge both lists so modules are still called in the order they were registered
+    auto p = forPort->begin();
+    auto a = anyPortModules->begin();
+    while (p != forPort->end() || a != anyPortModules->end()) {
+        bool takePort = a == anyPortModules->end() || (p != forPort->end() && (*p)->registrationOrder < (*a)->registrationOrder);
+        auto &pi = takePort ? **p++ : **a++;
 
         pi.currentRequest = &mp;
 
@@ -108,16 +170,13 @@ void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
 
             moduleFound = true;
 
-            /// received channel (or NULL if not decoded)
-            meshtastic_Channel *ch = isDecoded ? &channels.getByIndex(mp.channel) : NULL;
-
             /// Is the channel this packet arrived on acceptable? (security check)
             /// Note: we can't know channel names for encrypted packets, so those are NEVER sent to boundChannel modules
 
             /// Also: if a packet comes in on the local PC interface, we don't check for bound channels, because it is TRUSTED and
             /// it needs to to be able to fetch the initial admin packets without yet knowing any channels.
 
-            bool rxChannelOk = !pi.boundChannel || (mp.from == 0) || (ch && strcasecmp(ch->settings.name, pi.boundChannel) == 0);
+            bool rxChannelOk = !pi.boundChannel || (mp.from == 0) || (isDecoded && pi.isBoundChannel(mp.channel));
 
             if (!rxChannelOk) {
                 // no one should have already replied!
@@ -2,6 +2,7 @@
 
 #include "mesh/Channels.h"
 #include "mesh/MeshTypes.h"
+#include <unordered_map>
 #include <vector>
 
 #if HAS_SCREEN
@@ -60,6 +61,29 @@ class MeshModule
 {
     static std::vector<MeshModule *> *modules;
 
+    /** Dispatch table used by callModules, built lazily from 'modules' (we can't ask for getDispatchPortNum() from our
+     * constructor because subclasses are not constructed yet). Each list is kept in registration order.
+     */
+    static std::unordered_map<uint32_t, std::vector<MeshModule *>> *portModules;
+
+    /// Modules that must be asked about every packet (they want several portnums or decide at runtime)
+    static std::vector<MeshModule *> *anyPortModules;
+
+    /// Set whenever a module is registered, so the dispatch table gets rebuilt before the next packet
+    static bool dispatchTableDirty;
+
+    static void buildDispatchTable();
+
+    /// Our position in 'modules', used to merge the port specific and any port lists back into registration order
+    size_t registrationOrder = 0;
+
+    /// Bitmask of channel indexes whose name matches boundChannel, valid while boundChannelGeneration is current
+    uint32_t boundChannelMask = 0;
+    uint32_t boundChannelGeneration = 0;
+
+    /// @return true if a packet that arrived on the specified channel index is acceptable for our boundChannel
+    bool isBoundChannel(ChannelIndex chIndex);
+
   public:
     /** Constructor
      * name is for debugging output
@@ -135,6 +159,13 @@ class MeshModule
      */
     virtual bool wantPacket(const meshtastic_MeshPacket *p) = 0;
 
+    /**
+     * The only portnum this module can possibly want, used to build the callModules dispatch table.  Return
+     * meshtastic_PortNum_UNKNOWN_APP (the default) if wantPacket() might accept more than one portnum, then wantPacket() will
+     * be asked about every packet.  Note: this is only read once, after all modules have been constructed.
+     */
+    virtual meshtastic_PortNum getDispatchPortNum() { return meshtastic_PortNum_UNKNOWN_APP; }
+
     /** Called to handle a particular incoming message
 
     @return ProcessMessage::STOP if you've guaranteed you've handled this message and no other handlers should be considered for
@@ -0,0 +1,235 @@
+#include "MeshTopology.h"
+#include "NodeDB.h"
+#include "concurrency/LockGuard.h"
+#include "configuration.h"
+#include <algorithm>
+
+MeshTopology *meshTopology;
+
+// Same 1/4 dB encoding as RouteDiscovery uses for its SNR lists
+static int8_t encodeSnr(float snr)
+{
+    return (int8_t)std::max(-127.0f, std::min(127.0f, snr * 4));
+}
+
+// Orders links by how long ago we last heard about them, which unlike lastHeardMs itself survives millis() wrapping
+struct NewestFirst {
+    uint32_t now;
+    bool operator()(const MeshTopologyEdge &a, const MeshTopologyEdge &b) const
+    {
+        return now - a.lastHeardMs < now - b.lastHeardMs;
+    }
+};
+
+MeshTopology::MeshTopology()
+{
+    edges.reserve(MESH_TOPOLOGY_MAX_EDGES);
+    LOG_INFO("Mesh topology tracking enabled, max %u links", MESH_TOPOLOGY_MAX_EDGES);
+}
+
+void MeshTopology::addDirect(NodeNum from, float snr)
+{
+    concurrency::LockGuard guard(&lock);
+    addEdge(from, nodeDB->getNodeNum(), encodeSnr(snr), TOPOLOGY_SOURCE_DIRECT);
+}
+
+void MeshTopology::addNeighborInfo(const meshtastic_NeighborInfo *np)
+{
+    concurrency::LockGuard guard(&lock);
+    if (!np->node_id)
+        return;
+
+    for (pb_size_t i = 0; i < np->neighbors_count; i++)
+        addEdge(np->neighbors[i].node_id, np->node_id, encodeSnr(np->neighbors[i].snr), TOPOLOGY_SOURCE_NEIGHBORINFO);
+}
+
+void MeshTopology::addRoute(const meshtastic_MeshPacket &mp, const meshtastic_RouteDiscovery *r)
+{
+    concurrency::LockGuard guard(&lock);
+    NodeNum from = getFrom(&mp);
+    if (!mp.decoded.request_id) {
+        // A request still on its way, the destination only adds its SNR once it arrives
+        addRouteHops(from, r->route, r->route_count, r->snr_towards, r->snr_towards_count,
+                     r->snr_towards_count > r->route_count ? mp.to : 0);
+    } else {
+        // A reply carries the complete route towards the destination (the sender of the reply) and the route back so far
+        addRouteHops(mp.to, r->route, r->route_count, r->snr_towards, r->snr_towards_count,
+                     r->snr_towards_count > r->route_count ? from : 0);
+        addRouteHops(from, r->route_back, r->route_back_count, r->snr_back, r->snr_back_count,
+                     r->snr_back_count > r->route_back_count ? mp.to : 0);
+    }
+}
+
+void MeshTopology::addRouteHops(NodeNum first, const uint32_t *route, pb_size_t count, const int8_t *snrs, pb_size_t snrCount,
+                                NodeNum last)
+{
+    NodeNum prev = first;
+    for (pb_size_t i = 0; i <= count; i++) {
+        NodeNum next = i < count ? route[i] : last;
+        if (!next)
+            break;
+
+        // snrs[i] is the SNR at which the i-th hop heard the one before it, hops that couldn't decrypt break the chain
+        if (prev != NODENUM_BROADCAST && next != NODENUM_BROADCAST && prev != next)
+            addEdge(prev, next, i < snrCount ? snrs[i] : MESH_TOPOLOGY_SNR_UNKNOWN, TOPOLOGY_SOURCE_TRACEROUTE);
+        prev = next;
+    }
+}
+
+void MeshTopology::addEdge(NodeNum from, NodeNum to, int8_t snr, uint8_t source)
+{
+    if (!from || !to || from == to)
+        return;
+
+    generation++;
+
+    for (auto &e : edges) {
+        if (e.from == from && e.to == to) {
+            e.lastHeardMs = millis();
+            e.sources |= source;
+            if (snr != MESH_TOPOLOGY_SNR_UNKNOWN)
+                e.snr = snr;
+            return;
+        }
+    }
+
+    if (edges.size() >= MESH_TOPOLOGY_MAX_EDGES)
+        expireEdges();
+    if (edges.size() >= MESH_TOPOLOGY_MAX_EDGES) {
+        auto oldest = std::max_element(edges.begin(), edges.end(), NewestFirst{millis()});
+        LOG_DEBUG("Topology is full, forget link 0x%x -> 0x%x", oldest->from, oldest->to);
+        edges.erase(oldest);
+    }
+
+    MeshTopologyEdge e = {from, to, millis(), snr, source};
+    edges.push_back(e);
+}
+
+void MeshTopology::expireEdges()
+{
+    uint32_t now = millis();
+    size_t oldSize = edges.size();
+    edges.erase(std::remove_if(edges.begin(), edges.end(),
+                               [now](const MeshTopologyEdge &e) { return now - e.lastHeardMs > MESH_TOPOLOGY_EDGE_MAX_AGE_MS; }),
+                edges.end());
+    if (edges.size() != oldSize) {
+        LOG_DEBUG("Topology aged out %u links", (unsigned)(oldSize - edges.size()));
+        generation++;
+    }
+}
+
+size_t MeshTopology::getEdges(NodeNum n, bool isFrom, MeshTopologyEdge *out, size_t maxOut)
+{
+    concurrency::LockGuard guard(&lock);
+    expireEdges();
+
+    std::vector<MeshTopologyEdge> found;
+    for (const auto &e : edges) {
+        if ((isFrom ? e.from : e.to) == n)
+            found.push_back(e);
+    }
+    std::sort(found.begin(), found.end(), NewestFirst{millis()});
+
+    size_t numOut = std::min(found.size(), maxOut);
+    std::copy(found.begin(), found.begin() + numOut, out);
+    return numOut;
+}
+
+size_t MeshTopology::getAllEdges(MeshTopologyEdge *out, size_t maxOut)
+{
+    concurrency::LockGuard guard(&lock);
+    expireEdges();
+
+    std::vector<MeshTopologyEdge> sorted(edges);
+    std::sort(sorted.begin(), sorted.end(), NewestFirst{millis()});
+
+    size_t numOut = std::min(sorted.size(), maxOut);
+    std::copy(sorted.begin(), sorted.begin() + numOut, out);
+    return numOut;
+}
+
+size_t MeshTopology::getShortestPath(NodeNum from, NodeNum to, NodeNum *path, size_t maxPath)
+{
+    concurrency::LockGuard guard(&lock);
+    expireEdges();
+
+    std::vector<NodeNum> nodes;
+    nodes.reserve(edges.size() * 2);
+    for (const auto &e : edges) {
+        nodes.push_back(e.from);
+        nodes.push_back(e.to);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+    auto indexOf = [&nodes](NodeNum n) -> int {
+        auto it = std::lower_bound(nodes.begin(), nodes.end(), n);
+        return (it != nodes.end() && *it == n) ? it - nodes.begin() : -1;
+    };
+    int src = indexOf(from), dst = indexOf(to);
+    if (src < 0 || dst < 0 || maxPath == 0)
+        return 0;
+
+    // Plain Dijkstra, a hop costs 16 plus one if we have only seen the link the other way around
+    const uint32_t unreached = UINT32_MAX;
+    std::vector<uint32_t> cost(nodes.size(), unreached);
+    std::vector<int> prev(nodes.size(), -1);
+    std::vector<bool> done(nodes.size(), false);
+    cost[src] = 0;
+
+    while (true) {
+        int u = -1;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (!done[i] && cost[i] != unreached && (u < 0 || cost[i] < cost[u]))
+                u = i;
+        }
+        if (u < 0 || u == dst)
+            break;
+        done[u] = true;
+
+        for (const auto &e : edges) {
+            int v;
+            uint32_t hopCost;
+            if (e.from == nodes[u]) {
+                v = indexOf(e.to);
+                hopCost = 16;
+            } else if (e.to == nodes[u]) {
+                v = indexOf(e.from);
+                hopCost = 17;
+            } else {
+                continue;
+            }
+            if (!done[v] && cost[u] + hopCost < cost[v]) {
+                cost[v] = cost[u] + hopCost;
+                prev[v] = u;
+            }
+        }
+    }
+    if (cost[dst] == unreached)
+        return 0;
+
+    size_t numNodes = 0;
+    for (int i = dst; i >= 0; i = prev[i])
+        numNodes++;
+    if (numNodes > maxPath)
+        return 0;
+
+    size_t pos = numNodes;
+    for (int i = dst; i >= 0; i = prev[i])
+        path[--pos] = nodes[i];
+    return numNodes;
+}
+
+size_t MeshTopology::getNumEdges()
+{
+    concurrency::LockGuard guard(&lock);
+    expireEdges();
+    return edges.size();
+}
+
+void MeshTopology::clear()
+{
+    concurrency::LockGuard guard(&lock);
+    edges.clear();
+    generation++;
+}
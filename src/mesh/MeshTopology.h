@@ -0,0 +1,98 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "concurrency/Lock.h"
+#include <vector>
+
+/// Max number of links we keep track of, the oldest link is forgotten when full
+#ifndef MESH_TOPOLOGY_MAX_EDGES
+#if ARCH_PORTDUINO
+#define MESH_TOPOLOGY_MAX_EDGES 1024
+#elif defined(ARCH_ESP32)
+#define MESH_TOPOLOGY_MAX_EDGES 256
+#else
+#define MESH_TOPOLOGY_MAX_EDGES 0 // No RAM to spare, topology tracking is off
+#endif
+#endif
+
+/// Links we haven't heard about in this long are gone, twice the default NeighborInfo broadcast interval
+#define MESH_TOPOLOGY_EDGE_MAX_AGE_MS (12 * 60 * 60 * 1000UL)
+
+/// Value of MeshTopologyEdge.snr when we don't know it, same as an unknown SNR in a RouteDiscovery
+#define MESH_TOPOLOGY_SNR_UNKNOWN INT8_MIN
+
+/// Where we learned about a link from
+enum MeshTopologySource : uint8_t {
+    TOPOLOGY_SOURCE_DIRECT = 0x01,       // We heard the node ourselves with a hop count of zero
+    TOPOLOGY_SOURCE_NEIGHBORINFO = 0x02, // The receiving node listed it in its NeighborInfo
+    TOPOLOGY_SOURCE_TRACEROUTE = 0x04,   // The link was part of a traced route
+};
+
+/// A link over which "to" has heard "from" transmit
+struct MeshTopologyEdge {
+    NodeNum from;
+    NodeNum to;
+    uint32_t lastHeardMs; // millis() of the last time we learned about this link
+    int8_t snr;           // SNR (dB) * 4 at which "to" heard "from", or MESH_TOPOLOGY_SNR_UNKNOWN
+    uint8_t sources;      // MeshTopologySource bits
+};
+
+/**
+ * A bounded graph of the mesh built from what flows past us anyway: NeighborInfo packets, traced routes and the zero hop
+ * packets we hear ourselves.  Links age out when we stop hearing about them.
+ *
+ * Mostly useful on gateways, which can answer "who can hear whom" and "how would a packet get from A to B" questions, or
+ * hand a live mesh map to a client without it having to pull every raw packet off the node.
+ *
+ * All methods are safe to call from other threads, e.g. the portduino web server.
+ */
+class MeshTopology
+{
+  public:
+    MeshTopology();
+
+    /// We heard a zero hop packet from a node
+    void addDirect(NodeNum from, float snr);
+
+    /// A node told us which nodes it can hear
+    void addNeighborInfo(const meshtastic_NeighborInfo *np);
+
+    /// A route discovery went past us, learn the links it has traced so far
+    void addRoute(const meshtastic_MeshPacket &mp, const meshtastic_RouteDiscovery *r);
+
+    /// Copy the links over which others heard node n (isFrom) or over which n heard others (!isFrom), newest first
+    size_t getEdges(NodeNum n, bool isFrom, MeshTopologyEdge *out, size_t maxOut);
+
+    /// Copy every current link, newest first
+    size_t getAllEdges(MeshTopologyEdge *out, size_t maxOut);
+
+    /**
+     * Find the path with the fewest hops from one node to another.  Links we have only seen in the other direction are used
+     * too (LoRa links are mostly symmetric), but a path over links seen in the right direction wins a tie.
+     *
+     * @return the number of nodes stored in path (including both ends), 0 if there is no known path or it doesn't fit
+     */
+    size_t getShortestPath(NodeNum from, NodeNum to, NodeNum *path, size_t maxPath);
+
+    /// Incremented on every change, so exporters can tell if anything happened since they last looked
+    uint32_t getGeneration() { return generation; }
+
+    size_t getNumEdges();
+
+    /// Forget everything, e.g. after the NodeDB was reset
+    void clear();
+
+  private:
+    std::vector<MeshTopologyEdge> edges;
+    uint32_t generation = 0;
+    concurrency::Lock lock;
+
+    void addEdge(NodeNum from, NodeNum to, int8_t snr, uint8_t source);
+    void expireEdges();
+
+    /// Walk one direction of a traced route, first -> route[0] -> ... -> route[count - 1] -> last (if last is not 0)
+    void addRouteHops(NodeNum first, const uint32_t *route, pb_size_t count, const int8_t *snrs, pb_size_t snrCount,
+                      NodeNum last);
+};
+
+extern MeshTopology *meshTopology;
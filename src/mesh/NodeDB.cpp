@@ -9,6 +9,7 @@
 #include "Default.h"
 #include "FSCommon.h"
 #include "MeshRadio.h"
+#include "MeshTopology.h"
 #include "NodeDB.h"
 #include "PacketHistory.h"
 #include "PowerFSM.h"
@@ -697,11 +698,14 @@ void NodeDB::resetNodes()
         clearLocalPosition();
     numMeshNodes = 1;
     std::fill(devicestate.node_db_lite.begin() + 1, devicestate.node_db_lite.end(), meshtastic_NodeInfoLite());
+    decompressCapableNodes.clear();
     devicestate.has_rx_text_message = false;
     devicestate.has_rx_waypoint = false;
     saveDeviceStateToDisk();
     if (neighborInfoModule && moduleConfig.neighbor_info.enabled)
         neighborInfoModule->resetNeighbors();
+    if (meshTopology)
+        meshTopology->clear();
 }
 
 void NodeDB::removeNodeByNum(NodeNum nodeNum)
@@ -716,6 +720,7 @@ void NodeDB::removeNodeByNum(NodeNum nodeNum)
     numMeshNodes -= removed;
     std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + 1,
               meshtastic_NodeInfoLite());
+    decompressCapableNodes.erase(nodeNum);
     LOG_DEBUG("NodeDB::removeNodeByNum purged %d entries. Save changes", removed);
     saveDeviceStateToDisk();
 }
@@ -742,6 +747,7 @@ void NodeDB::cleanupMeshDB()
             }
             meshNodes->at(newPos++) = meshNodes->at(i);
         } else {
+            decompressCapableNodes.erase(meshNodes->at(i).num);
             removed++;
         }
     }
@@ -1312,6 +1318,17 @@ void NodeDB::updateFrom(const meshtastic_MeshPacket &mp)
         if (mp.hop_start != 0 && mp.hop_limit <= mp.hop_start) {
             info->has_hops_away = true;
             info->hops_away = mp.hop_start - mp.hop_limit;
+
+            if (meshTopology && info->hops_away == 0 && !mp.via_mqtt && !isFromUs(&mp))
+                meshTopology->addDirect(mp.from, mp.rx_snr);
+        }
+
+        // Only the original sender fills in the bitfield, so this tells us what firmware that node is running
+        if (mp.decoded.has_bitfield && !isFromUs(&mp)) {
+            if (mp.decoded.bitfield & BITFIELD_DECOMPRESS_OK_MASK)
+                decompressCapableNodes.insert(mp.from);
+            else
+                decompressCapableNodes.erase(mp.from);
         }
     }
 }
@@ -1373,6 +1390,7 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
             if (oldestBoringIndex != -1) {
                 oldestIndex = oldestBoringIndex;
             }
+            decompressCapableNodes.erase(meshNodes->at(oldestIndex).num);
             // Shove the remaining nodes down the chain
             for (int i = oldestIndex; i < numMeshNodes - 1; i++) {
                 meshNodes->at(i) = meshNodes->at(i + 1);
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <algorithm>
 #include <assert.h>
+#include <unordered_set>
 #include <vector>
 
 #include "MeshTypes.h"
@@ -120,6 +121,9 @@ class NodeDB
     // get channel channel index we heard a nodeNum on, defaults to 0 if not found
     uint8_t getMeshNodeChannel(NodeNum n);
 
+    /// @return true if this node has advertised (via BITFIELD_DECOMPRESS_OK) that it understands compressed text
+    bool canDecompress(NodeNum n) { return decompressCapableNodes.count(n) > 0; }
+
     /* Return the number of nodes we've heard from recently (within the last 2 hrs?)
      * @param localOnly if true, ignore nodes heard via MQTT
      */
@@ -169,6 +173,11 @@ class NodeDB
 
   private:
     uint32_t lastNodeDbSave = 0; // when we last saved our db to flash
+
+    /// Nodes whose most recent packet advertised BITFIELD_DECOMPRESS_OK.  Not saved to flash, we relearn it from their next
+    /// packet (NodeInfo broadcasts at the latest).
+    std::unordered_set<NodeNum> decompressCapableNodes;
+
     /// Find a node in our DB, create an empty NodeInfoLite if missing
     meshtastic_NodeInfoLite *getOrCreateMeshNode(NodeNum n);
 
@@ -0,0 +1,152 @@
+#include "PacketAggregator.h"
+#include "NodeDB.h"
+#include "Router.h"
+#include "configuration.h"
+#include "meshUtils.h"
+#include "sleep.h"
+#include <assert.h>
+
+PacketAggregator *packetAggregator;
+
+PacketAggregator::PacketAggregator(uint32_t _windowMsec) : concurrency::OSThread("PacketAggregator"), windowMsec(_windowMsec)
+{
+    notifyDeepSleepObserver.observe(&notifyDeepSleep);
+    LOG_INFO("Packet aggregation enabled, window=%ums", windowMsec);
+}
+
+bool PacketAggregator::wantsPacket(const meshtastic_MeshPacket *p)
+{
+    // Only our own unacknowledged periodic chatter, anything reliable, relayed or urgent (like our ACKs and NAKs, which the
+    // sender would retransmit if we held them back) goes out immediately as usual.  Router::send() has fixed the priority.
+    if (p->which_payload_variant != meshtastic_MeshPacket_decoded_tag || !isFromUs(p) || p->want_ack ||
+        p->priority > meshtastic_MeshPacket_Priority_BACKGROUND)
+        return false;
+
+    return IS_ONE_OF(p->decoded.portnum, meshtastic_PortNum_POSITION_APP, meshtastic_PortNum_TELEMETRY_APP,
+                     meshtastic_PortNum_NODEINFO_APP);
+}
+
+ErrorCode PacketAggregator::enqueue(meshtastic_MeshPacket *p, RadioInterface *iface)
+{
+    size_t needed = PACKET_AGGREGATE_SUBHEADER_LEN + p->encrypted.size;
+
+    // Too big to ever share a frame, don't hold it back
+    if (1 + needed > PACKET_AGGREGATE_MAX_PAYLOAD)
+        return iface->send(p);
+
+    if ((pendingIface && pendingIface != iface) || pendingBytes + needed > PACKET_AGGREGATE_MAX_PAYLOAD)
+        flush();
+
+    pending.push_back(p);
+    pendingIface = iface;
+    pendingBytes += needed;
+
+    // The window starts with the first packet we hold
+    if (pending.size() == 1)
+        setIntervalFromNow(windowMsec);
+
+    return ERRNO_OK;
+}
+
+void PacketAggregator::flush()
+{
+    if (pending.empty())
+        return;
+
+    RadioInterface *iface = pendingIface;
+    if (pending.size() == 1) {
+        // Nobody joined us, so send it as a plain packet
+        iface->send(pending.front());
+    } else {
+        meshtastic_MeshPacket *a = packetPool.allocZeroed();
+        a->from = nodeDB->getNodeNum();
+        a->to = NODENUM_BROADCAST;
+        a->id = generatePacketId();
+        a->hop_limit = 0; // Receivers unpack and relay the contained packets themselves
+        a->next_hop = PACKET_AGGREGATE_NEXT_HOP;
+        a->priority = meshtastic_MeshPacket_Priority_DEFAULT;
+        a->which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+
+        uint8_t *out = a->encrypted.bytes;
+        *out++ = PACKET_AGGREGATE_VERSION;
+        for (auto p : pending) {
+            memcpy(out, &p->to, sizeof(p->to));
+            out += sizeof(p->to);
+            memcpy(out, &p->id, sizeof(p->id));
+            out += sizeof(p->id);
+            *out++ = p->hop_limit | (p->want_ack ? PACKET_FLAGS_WANT_ACK_MASK : 0) | (p->via_mqtt ? PACKET_FLAGS_VIA_MQTT_MASK : 0) |
+                     ((p->hop_start << PACKET_FLAGS_HOP_START_SHIFT) & PACKET_FLAGS_HOP_START_MASK);
+            *out++ = p->channel;
+            *out++ = p->encrypted.size;
+            memcpy(out, p->encrypted.bytes, p->encrypted.size);
+            out += p->encrypted.size;
+
+            packetPool.release(p);
+        }
+        a->encrypted.size = out - a->encrypted.bytes;
+        assert(a->encrypted.size == pendingBytes);
+
+        LOG_DEBUG("Send %u packets aggregated into one frame id=0x%x, %u bytes", (unsigned)pending.size(), a->id,
+                  a->encrypted.size);
+        iface->send(a);
+    }
+
+    pending.clear();
+    pendingIface = NULL;
+    pendingBytes = 1;
+}
+
+int32_t PacketAggregator::runOnce()
+{
+    flush();
+    return INT32_MAX; // Sleep until enqueue() starts a new window
+}
+
+bool PacketAggregator::isAggregate(const meshtastic_MeshPacket *p)
+{
+    // The marker alone isn't enough, a broadcast that never hops is what keeps it apart from a relay hint
+    return p->which_payload_variant == meshtastic_MeshPacket_encrypted_tag && p->next_hop == PACKET_AGGREGATE_NEXT_HOP &&
+           p->to == NODENUM_BROADCAST && p->hop_limit == 0 && p->hop_start == 0 && p->encrypted.size > 0 &&
+           p->encrypted.bytes[0] == PACKET_AGGREGATE_VERSION;
+}
+
+size_t PacketAggregator::unbundle(meshtastic_MeshPacket *aggregate, meshtastic_MeshPacket **out, size_t maxOut)
+{
+    size_t numPackets = 0;
+    const uint8_t *in = aggregate->encrypted.bytes + 1;
+    const uint8_t *end = aggregate->encrypted.bytes + aggregate->encrypted.size;
+
+    while (in < end && numPackets < maxOut) {
+        if (end - in < PACKET_AGGREGATE_SUBHEADER_LEN || end - in - PACKET_AGGREGATE_SUBHEADER_LEN < in[10]) {
+            LOG_WARN("Malformed aggregate from 0x%x, drop remainder", aggregate->from);
+            break;
+        }
+
+        meshtastic_MeshPacket *p = packetPool.allocZeroed();
+        p->from = aggregate->from;
+        memcpy(&p->to, in, sizeof(p->to));
+        memcpy(&p->id, in + 4, sizeof(p->id));
+        uint8_t flags = in[8];
+        p->hop_limit = flags & PACKET_FLAGS_HOP_LIMIT_MASK;
+        p->hop_start = (flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
+        p->want_ack = !!(flags & PACKET_FLAGS_WANT_ACK_MASK);
+        p->via_mqtt = !!(flags & PACKET_FLAGS_VIA_MQTT_MASK);
+        p->channel = in[9];
+        p->which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+        p->encrypted.size = in[10];
+        memcpy(p->encrypted.bytes, in + PACKET_AGGREGATE_SUBHEADER_LEN, p->encrypted.size);
+        in += PACKET_AGGREGATE_SUBHEADER_LEN + p->encrypted.size;
+
+        // Every packet in the frame was heard with the same signal
+        p->rx_time = aggregate->rx_time;
+        p->rx_snr = aggregate->rx_snr;
+        p->rx_rssi = aggregate->rx_rssi;
+        p->relay_node = aggregate->relay_node;
+
+        out[numPackets++] = p;
+    }
+
+    LOG_DEBUG("Unpacked %u packets from aggregate id=0x%x from 0x%x", (unsigned)numPackets, aggregate->id, aggregate->from);
+    packetPool.release(aggregate);
+    return numPackets;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "RadioInterface.h"
+#include "concurrency/OSThread.h"
+#include <vector>
+
+/**
+ * Value placed in PacketHeader.next_hop to mark a frame as an aggregate of several packets.
+ *
+ * This can't be mistaken for a relay hint: next-hop routing only names a relay on direct messages that still have hops left,
+ * and only relays a frame if it does, while an aggregate is always a broadcast with no hops at all (see isAggregate()).  So
+ * a router whose node number ends in this byte never relays an aggregate, and a frame that names a relay is never unpacked.
+ */
+#define PACKET_AGGREGATE_NEXT_HOP 0xAB
+
+/// First payload byte of an aggregate frame, bump if the sub-header layout ever changes
+#define PACKET_AGGREGATE_VERSION 0x01
+
+/// Per packet sub-header inside an aggregate: to (4), id (4), flags (1), channel hash (1), payload length (1)
+#define PACKET_AGGREGATE_SUBHEADER_LEN 11
+
+/// The largest payload a single frame can carry, see the TOO_LARGE check in perhapsEncode
+#define PACKET_AGGREGATE_MAX_PAYLOAD (MAX_LORA_PAYLOAD_LEN - MESHTASTIC_HEADER_LENGTH)
+
+/// Max number of packets we will ever unpack from a single aggregate frame
+#define PACKET_AGGREGATE_MAX_PACKETS ((PACKET_AGGREGATE_MAX_PAYLOAD - 1) / PACKET_AGGREGATE_SUBHEADER_LEN)
+
+/**
+ * Packs several small, background priority packets we originate (position, telemetry, nodeinfo) into a single LoRa
+ * frame, so they share one preamble, one header and one contention slot.
+ *
+ * Sending is opt-in (see USERPREFS_PACKET_AGGREGATION_WINDOW_MS), but every node can unpack aggregate frames.  Aggregate frames
+ * are always sent with a hop limit of zero, the receiving nodes unpack them and then relay the contained packets as usual.
+ * Nodes running older firmware can't decrypt the aggregate so they just drop it.
+ */
+class PacketAggregator : private concurrency::OSThread
+{
+  public:
+    /** Constructor
+     * windowMsec is how long we hold the first packet waiting for others to join it
+     */
+    explicit PacketAggregator(uint32_t windowMsec);
+
+    /// @return true if this (still decoded) packet may be held and sent as part of an aggregate
+    bool wantsPacket(const meshtastic_MeshPacket *p);
+
+    /**
+     * Hold an (already encrypted) packet to be sent later as part of an aggregate on the specified interface.
+     * NOTE: This method will free the provided packet (even if we return an error code)
+     */
+    ErrorCode enqueue(meshtastic_MeshPacket *p, RadioInterface *iface);
+
+    /// Send whatever we are currently holding right now
+    void flush();
+
+    /// @return true if this packet (as received from or about to be sent to the radio) is an aggregate frame
+    static bool isAggregate(const meshtastic_MeshPacket *p);
+
+    /**
+     * Unpack a received aggregate into its contained packets, which inherit the receive metadata of the aggregate.
+     * The aggregate itself is released.
+     *
+     * @return the number of packets stored in out (at most maxOut), 0 if the aggregate was malformed
+     */
+    static size_t unbundle(meshtastic_MeshPacket *aggregate, meshtastic_MeshPacket **out, size_t maxOut);
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    uint32_t windowMsec;
+
+    /// The packets we are currently holding, and the interface they should go out on
+    std::vector<meshtastic_MeshPacket *> pending;
+    RadioInterface *pendingIface = NULL;
+
+    /// Number of payload bytes the aggregate would currently need (including the version byte)
+    size_t pendingBytes = 1;
+
+    CallbackObserver<PacketAggregator, void *> notifyDeepSleepObserver =
+        CallbackObserver<PacketAggregator, void *>(this, &PacketAggregator::onDeepSleep);
+
+    int onDeepSleep(void *unused)
+    {
+        flush();
+        return 0;
+    }
+};
+
+extern PacketAggregator *packetAggregator;
@@ -23,9 +23,26 @@ bool PacketHistory::wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpd
         return false; // Not a floodable message ID, so we don't care
     }
 
+    bool seenRecently = wasSeenRecently(getFrom(p), p->id, withUpdate);
+
+    if (seenRecently) {
+        LOG_DEBUG("Found existing packet record for fr=0x%x,to=0x%x,id=0x%x", p->from, p->to, p->id);
+    }
+    if (withUpdate) {
+        printPacket("Add packet record", p);
+    }
+
+    return seenRecently;
+}
+
+bool PacketHistory::wasSeenRecently(NodeNum sender, PacketId id, bool withUpdate)
+{
+    if (id == 0)
+        return false; // Not a floodable message ID, so we don't care
+
     PacketRecord r;
-    r.id = p->id;
-    r.sender = getFrom(p);
+    r.id = id;
+    r.sender = sender;
     r.rxTimeMsec = millis();
 
     auto found = recentPackets.find(r);
@@ -38,16 +55,11 @@ bool PacketHistory::wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpd
         seenRecently = false;
     }
 
-    if (seenRecently) {
-        LOG_DEBUG("Found existing packet record for fr=0x%x,to=0x%x,id=0x%x", p->from, p->to, p->id);
-    }
-
     if (withUpdate) {
         if (found != recentPackets.end()) { // delete existing to updated timestamp (re-insert)
             recentPackets.erase(found);     // as unsorted_set::iterator is const (can't update timestamp - so re-insert..)
         }
         recentPackets.insert(r);
-        printPacket("Add packet record", p);
     }
 
     // Capacity is reerved, so only purge expired packets if recentPackets fills past 90% capacity
@@ -42,4 +42,9 @@ class PacketHistory
      * @param withUpdate if true and not found we add an entry to recentPackets
      */
     bool wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpdate = true);
+
+    /**
+     * Same as above, for when all we have is the raw header of a frame
+     */
+    bool wasSeenRecently(NodeNum sender, PacketId id, bool withUpdate = true);
 };
@@ -26,6 +26,9 @@
 #if !MESHTASTIC_EXCLUDE_MQTT
 #include "mqtt/MQTT.h"
 #endif
+#if !MESHTASTIC_EXCLUDE_NEIGHBORINFO
+#include "modules/NeighborInfoModule.h"
+#endif
 #include "Throttle.h"
 #include <RTC.h>
 
@@ -38,6 +41,7 @@ PhoneAPI::PhoneAPI()
 PhoneAPI::~PhoneAPI()
 {
     close();
+    delete[] batchHeldBytes;
 }
 
 void PhoneAPI::handleStartConfig()
@@ -54,11 +58,19 @@ void PhoneAPI::handleStartConfig()
     // even if we were already connected - restart our state machine
     state = STATE_SEND_MY_INFO;
     pauseBluetoothLogging = true;
-    filesManifest = getFiles("/", 10);
+    if (config_nonce == SPECIAL_NONCE_NO_FILES)
+        filesManifest.clear();
+    else
+        filesManifest = getFilesManifest();
     LOG_DEBUG("Got %d files in manifest", filesManifest.size());
 
     LOG_INFO("Start API client config");
     nodeInfoForPhone.num = 0; // Don't keep returning old nodeinfos
+#if !MESHTASTIC_EXCLUDE_NEIGHBORINFO
+    if (neighborInfoModule)
+        neighborInfoModule->resetTopologyExport(); // This client hasn't seen any of the mesh map yet
+#endif
+    batchHeldLen = 0;
     resetReadIndex();
 }
 
@@ -83,6 +95,7 @@ void PhoneAPI::close()
         nodeInfoForPhone = {};
         packetForPhone = NULL;
         filesManifest.clear();
+        batchHeldLen = 0;
         fromRadioNum = 0;
         config_nonce = 0;
         config_state = 0;
@@ -467,6 +480,39 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
     return 0;
 }
 
+size_t PhoneAPI::getFromRadioBatch(uint8_t *buf, size_t maxLen)
+{
+    if (!batchHeldBytes)
+        batchHeldBytes = new uint8_t[meshtastic_FromRadio_size];
+    if (maxLen > FROMRADIO_BATCH_MAX_SIZE)
+        maxLen = FROMRADIO_BATCH_MAX_SIZE;
+
+    size_t len = 0;
+    while (true) {
+        size_t numbytes = batchHeldLen;
+        if (numbytes) {
+            batchHeldLen = 0;
+        } else {
+            numbytes = getFromRadio(batchHeldBytes);
+            if (!numbytes)
+                break;
+        }
+
+        // Keep what doesn't fit for the next batch, unless the batch is still empty
+        if (len && len + FROMRADIO_BATCH_HEADER_SIZE + numbytes > maxLen) {
+            batchHeldLen = numbytes;
+            break;
+        }
+
+        buf[len++] = numbytes & 0xff;
+        buf[len++] = numbytes >> 8;
+        memcpy(buf + len, batchHeldBytes, numbytes);
+        len += numbytes;
+    }
+
+    return len;
+}
+
 void PhoneAPI::sendConfigComplete()
 {
     LOG_INFO("Config Send Complete");
@@ -514,6 +560,9 @@ void PhoneAPI::releaseClientNotification()
  */
 bool PhoneAPI::available()
 {
+    if (batchHeldLen)
+        return true; // Left over from the last batch
+
     switch (state) {
     case STATE_SEND_NOTHING:
         return false;
@@ -20,6 +20,15 @@
 
 #define SPECIAL_NONCE 69420
 
+/// Clients sending this nonce get everything but the file manifest, e.g. because they never look at it
+#define SPECIAL_NONCE_NO_FILES 69422
+
+/// Each FromRadio in a batch is preceded by its length as a little endian uint16
+#define FROMRADIO_BATCH_HEADER_SIZE 2
+
+/// The largest batch getFromRadioBatch() will ever return, one maximum sized FromRadio (fits a single BLE attribute)
+#define FROMRADIO_BATCH_MAX_SIZE (meshtastic_FromRadio_size + FROMRADIO_BATCH_HEADER_SIZE)
+
 /**
  * Provides our protobuf based API which phone/PC clients can use to talk to our device
  * over UDP, bluetooth or serial.
@@ -87,6 +96,10 @@ class PhoneAPI
 
     std::vector<meshtastic_FileInfo> filesManifest = {};
 
+    /// A FromRadio that didn't fit the last batch, it goes first in the next one.  Only allocated once a client asks for batches
+    uint8_t *batchHeldBytes = NULL;
+    size_t batchHeldLen = 0;
+
     void resetReadIndex() { readIndex = 0; }
 
   public:
@@ -118,6 +131,17 @@ class PhoneAPI
      */
     size_t getFromRadio(uint8_t *buf);
 
+    /**
+     * Get as many of the packets we want to send to the phone as fit in maxLen bytes, each one preceded by its length
+     * (FROMRADIO_BATCH_HEADER_SIZE bytes, little endian).  Lets transports with a large MTU move many small packets per
+     * round trip, e.g. while sending the config or a backlog of messages.
+     *
+     * The next packet is always returned, even if it alone is bigger than maxLen, so buf must be at least
+     * FROMRADIO_BATCH_MAX_SIZE bytes long.
+     * Returns the number of bytes in the batch (or 0 if no packet available)
+     */
+    size_t getFromRadioBatch(uint8_t *buf, size_t maxLen);
+
     void sendConfigComplete();
 
     /**
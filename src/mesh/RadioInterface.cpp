@@ -1,9 +1,11 @@
 #include "RadioInterface.h"
+#include "BootTimeline.h"
 #include "Channels.h"
 #include "DisplayFormatters.h"
 #include "MeshRadio.h"
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "PacketAggregator.h"
 #include "Router.h"
 #include "configuration.h"
 #include "main.h"
@@ -235,7 +237,7 @@ uint32_t RadioInterface::getRetransmissionMsec(const meshtastic_MeshPacket *p)
     uint32_t packetAirtime = getPacketTime(numbytes + sizeof(PacketHeader));
     // Make sure enough time has elapsed for this packet to be sent and an ACK is received.
     // LOG_DEBUG("Waiting for flooding message with airtime %d and slotTime is %d", packetAirtime, slotTimeMsec);
-    float channelUtil = airTime->channelUtilizationPercent();
+    float channelUtil = getAirTime()->channelUtilizationPercent();
     uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
     // Assuming we pick max. of CWsize and there will be a client with SNR at half the range
     return 2 * packetAirtime + (pow(2, CWsize) + 2 * CWmax + pow(2, int((CWmax + CWmin) / 2))) * slotTimeMsec +
@@ -248,7 +250,7 @@ uint32_t RadioInterface::getTxDelayMsec()
     /** We wait a random multiple of 'slotTimes' (see definition in header file) in order to avoid collisions.
     The pool to take a random multiple from is the contention window (CW), which size depends on the
     current channel utilization. */
-    float channelUtil = airTime->channelUtilizationPercent();
+    float channelUtil = getAirTime()->channelUtilizationPercent();
     uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
     // LOG_DEBUG("Current channel utilization is %f so setting CWsize to %d", channelUtil, CWsize);
     return random(0, pow(2, CWsize)) * slotTimeMsec;
@@ -422,7 +424,19 @@ void RadioInterface::applyModemConfig()
 {
     // Set up default configuration
     // No Sync Words in LORA mode
-    meshtastic_Config_LoRaConfig &loraConfig = config.lora;
+    // A radio with overrides works on a copy, so neither they nor the fixups below end up in our config
+    meshtastic_Config_LoRaConfig overridden = config.lora;
+    if (hasModemOverrides) {
+        if (modemOverrides.has_modem_preset) {
+            overridden.use_preset = true;
+            overridden.modem_preset = modemOverrides.modem_preset;
+        }
+        if (modemOverrides.channel_num)
+            overridden.channel_num = modemOverrides.channel_num;
+        if (modemOverrides.override_frequency)
+            overridden.override_frequency = modemOverrides.override_frequency;
+    }
+    meshtastic_Config_LoRaConfig &loraConfig = hasModemOverrides ? overridden : config.lora;
     bool validConfig = false; // We need to check for a valid configuration
     while (!validConfig) {
         if (loraConfig.use_preset) {
@@ -532,9 +546,10 @@ void RadioInterface::applyModemConfig()
     // channel_num is actually (channel_num - 1), since modulus (%) returns values from 0 to (numChannels - 1)
     uint32_t channel_num = (loraConfig.channel_num ? loraConfig.channel_num - 1 : hash(channelName)) % numChannels;
 
-    // Check if we use the default frequency slot
-    RadioInterface::uses_default_frequency_slot =
-        channel_num == hash(DisplayFormatters::getModemPresetDisplayName(config.lora.modem_preset, false)) % numChannels;
+    // Check if we use the default frequency slot (only our main radio has a say in that)
+    if (!hasModemOverrides)
+        RadioInterface::uses_default_frequency_slot =
+            channel_num == hash(DisplayFormatters::getModemPresetDisplayName(config.lora.modem_preset, false)) % numChannels;
 
     // Old frequency selection formula
     // float freq = myRegion->freqStart + ((((myRegion->freqEnd - myRegion->freqStart) / numChannels) / 2) * channel_num);
@@ -587,8 +602,9 @@ void RadioInterface::limitPower()
 
 void RadioInterface::deliverToReceiver(meshtastic_MeshPacket *p)
 {
+    bootTimeline.markFirstPacket();
     if (router)
-        router->enqueueReceivedMessage(p);
+        router->enqueueReceivedMessage(p, this);
 }
 
 /***
@@ -605,7 +621,7 @@ size_t RadioInterface::beginSending(meshtastic_MeshPacket *p)
     radioBuffer.header.to = p->to;
     radioBuffer.header.id = p->id;
     radioBuffer.header.channel = p->channel;
-    radioBuffer.header.next_hop = 0;   // *** For future use ***
+    radioBuffer.header.next_hop = PacketAggregator::isAggregate(p) ? PACKET_AGGREGATE_NEXT_HOP : 0; // otherwise for future use
     radioBuffer.header.relay_node = 0; // *** For future use ***
     if (p->hop_limit > HOP_MAX) {
         LOG_WARN("hop limit %d is too high, setting to %d", p->hop_limit, HOP_RELIABLE);
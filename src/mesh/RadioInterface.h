@@ -19,6 +19,30 @@
 #define PACKET_FLAGS_HOP_START_MASK 0xE0
 #define PACKET_FLAGS_HOP_START_SHIFT 5
 
+/// Radios the Router can drive at once, only Linux gateways have room for more than one
+#ifndef MAX_RADIO_INTERFACES
+#if ARCH_PORTDUINO
+#define MAX_RADIO_INTERFACES 4
+#else
+#define MAX_RADIO_INTERFACES 1
+#endif
+#endif
+
+/// What a radio passes on of the packets that arrived on our other radios
+enum RadioBridgeMode {
+    BRIDGE_NONE,       // A separate mesh, it only carries our own packets
+    BRIDGE_BROADCASTS, // Relay broadcasts from the other radios, but keep their DMs to themselves
+    BRIDGE_ALL         // Relay everything, as if the radios were one mesh
+};
+
+/// Modem settings a radio uses instead of those in config.lora, so a second radio can sit on another preset or frequency slot
+struct RadioModemOverrides {
+    bool has_modem_preset;
+    meshtastic_Config_LoRaConfig_ModemPreset modem_preset;
+    uint32_t channel_num;     // 0 keeps ours
+    float override_frequency; // 0 keeps ours
+};
+
 /**
  * This structure has to exactly match the wire layout when sent over the radio link.  Used to keep compatibility
  * with the old radiohead implementation.
@@ -100,6 +124,11 @@ class RadioInterface
     meshtastic_MeshPacket *sendingPacket = NULL; // The packet we are currently sending
     uint32_t lastTxStart = 0L;
 
+    AirTime *ownAirTime = NULL; // NULL for the first radio, which uses the global airTime
+
+    bool hasModemOverrides = false;
+    RadioModemOverrides modemOverrides = {};
+
     uint32_t computeSlotTimeMsec(float bw, float sf) { return 8.5 * pow(2, sf) / bw + 0.2 + 0.4 + 7; }
 
     /**
@@ -196,9 +225,29 @@ class RadioInterface
      */
     virtual float getFreq();
 
+    /// The bandwidth (kHz) and spreading factor we are configured for
+    float getBandwidth() { return bw; }
+    uint8_t getSpreadingFactor() { return sf; }
+
     /// Some boards (1st gen Pinetab Lora module) have broken IRQ wires, so we need to poll via i2c registers
     virtual bool isIRQPending() { return false; }
 
+    /// Airtime and duty cycle accounting for this radio
+    AirTime *getAirTime() { return ownAirTime ? ownAirTime : airTime; }
+
+    /// Give a radio other than the first its own airtime accounting, it is on another channel after all
+    void setAirTime(AirTime *_airTime) { ownAirTime = _airTime; }
+
+    /// Use these instead of config.lora, must be called before init()
+    void setModemOverrides(const RadioModemOverrides &overrides)
+    {
+        hasModemOverrides = true;
+        modemOverrides = overrides;
+    }
+
+    /// What we pass on of the packets our other radios receive, only matters with more than one
+    RadioBridgeMode bridgeMode = BRIDGE_ALL;
+
     // Whether we use the default frequency slot given our LoRa config (region and modem preset)
     static bool uses_default_frequency_slot;
 
@@ -243,9 +292,12 @@ class RadioInterface
     /// Return 0 if sleep is okay
     int preflightSleepCb(void *unused = NULL) { return canSleep() ? 0 : 1; }
 
-    int notifyDeepSleepCb(void *unused = NULL);
+    /// Put the radio to sleep before we deep sleep, subclasses that run outside the main loop hand this to their own thread
+    virtual int notifyDeepSleepCb(void *unused = NULL);
 
-    int reloadConfig(void *unused)
+  protected:
+    /// Apply a config change, subclasses that run outside the main loop can defer it
+    virtual int reloadConfig(void *unused)
     {
         reconfigure();
         return 0;
@@ -2,6 +2,7 @@
 #include "MeshTypes.h"
 #include "NodeDB.h"
 #include "PowerMon.h"
+#include "Router.h"
 #include "SPILock.h"
 #include "Throttle.h"
 #include "configuration.h"
@@ -63,13 +64,26 @@ RadioLibInterface::RadioLibInterface(LockingArduinoHal *hal, RADIOLIB_PIN_TYPE c
                                      RADIOLIB_PIN_TYPE busy, PhysicalLayer *_iface)
     : NotifiedWorkerThread("RadioIf"), module(hal, cs, irq, rst, busy), iface(_iface)
 {
-    instance = this;
+    while (instanceNum < MAX_RADIO_INTERFACES - 1 && instances[instanceNum])
+        instanceNum++;
+    assert(!instances[instanceNum]);
+    instances[instanceNum] = this;
+    if (!instance)
+        instance = this;
 #if defined(ARCH_STM32WL) && defined(USE_SX1262)
     module.setCb_digitalWrite(stm32wl_emulate_digitalWrite);
     module.setCb_digitalRead(stm32wl_emulate_digitalRead);
 #endif
 }
 
+RadioLibInterface::~RadioLibInterface()
+{
+    // A radio that failed to init is deleted before we try the next kind
+    instances[instanceNum] = NULL;
+    if (instance == this)
+        instance = NULL;
+}
+
 #ifdef ARCH_ESP32
 // ESP32 doesn't use that flag
 #define YIELD_FROM_ISR(x) portYIELD_FROM_ISR()
@@ -77,12 +91,12 @@ RadioLibInterface::RadioLibInterface(LockingArduinoHal *hal, RADIOLIB_PIN_TYPE c
 #define YIELD_FROM_ISR(x) portYIELD_FROM_ISR(x)
 #endif
 
-void INTERRUPT_ATTR RadioLibInterface::isrLevel0Common(PendingISR cause)
+void INTERRUPT_ATTR RadioLibInterface::isrLevel0Common(RadioLibInterface *radio, PendingISR cause)
 {
-    instance->disableInterrupt();
+    radio->disableInterrupt();
 
     BaseType_t xHigherPriorityTaskWoken;
-    instance->notifyFromISR(&xHigherPriorityTaskWoken, cause, true);
+    radio->notifyFromISR(&xHigherPriorityTaskWoken, cause, true);
 
     /* Force a context switch if xHigherPriorityTaskWoken is now set to pdTRUE.
     The macro used to do this is dependent on the port and may be called
@@ -90,19 +104,42 @@ void INTERRUPT_ATTR RadioLibInterface::isrLevel0Common(PendingISR cause)
     YIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
-void INTERRUPT_ATTR RadioLibInterface::isrRxLevel0()
+template <uint8_t N> void INTERRUPT_ATTR RadioLibInterface::isrRxLevel0()
+{
+    isrLevel0Common(instances[N], ISR_RX);
+}
+
+template <uint8_t N> void INTERRUPT_ATTR RadioLibInterface::isrTxLevel0()
+{
+    isrLevel0Common(instances[N], ISR_TX);
+}
+
+#if MAX_RADIO_INTERFACES == 1
+#define RADIO_ISRS(isr) isr<0>
+#elif MAX_RADIO_INTERFACES == 2
+#define RADIO_ISRS(isr) isr<0>, isr<1>
+#elif MAX_RADIO_INTERFACES == 3
+#define RADIO_ISRS(isr) isr<0>, isr<1>, isr<2>
+#elif MAX_RADIO_INTERFACES == 4
+#define RADIO_ISRS(isr) isr<0>, isr<1>, isr<2>, isr<3>
+#else
+#error "Add ISR glue for the extra radios to RADIO_ISRS"
+#endif
+
+void (*RadioLibInterface::getRxIsr())()
 {
-    isrLevel0Common(ISR_RX);
+    static void (*const isrs[MAX_RADIO_INTERFACES])() = {RADIO_ISRS(isrRxLevel0)};
+    return isrs[instanceNum];
 }
 
-void INTERRUPT_ATTR RadioLibInterface::isrTxLevel0()
+void (*RadioLibInterface::getTxIsr())()
 {
-    isrLevel0Common(ISR_TX);
+    static void (*const isrs[MAX_RADIO_INTERFACES])() = {RADIO_ISRS(isrTxLevel0)};
+    return isrs[instanceNum];
 }
 
-/** Our ISR code currently needs this to find our active instance
- */
 RadioLibInterface *RadioLibInterface::instance;
+RadioLibInterface *RadioLibInterface::instances[MAX_RADIO_INTERFACES];
 
 /** Could we send right now (i.e. either not actively receiving or transmitting)? */
 bool RadioLibInterface::canSendImmediately()
@@ -195,7 +232,21 @@ ErrorCode RadioLibInterface::send(meshtastic_MeshPacket *p)
 #ifndef LORA_DISABLE_SENDING
     printPacket("enqueue for send", p);
 
-    LOG_DEBUG("txGood=%d,txRelay=%d,rxGood=%d,rxBad=%d", txGood, txRelay, rxGood, rxBad);
+    LOG_DEBUG("txGood=%d,txRelay=%d,rxGood=%d,rxBad=%d,rxEarlyDrop=%d,rxDrop=%d", txGood, txRelay, rxGood, rxBad,
+              router ? router->rxEarlyDupe + router->rxEarlyIgnored : 0, rxDropped + (router ? router->rxQueueDropped : 0));
+    if (rxToRelayCount)
+        LOG_DEBUG("rxToRelay avg=%ums,max=%ums", rxToRelayTotalMsec / rxToRelayCount, rxToRelayMaxMsec);
+#if HAS_RADIO_TASK
+    if (task) {
+        // The radio task does the queueing and the timing
+        if (!request({Request::SEND, p, 0, 0})) {
+            LOG_WARN("Radio task request queue full, drop packet");
+            packetPool.release(p);
+            return ERRNO_UNKNOWN;
+        }
+        return ERRNO_OK;
+    }
+#endif
     ErrorCode res = txQueue.enqueue(p) ? ERRNO_OK : ERRNO_UNKNOWN;
 
     if (res != ERRNO_OK) { // we weren't able to queue it, so we must drop it to prevent leaks
@@ -221,6 +272,14 @@ meshtastic_QueueStatus RadioLibInterface::getQueueStatus()
     qs.res = qs.mesh_packet_id = 0;
     qs.free = txQueue.getFree();
     qs.maxlen = txQueue.getMaxLen();
+#if HAS_RADIO_TASK
+    if (task) {
+        // Don't look at txQueue from here, count the sends the task hasn't taken yet against what it last told us
+        size_t pending = requests.numWaiting();
+        size_t free = txQueueFree;
+        qs.free = free > pending ? free - pending : 0;
+    }
+#endif
 
     return qs;
 }
@@ -228,6 +287,10 @@ meshtastic_QueueStatus RadioLibInterface::getQueueStatus()
 bool RadioLibInterface::canSleep()
 {
     bool res = txQueue.empty();
+#if HAS_RADIO_TASK
+    if (task)
+        res = txQueueFree == txQueue.getMaxLen() && !requests.numWaiting();
+#endif
     if (!res) { // only print debug messages if we are vetoing sleep
         LOG_DEBUG("Radio wait to sleep, txEmpty=%d", res);
     }
@@ -236,6 +299,17 @@ bool RadioLibInterface::canSleep()
 
 /** Attempt to cancel a previously sent packet.  Returns true if a packet was found we could cancel */
 bool RadioLibInterface::cancelSending(NodeNum from, PacketId id)
+{
+#if HAS_RADIO_TASK
+    if (task) {
+        request({Request::CANCEL, NULL, from, id});
+        return false;
+    }
+#endif
+    return removeFromTxQueue(from, id);
+}
+
+bool RadioLibInterface::removeFromTxQueue(NodeNum from, PacketId id)
 {
     auto p = txQueue.remove(from, id);
     if (p)
@@ -286,7 +360,8 @@ void RadioLibInterface::onNotify(uint32_t notification)
                     if (sent) {
                         // Packet has been sent, count it toward our TX airtime utilization.
                         uint32_t xmitMsec = getPacketTime(txp);
-                        airTime->logAirtime(TX_LOG, xmitMsec);
+                        logAirtime(TX_LOG, xmitMsec);
+                        logNodeAirtime(nodeDB->getNodeNum(), xmitMsec);
                     }
                 }
             }
@@ -342,7 +417,7 @@ void RadioLibInterface::handleTransmitInterrupt()
     // ignore the transmit interrupt
     if (sendingPacket)
         completeSending();
-    powerMon->clearState(meshtastic_PowerMon_State_Lora_TXOn); // But our transmitter is definitely off now
+    setPowerState(meshtastic_PowerMon_State_Lora_TXOn, false); // But our transmitter is definitely off now
 }
 
 void RadioLibInterface::completeSending()
@@ -384,7 +459,7 @@ void RadioLibInterface::handleReceiveInterrupt()
 #ifndef DISABLE_WELCOME_UNSET
     if (config.lora.region == meshtastic_Config_LoRaConfig_RegionCode_UNSET) {
         LOG_WARN("lora rx disabled: Region unset");
-        airTime->logAirtime(RX_ALL_LOG, xmitMsec);
+        logAirtime(RX_ALL_LOG, xmitMsec);
         return;
     }
 #endif
@@ -399,7 +474,7 @@ void RadioLibInterface::handleReceiveInterrupt()
         LOG_ERROR("Ignore received packet due to error=%d", state);
         rxBad++;
 
-        airTime->logAirtime(RX_ALL_LOG, xmitMsec);
+        logAirtime(RX_ALL_LOG, xmitMsec);
 
     } else {
         // Skip the 4 headers that are at the beginning of the rxBuf
@@ -409,7 +484,7 @@ void RadioLibInterface::handleReceiveInterrupt()
         if (payloadLen < 0) {
             LOG_WARN("Ignore received packet too short");
             rxBad++;
-            airTime->logAirtime(RX_ALL_LOG, xmitMsec);
+            logAirtime(RX_ALL_LOG, xmitMsec);
         } else {
             rxGood++;
             // altered packet with "from == 0" can do Remote Node Administration without permission
@@ -418,6 +493,20 @@ void RadioLibInterface::handleReceiveInterrupt()
                 return;
             }
 
+            // Count every frame against its sender, even the ones we drop below
+            logNodeAirtime(radioBuffer.header.from, xmitMsec);
+
+            // Most frames on a busy mesh are duplicates, don't spend a packet from the pool on them.  The Router's history
+            // belongs to the main loop though, so on a radio task we leave that to it.
+            bool canCheckHeader = true;
+#if HAS_RADIO_TASK
+            canCheckHeader = !task;
+#endif
+            if (router && canCheckHeader && router->shouldDropReceivedHeader(radioBuffer.header, xmitMsec, this)) {
+                logAirtime(RX_LOG, xmitMsec);
+                return;
+            }
+
             // Note: we deliver _all_ packets to our router (i.e. our interface is intentionally promiscuous).
             // This allows the router and other apps on our node to sniff packets (usually routing) between other
             // nodes.
@@ -432,6 +521,8 @@ void RadioLibInterface::handleReceiveInterrupt()
             mp->hop_start = (radioBuffer.header.flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
             mp->want_ack = !!(radioBuffer.header.flags & PACKET_FLAGS_WANT_ACK_MASK);
             mp->via_mqtt = !!(radioBuffer.header.flags & PACKET_FLAGS_VIA_MQTT_MASK);
+            mp->next_hop = radioBuffer.header.next_hop; // Used to mark aggregate frames, see PacketAggregator
+            mp->relay_node = radioBuffer.header.relay_node;
 
             addReceiveMetadata(mp);
 
@@ -443,8 +534,21 @@ void RadioLibInterface::handleReceiveInterrupt()
 
             printPacket("Lora RX", mp);
 
-            airTime->logAirtime(RX_LOG, xmitMsec);
+            logAirtime(RX_LOG, xmitMsec);
+            noteReceived(mp);
 
+#if HAS_RADIO_TASK
+            if (task) {
+                if (!received.push(mp)) {
+                    LOG_WARN("Main loop too busy, drop received packet");
+                    rxDropped++;
+                    packetPool.release(mp);
+                    return;
+                }
+                concurrency::mainDelay.interrupt();
+                return;
+            }
+#endif
             deliverToReceiver(mp);
         }
     }
@@ -453,19 +557,19 @@ void RadioLibInterface::handleReceiveInterrupt()
 void RadioLibInterface::startReceive()
 {
     isReceiving = true;
-    powerMon->setState(meshtastic_PowerMon_State_Lora_RXOn);
+    setPowerState(meshtastic_PowerMon_State_Lora_RXOn, true);
 }
 
 void RadioLibInterface::configHardwareForSend()
 {
-    powerMon->setState(meshtastic_PowerMon_State_Lora_TXOn);
+    setPowerState(meshtastic_PowerMon_State_Lora_TXOn, true);
 }
 
 void RadioLibInterface::setStandby()
 {
     // neither sending nor receiving
-    powerMon->clearState(meshtastic_PowerMon_State_Lora_RXOn);
-    powerMon->clearState(meshtastic_PowerMon_State_Lora_TXOn);
+    setPowerState(meshtastic_PowerMon_State_Lora_RXOn, false);
+    setPowerState(meshtastic_PowerMon_State_Lora_TXOn, false);
 }
 
 /** start an immediate transmit */
@@ -489,17 +593,174 @@ bool RadioLibInterface::startSend(meshtastic_MeshPacket *txp)
 
             // This send failed, but make sure to 'complete' it properly
             completeSending();
-            powerMon->clearState(meshtastic_PowerMon_State_Lora_TXOn); // Transmitter off now
+            setPowerState(meshtastic_PowerMon_State_Lora_TXOn, false); // Transmitter off now
             startReceive(); // Restart receive mode (because startTransmit failed to put us in xmit mode)
         } else {
             lastTxStart = millis();
             printPacket("Started Tx", txp);
+            if (!isFromUs(txp))
+                noteRelaying(txp);
         }
 
         // Must be done AFTER, starting transmit, because startTransmit clears (possibly stale) interrupt pending register
         // bits
-        enableInterrupt(isrTxLevel0);
+        enableInterrupt(getTxIsr());
 
         return res == RADIOLIB_ERR_NONE;
     }
-}
\ No newline at end of file
+}
+
+void RadioLibInterface::noteReceived(const meshtastic_MeshPacket *p)
+{
+    recentRx[nextRecentRx] = {p->from, p->id, millis()};
+    nextRecentRx = (nextRecentRx + 1) % RADIO_RX_TO_RELAY_SLOTS;
+}
+
+void RadioLibInterface::noteRelaying(const meshtastic_MeshPacket *p)
+{
+    for (auto &rx : recentRx) {
+        if (rx.rxMsec && rx.from == p->from && rx.id == p->id) {
+            uint32_t msec = millis() - rx.rxMsec;
+            rxToRelayCount++;
+            rxToRelayTotalMsec += msec;
+            if (msec > rxToRelayMaxMsec)
+                rxToRelayMaxMsec = msec;
+            rx.rxMsec = 0; // Count a packet once, even if we end up sending it again
+            return;
+        }
+    }
+}
+
+void RadioLibInterface::logAirtime(reportTypes reportType, uint32_t msec)
+{
+#if HAS_RADIO_TASK
+    if (task) {
+        events.push({Event::AIRTIME, reportType, msec}); // If the main loop is that far behind, losing some airtime is fine
+        return;
+    }
+#endif
+    getAirTime()->logAirtime(reportType, msec);
+}
+
+void RadioLibInterface::logNodeAirtime(NodeNum node, uint32_t msec)
+{
+#if HAS_RADIO_TASK
+    if (task) {
+        events.push({Event::NODE_AIRTIME, node, msec});
+        return;
+    }
+#endif
+    getAirTime()->logNodeAirtime(node, msec);
+}
+
+void RadioLibInterface::setPowerState(meshtastic_PowerMon_State state, bool on)
+{
+#if HAS_RADIO_TASK
+    if (task) {
+        events.push({on ? Event::POWER_ON : Event::POWER_OFF, state, 0});
+        return;
+    }
+#endif
+    if (on)
+        powerMon->setState(state);
+    else
+        powerMon->clearState(state);
+}
+
+#if HAS_RADIO_TASK
+void RadioLibInterface::moveToTask(RadioTask *_task, ThreadController *controller, concurrency::InterruptableDelay *delay)
+{
+    task = _task;
+    wakeDelay = delay;
+    moveToController(controller);
+}
+
+bool RadioLibInterface::request(const Request &r)
+{
+    if (!requests.push(r))
+        return false;
+    task->wake();
+    return true;
+}
+
+void RadioLibInterface::applyRequests()
+{
+    Request r;
+    while (requests.pop(r)) {
+        switch (r.kind) {
+        case Request::SEND:
+            if (!txQueue.enqueue(r.p)) {
+                LOG_WARN("TX queue full, drop packet id=0x%08x", r.p->id);
+                packetPool.release(r.p);
+            } else {
+                setTransmitDelay();
+            }
+            break;
+        case Request::CANCEL:
+            removeFromTxQueue(r.from, r.id);
+            break;
+        case Request::RECONFIGURE:
+            reconfigure();
+            break;
+        case Request::SLEEP:
+            RadioInterface::disable(); // Put the radio to sleep and send nothing more
+            concurrency::OSThread::disable();
+            asleep = true;
+            break;
+        }
+    }
+}
+
+void RadioLibInterface::forwardReceived()
+{
+    Event e;
+    while (events.pop(e)) {
+        switch (e.kind) {
+        case Event::AIRTIME:
+            getAirTime()->logAirtime((reportTypes)e.arg, e.msec);
+            break;
+        case Event::NODE_AIRTIME:
+            getAirTime()->logNodeAirtime(e.arg, e.msec);
+            break;
+        case Event::POWER_ON:
+            powerMon->setState((meshtastic_PowerMon_State)e.arg);
+            break;
+        case Event::POWER_OFF:
+            powerMon->clearState((meshtastic_PowerMon_State)e.arg);
+            break;
+        }
+    }
+
+    meshtastic_MeshPacket *p;
+    while (received.pop(p))
+        deliverToReceiver(p);
+}
+
+int RadioLibInterface::reloadConfig(void *unused)
+{
+    if (!task)
+        return RadioInterface::reloadConfig(unused);
+
+    if (!request({Request::RECONFIGURE, NULL, 0, 0}))
+        LOG_ERROR("Radio task request queue full, config change not applied to the radio");
+    return 0;
+}
+
+int RadioLibInterface::notifyDeepSleepCb(void *unused)
+{
+    if (!task)
+        return RadioInterface::notifyDeepSleepCb(unused);
+
+    // Only the task may touch the radio, and it may be in the middle of sending, so have it put the radio to sleep for us
+    if (!request({Request::SLEEP, NULL, 0, 0})) {
+        LOG_ERROR("Radio task request queue full, radio not put to sleep");
+        return 0;
+    }
+    uint32_t start = millis();
+    while (!asleep && millis() - start < RADIO_TASK_SLEEP_TIMEOUT_MS)
+        delay(1);
+    if (!asleep)
+        LOG_ERROR("Radio task did not put the radio to sleep");
+    return 0;
+}
+#endif
@@ -2,10 +2,16 @@
 
 #include "MeshPacketQueue.h"
 #include "RadioInterface.h"
+#include "RadioTask.h"
 #include "concurrency/NotifiedWorkerThread.h"
+#include "meshtastic/powermon.pb.h"
 
 #include <RadioLib.h>
 #include <sys/types.h>
+#if HAS_RADIO_TASK
+#include "concurrency/LockFreeQueue.h"
+#include <atomic>
+#endif
 
 // ESP32 has special rules about ISR code
 #ifdef ARDUINO_ARCH_ESP32
@@ -16,6 +22,18 @@
 
 #define RADIOLIB_PIN_TYPE uint32_t
 
+/// Packets we received and remember until we relay them, to see how long relaying took
+#define RADIO_RX_TO_RELAY_SLOTS 8
+
+/// Received packets waiting for the main loop to pick them up, when running on a RadioTask
+#define RADIO_TASK_RX_QUEUE 8
+
+/// Airtime and power state changes waiting for the main loop to book them, when running on a RadioTask
+#define RADIO_TASK_EVENT_QUEUE 32
+
+/// How long we wait for a RadioTask to put its radio to sleep before we deep sleep anyway
+#define RADIO_TASK_SLEEP_TIMEOUT_MS 1000
+
 /**
  * We need to override the RadioLib ArduinoHal class to add mutex protection for SPI bus access
  */
@@ -58,12 +76,74 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     enum PendingISR { ISR_NONE = 0, ISR_RX, ISR_TX, TRANSMIT_DELAY_COMPLETED };
 
     /**
-     * Raw ISR handler that just calls our polymorphic method
+     * Raw ISR handlers that just call our polymorphic method.  RadioLib's callbacks can't tell us which radio fired, so every
+     * instance gets its own pair
      */
-    static void isrTxLevel0(), isrLevel0Common(PendingISR code);
+    static void isrLevel0Common(RadioLibInterface *radio, PendingISR code);
+    template <uint8_t N> static void isrRxLevel0();
+    template <uint8_t N> static void isrTxLevel0();
+
+    /// Our slot in instances
+    uint8_t instanceNum = 0;
 
     MeshPacketQueue txQueue = MeshPacketQueue(MAX_TX_QUEUE);
 
+    struct RecentRx {
+        NodeNum from;
+        PacketId id;
+        uint32_t rxMsec;
+    };
+    RecentRx recentRx[RADIO_RX_TO_RELAY_SLOTS] = {};
+    uint8_t nextRecentRx = 0;
+
+#if HAS_RADIO_TASK
+    friend class RadioTask;
+
+    /// The task we run on, NULL if we run in the main loop as usual
+    RadioTask *task = NULL;
+
+    /// What the main loop asks of us while we run on a RadioTask
+    struct Request {
+        enum Kind { SEND, CANCEL, RECONFIGURE, SLEEP } kind;
+        meshtastic_MeshPacket *p;
+        NodeNum from;
+        PacketId id;
+    };
+    concurrency::LockFreeQueue<Request, 2 * MAX_TX_QUEUE> requests;
+    concurrency::LockFreeQueue<meshtastic_MeshPacket *, RADIO_TASK_RX_QUEUE> received;
+
+    /// What the task would have told AirTime and PowerMon, neither of which may be touched off the main loop
+    struct Event {
+        enum Kind { AIRTIME, NODE_AIRTIME, POWER_ON, POWER_OFF } kind;
+        uint32_t arg; // reportTypes, NodeNum or meshtastic_PowerMon_State
+        uint32_t msec;
+    };
+    concurrency::LockFreeQueue<Event, RADIO_TASK_EVENT_QUEUE> events;
+
+    /// Set by the task once it carried out a SLEEP request
+    std::atomic<bool> asleep{false};
+
+    /// txQueue.getFree() as of the last time the task ran, for the main loop to look at
+    std::atomic<size_t> txQueueFree{MAX_TX_QUEUE};
+
+    void moveToTask(RadioTask *_task, ThreadController *controller, concurrency::InterruptableDelay *delay);
+
+    /// Called from the main loop: queue r for the task and wake it, false if the queue is full
+    bool request(const Request &r);
+
+    /// Called from the task: carry out what the main loop queued
+    void applyRequests();
+
+    void publishQueueStatus() { txQueueFree = txQueue.getFree(); }
+
+    /// Called from the main loop: give what the task received to the Router, and book its airtime and power state changes
+    void forwardReceived();
+
+    virtual int reloadConfig(void *unused) override;
+
+    virtual int notifyDeepSleepCb(void *unused = NULL) override;
+#endif
+
   protected:
     /**
      * We use a meshtastic sync word, but hashed with the Channel name.  For releases before 1.2 we used 0x12 (or for very old
@@ -91,10 +171,14 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     bool isReceiving = false;
 
   public:
-    /** Our ISR code currently needs this to find our active instance
+    /** The first (or only) radio, for the stats and reports that only know about one
      */
     static RadioLibInterface *instance;
 
+    /** Our ISR code needs these to find the instance an interrupt is for
+     */
+    static RadioLibInterface *instances[MAX_RADIO_INTERFACES];
+
     /**
      * Glue functions called from ISR land
      */
@@ -110,10 +194,18 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
      */
     uint32_t rxBad = 0, rxGood = 0, txGood = 0, txRelay = 0;
 
+    /// Received packets we had to drop because the main loop didn't pick them up in time (only with a RadioTask)
+    uint32_t rxDropped = 0;
+
+    /// How long it took from receiving a packet to starting to relay it, over rxToRelayCount relays
+    uint32_t rxToRelayCount = 0, rxToRelayTotalMsec = 0, rxToRelayMaxMsec = 0;
+
   public:
     RadioLibInterface(LockingArduinoHal *hal, RADIOLIB_PIN_TYPE cs, RADIOLIB_PIN_TYPE irq, RADIOLIB_PIN_TYPE rst,
                       RADIOLIB_PIN_TYPE busy, PhysicalLayer *iface = NULL);
 
+    virtual ~RadioLibInterface();
+
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
     /**
@@ -139,10 +231,25 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
      */
     virtual bool isActivelyReceiving() = 0;
 
-    /** Attempt to cancel a previously sent packet.  Returns true if a packet was found we could cancel */
+    /**
+     * Attempt to cancel a previously sent packet.  Returns true if a packet was found we could cancel.  When running on a
+     * RadioTask the cancel is only queued and we can't tell yet, so this returns false.
+     */
     virtual bool cancelSending(NodeNum from, PacketId id) override;
 
   private:
+    /// Remove a packet from txQueue and release it, true if it was there
+    bool removeFromTxQueue(NodeNum from, PacketId id);
+
+    /// Remember when we received p, or if we are relaying something we received see how long that took
+    void noteReceived(const meshtastic_MeshPacket *p);
+    void noteRelaying(const meshtastic_MeshPacket *p);
+
+    /// Book airtime and power state changes, on the main loop even when we run on a RadioTask
+    void logAirtime(reportTypes reportType, uint32_t msec);
+    void logNodeAirtime(NodeNum node, uint32_t msec);
+    void setPowerState(meshtastic_PowerMon_State state, bool on);
+
     /** if we have something waiting to send, start a short (random) timer so we can come check for collision before actually
      * doing the transmit */
     void setTransmitDelay();
@@ -181,9 +288,10 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     virtual bool canSendImmediately();
 
     /**
-     * Raw ISR handler that just calls our polymorphic method
+     * The raw ISR handlers of this instance, to hand to enableInterrupt()
      */
-    static void isrRxLevel0();
+    void (*getRxIsr())();
+    void (*getTxIsr())();
 
     /**
      * If a send was in progress finish it and return the buffer to the pool */
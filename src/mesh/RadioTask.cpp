@@ -0,0 +1,49 @@
+#include "RadioTask.h"
+
+#if HAS_RADIO_TASK
+#include "RadioLibInterface.h"
+
+RadioTask *radioTask;
+
+RadioTask::RadioTask(uint8_t _core) : core(_core)
+{
+    controller.ThreadName = "radioController";
+}
+
+void RadioTask::adopt(RadioLibInterface *radio)
+{
+    radio->moveToTask(this, &controller, &delay);
+    radios.push_back(radio);
+}
+
+void RadioTask::start()
+{
+    LOG_INFO("Run the radio on core %u", core);
+    xTaskCreatePinnedToCore(taskMain, "radio", RADIO_TASK_STACK_SIZE, this, RADIO_TASK_PRIORITY, NULL, core);
+}
+
+void RadioTask::forwardReceived()
+{
+    for (auto radio : radios)
+        radio->forwardReceived();
+}
+
+void RadioTask::taskMain(void *arg)
+{
+    static_cast<RadioTask *>(arg)->loop();
+}
+
+void RadioTask::loop()
+{
+    while (true) {
+        for (auto radio : radios)
+            radio->applyRequests();
+
+        long delayMsec = controller.runOrDelay();
+
+        for (auto radio : radios)
+            radio->publishQueueStatus();
+        delay.delay(delayMsec);
+    }
+}
+#endif
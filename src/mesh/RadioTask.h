@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../userPrefs.h"
+#include "configuration.h"
+
+// Only worth it with a second core, the Arduino loop runs on ARDUINO_RUNNING_CORE
+#if defined(ARCH_ESP32) && defined(USERPREFS_RADIO_TASK_CORE) && !CONFIG_FREERTOS_UNICORE
+#define HAS_RADIO_TASK 1
+#else
+#define HAS_RADIO_TASK 0
+#endif
+
+#if HAS_RADIO_TASK
+#include "ThreadController.h"
+#include "concurrency/InterruptableDelay.h"
+#include <vector>
+
+#define RADIO_TASK_STACK_SIZE 8192
+#define RADIO_TASK_PRIORITY 10 // Above the Arduino loop (1), below WiFi and BT
+
+class RadioLibInterface;
+
+/**
+ * A FreeRTOS task pinned to its own core that runs the LoRa driver, so a screen redraw, GPS parsing or a TLS handshake in the
+ * Arduino loop can't hold up servicing the radio's interrupts.
+ *
+ * The radios we adopt only ever run on this task.  Packets cross over through each radio's lock free queues: the main loop
+ * queues sends and cancels for us, we queue what we receive for the main loop (see forwardReceived()), which hands them to
+ * the Router as before.
+ */
+class RadioTask
+{
+  public:
+    explicit RadioTask(uint8_t core);
+
+    /// Run radio on this task from now on, call before start()
+    void adopt(RadioLibInterface *radio);
+
+    void start();
+
+    /// Wake the task because the main loop queued something for it
+    void wake() { delay.interrupt(); }
+
+    /// Called from the main loop: pass what our radios received on to the Router
+    void forwardReceived();
+
+  private:
+    uint8_t core;
+    ThreadController controller;
+    concurrency::InterruptableDelay delay;
+    std::vector<RadioLibInterface *> radios;
+
+    static void taskMain(void *arg);
+    void loop();
+};
+
+extern RadioTask *radioTask;
+#endif
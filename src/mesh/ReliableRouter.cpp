@@ -76,6 +76,22 @@ bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
     return FloodingRouter::shouldFilterReceived(p);
 }
 
+bool ReliableRouter::shouldDropReceivedHeader(const PacketHeader &h, uint32_t airtimeMsec, RadioInterface *radio)
+{
+    // Someone rebroadcasting one of our packets might be an implicit ACK
+    if (h.from == getNodeNum())
+        return false;
+
+    if (!FloodingRouter::shouldDropReceivedHeader(h, airtimeMsec, radio))
+        return false;
+
+    // While receiving this frame we could not have received an ACK either, see shouldFilterReceived()
+    for (auto i = pending.begin(); i != pending.end(); i++) {
+        i->second.nextTxMsec += airtimeMsec;
+    }
+    return true;
+}
+
 /**
  * If we receive a want_ack packet (do not check for wasSeenRecently), send back an ack (this might generate multiple ack sends in
  * case the our first ack gets lost)
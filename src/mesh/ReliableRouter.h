@@ -70,6 +70,11 @@ class ReliableRouter : public FloodingRouter
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
+    /**
+     * Leave our own packets to shouldFilterReceived() (implicit ACKs), and account for the airtime of frames we drop early
+     */
+    virtual bool shouldDropReceivedHeader(const PacketHeader &h, uint32_t airtimeMsec, RadioInterface *radio) override;
+
     /** Do our retransmission handling */
     virtual int32_t runOnce() override
     {
@@ -4,18 +4,23 @@
 #include "MeshRadio.h"
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "PacketAggregator.h"
 #include "RTC.h"
 #include "configuration.h"
 #include "main.h"
 #include "mesh-pb-constants.h"
+#include "mesh/compression/unishox2.h"
 #include "meshUtils.h"
 #include "modules/RoutingModule.h"
+#include "modules/Telemetry/TelemetryDeadband.h"
 #if !MESHTASTIC_EXCLUDE_MQTT
 #include "mqtt/MQTT.h"
 #endif
 #include "Default.h"
 #if ARCH_PORTDUINO
+#include "platform/portduino/PacketCapture.h"
 #include "platform/portduino/PortduinoGlue.h"
+#include "platform/portduino/ReceivePipeline.h"
 #endif
 #if ENABLE_JSON_LOGGING || ARCH_PORTDUINO
 #include "serialization/MeshPacketSerializer.h"
@@ -36,13 +41,30 @@ static MemoryDynamic<meshtastic_MeshPacket> staticPool;
 
 Allocator<meshtastic_MeshPacket> &packetPool = staticPool;
 
+RouterProfiler *routerProfiler;
+
+static inline void beginStage(RouterStage stage)
+{
+    if (routerProfiler)
+        routerProfiler->beginStage(stage);
+}
+
+static inline void endStage(RouterStage stage)
+{
+    if (routerProfiler)
+        routerProfiler->endStage(stage);
+}
+
+// The text message we last decompressed, as it arrived, so relays pass on the compressed payload rather than what we made of it
+static NodeNum compressedFrom;
+static PacketId compressedId;
+static meshtastic_Data_payload_t compressedPayload;
+
 static uint8_t bytes[MAX_LORA_PAYLOAD_LEN + 1] __attribute__((__aligned__));
 static uint8_t ScratchEncrypted[MAX_LORA_PAYLOAD_LEN + 1] __attribute__((__aligned__));
 
 /**
  * Constructor
- *
- * Currently we only allow one interface, that may change in the future
  */
 Router::Router() : concurrency::OSThread("Router"), fromRadioQueue(MAX_RX_FROMRADIO)
 {
@@ -59,6 +81,21 @@ Router::Router() : concurrency::OSThread("Router"), fromRadioQueue(MAX_RX_FROMRA
     cryptLock = new concurrency::Lock();
 }
 
+void Router::addInterface(RadioInterface *_iface)
+{
+    if (interfaces.size() >= MAX_RADIO_INTERFACES) {
+        LOG_ERROR("Only %d radios supported, ignore the extra one", MAX_RADIO_INTERFACES);
+        return;
+    }
+
+    if (!iface)
+        iface = _iface;
+    else
+        _iface->setAirTime(new AirTime()); // Another channel, with its own utilization and duty cycle
+    interfaces.push_back(_iface);
+    LOG_INFO("Radio %u added, bridge mode %d", (unsigned)interfaces.size() - 1, _iface->bridgeMode);
+}
+
 /**
  * do idle processing
  * Mostly looking in our incoming rxPacket queue and calling handleReceived.
@@ -66,20 +103,66 @@ Router::Router() : concurrency::OSThread("Router"), fromRadioQueue(MAX_RX_FROMRA
 int32_t Router::runOnce()
 {
     meshtastic_MeshPacket *mp;
+#if ARCH_PORTDUINO
+    if (receivePipeline) {
+        // The workers decrypt and decode, everything else still happens here, in the order each node's packets arrived
+        while (receivePipeline->hasRoom() && (mp = fromRadioQueue.dequeuePtr(0)) != NULL)
+            receivePipeline->submit(mp, takeReceivedOn(mp));
+
+        RadioInterface *radio;
+        while ((mp = receivePipeline->poll(&radio)) != NULL)
+            handleFromRadio(mp, radio);
+
+        // The workers can't wake us, so check back soon while they have something
+        return receivePipeline->isIdle() && fromRadioQueue.isEmpty() ? INT32_MAX : 1;
+    }
+#endif
     while ((mp = fromRadioQueue.dequeuePtr(0)) != NULL) {
         // printPacket("handle fromRadioQ", mp);
-        perhapsHandleReceived(mp);
+        handleFromRadio(mp, takeReceivedOn(mp));
     }
 
     // LOG_DEBUG("Sleep forever!");
     return INT32_MAX; // Wait a long time - until we get woken for the message queue
 }
 
+RadioInterface *Router::takeReceivedOn(const meshtastic_MeshPacket *p)
+{
+    auto found = receivedOn.find(p);
+    if (found == receivedOn.end())
+        return NULL;
+
+    RadioInterface *radio = found->second;
+    receivedOn.erase(found);
+    return radio;
+}
+
+void Router::handleFromRadio(meshtastic_MeshPacket *mp, RadioInterface *radio)
+{
+    rxIface = radio;
+    if (PacketAggregator::isAggregate(mp)) {
+        // Several packets shared one frame, handle each of them as if it arrived on its own
+        meshtastic_MeshPacket *unpacked[PACKET_AGGREGATE_MAX_PACKETS];
+        size_t numUnpacked = PacketAggregator::unbundle(mp, unpacked, PACKET_AGGREGATE_MAX_PACKETS);
+        for (size_t i = 0; i < numUnpacked; i++)
+            perhapsHandleReceived(unpacked[i]);
+    } else {
+        perhapsHandleReceived(mp);
+    }
+    rxIface = NULL;
+#if ARCH_PORTDUINO
+    // Many packets are filtered and released before perhapsDecode() takes their decoded payload, and the pool soon hands the
+    // same address out again
+    if (receivePipeline)
+        receivePipeline->forgetCurrent();
+#endif
+}
+
 /**
  * RadioInterface calls this to queue up packets that have been received from the radio.  The router is now responsible for
  * freeing the packet
  */
-void Router::enqueueReceivedMessage(meshtastic_MeshPacket *p)
+void Router::enqueueReceivedMessage(meshtastic_MeshPacket *p, RadioInterface *radio)
 {
     // Try enqueue until successful
     while (!fromRadioQueue.enqueue(p, 0)) {
@@ -87,9 +170,14 @@ void Router::enqueueReceivedMessage(meshtastic_MeshPacket *p)
         old_p = fromRadioQueue.dequeuePtr(0); // Dequeue and discard the oldest packet
         if (old_p) {
             printPacket("fromRadioQ full, drop oldest!", old_p);
+            rxQueueDropped++;
+            receivedOn.erase(old_p);
             packetPool.release(old_p);
         }
     }
+    // With a single radio there is nothing to tell apart, relays and cancels simply use it
+    if (radio && interfaces.size() > 1)
+        receivedOn[p] = radio;
     // Nasty hack because our threading is primitive.  interfaces shouldn't need to know about routers FIXME
     setReceivedMessage();
 }
@@ -161,8 +249,29 @@ meshtastic_QueueStatus Router::getQueueStatus()
         meshtastic_QueueStatus qs;
         qs.res = qs.mesh_packet_id = qs.free = qs.maxlen = 0;
         return qs;
-    } else
-        return iface->getQueueStatus();
+    }
+
+    meshtastic_QueueStatus qs = iface->getQueueStatus();
+    for (auto radio : interfaces) {
+        meshtastic_QueueStatus radioQs = radio->getQueueStatus();
+        if (radioQs.free < qs.free)
+            qs = radioQs;
+    }
+    return qs;
+}
+
+uint32_t Router::getSendMask(const meshtastic_MeshPacket *p)
+{
+    uint32_t mask = 0;
+    for (size_t i = 0; i < interfaces.size(); i++) {
+        RadioInterface *radio = interfaces[i];
+        // Our own packets (and those from MQTT) go out everywhere, relays where they came from and wherever they are bridged to
+        bool wanted = isFromUs(p) || !rxIface || radio == rxIface || radio->bridgeMode == BRIDGE_ALL ||
+                      (radio->bridgeMode == BRIDGE_BROADCASTS && isBroadcast(p->to));
+        if (wanted)
+            mask |= 1 << i;
+    }
+    return mask;
 }
 
 ErrorCode Router::sendLocal(meshtastic_MeshPacket *p, RxSource src)
@@ -213,12 +322,22 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
         return meshtastic_Routing_Error_BAD_REQUEST;
     } // should have already been handled by sendLocal
 
-    // Abort sending if we are violating the duty cycle
+    // Leave out the radios that are over their duty cycle, and abort sending if that is all of them
+    uint32_t sendMask = getSendMask(p);
     if (!config.lora.override_duty_cycle && myRegion->dutyCycle < 100) {
-        float hourlyTxPercent = airTime->utilizationTXPercent();
-        if (hourlyTxPercent > myRegion->dutyCycle) {
+        AirTime *limitedBy = NULL;
+        float hourlyTxPercent = 0;
+        for (size_t i = 0; i < interfaces.size(); i++) {
+            float radioTxPercent = interfaces[i]->getAirTime()->utilizationTXPercent();
+            if ((sendMask & (1 << i)) && radioTxPercent > myRegion->dutyCycle) {
+                sendMask &= ~(1 << i);
+                limitedBy = interfaces[i]->getAirTime();
+                hourlyTxPercent = radioTxPercent;
+            }
+        }
+        if (!sendMask && limitedBy) {
 #ifdef DEBUG_PORT
-            uint8_t silentMinutes = airTime->getSilentMinutes(hourlyTxPercent, myRegion->dutyCycle);
+            uint8_t silentMinutes = limitedBy->getSilentMinutes(hourlyTxPercent, myRegion->dutyCycle);
             LOG_WARN("Duty cycle limit exceeded. Aborting send for now, you can send again in %d mins", silentMinutes);
             meshtastic_ClientNotification *cn = clientNotificationPool.allocZeroed();
             cn->has_reply_id = true;
@@ -263,12 +382,19 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
 
     fixPriority(p); // Before encryption, fix the priority if it's unset
 
+    // Decide while we can still see the portnum
+    bool aggregate = packetAggregator && packetAggregator->wantsPacket(p);
+    meshtastic_PortNum portnum =
+        p->which_payload_variant == meshtastic_MeshPacket_decoded_tag ? p->decoded.portnum : meshtastic_PortNum_UNKNOWN_APP;
+
     // If the packet is not yet encrypted, do so now
     if (p->which_payload_variant == meshtastic_MeshPacket_decoded_tag) {
         ChannelIndex chIndex = p->channel; // keep as a local because we are about to change it
         meshtastic_MeshPacket *p_decoded = packetPool.allocCopy(*p);
 
+        beginStage(ROUTER_STAGE_ENCODE);
         auto encodeResult = perhapsEncode(p);
+        endStage(ROUTER_STAGE_ENCODE);
         if (encodeResult != meshtastic_Routing_Error_NONE) {
             packetPool.release(p_decoded);
             abortSendAndNak(encodeResult, p);
@@ -284,13 +410,48 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
     }
 
     assert(iface); // This should have been detected already in sendLocal (or we just received a packet from outside)
-    return iface->send(p);
+
+    // Every radio but the last one gets its own copy, each has its own TX queue
+    bool fromUs = isFromUs(p);
+    ErrorCode result = ERRNO_NO_INTERFACES;
+    for (size_t i = 0; i < interfaces.size() && sendMask; i++) {
+        if (!(sendMask & (1 << i)))
+            continue;
+        sendMask &= ~(1 << i);
+        RadioInterface *radio = interfaces[i];
+        meshtastic_MeshPacket *radioPacket = sendMask ? packetPool.allocCopy(*p) : p;
+
+        // Relayed packets were already attributed to their portnum when we received them
+        if (fromUs)
+            radio->getAirTime()->logPortAirtime(portnum, radio->getPacketTime(radioPacket));
+
+        // Bundles are per radio, only our main one gets them
+        beginStage(ROUTER_STAGE_ENQUEUE);
+        ErrorCode radioResult =
+            (aggregate && radio == iface) ? packetAggregator->enqueue(radioPacket, radio) : radio->send(radioPacket);
+        endStage(ROUTER_STAGE_ENQUEUE);
+        if (radioPacket == p)
+            result = radioResult; // Our caller needs to know what became of p
+        else if (radioResult == ERRNO_SHOULD_RELEASE)
+            packetPool.release(radioPacket);
+    }
+    return result;
 }
 
 /** Attempt to cancel a previously sent packet.  Returns true if a packet was found we could cancel */
 bool Router::cancelSending(NodeNum from, PacketId id)
 {
-    return iface ? iface->cancelSending(from, id) : false;
+    bool cancelled = false;
+    for (auto radio : interfaces)
+        cancelled |= radio->cancelSending(from, id);
+    return cancelled;
+}
+
+bool Router::cancelRelay(NodeNum from, PacketId id, RadioInterface *heardOn)
+{
+    if (!heardOn)
+        return cancelSending(from, id);
+    return heardOn->cancelSending(from, id);
 }
 
 /**
@@ -329,20 +490,30 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
     memcpy(bytes, p->encrypted.bytes,
            rawSize); // we have to copy into a scratch buffer, because these bytes are a union with the decoded protobuf
     memcpy(ScratchEncrypted, p->encrypted.bytes, rawSize);
+#if ARCH_PORTDUINO
+    // A worker may have done the decrypting and decoding already
+    if (receivePipeline && receivePipeline->takeDecoded(p, &chIndex))
+        decrypted = true;
+#endif
 #if !(MESHTASTIC_EXCLUDE_PKI)
     // Attempt PKI decryption first
-    if (p->channel == 0 && isToUs(p) && p->to > 0 && !isBroadcast(p->to) && nodeDB->getMeshNode(p->from) != nullptr &&
-        nodeDB->getMeshNode(p->from)->user.public_key.size > 0 && nodeDB->getMeshNode(p->to)->user.public_key.size > 0 &&
-        rawSize > MESHTASTIC_PKC_OVERHEAD) {
+    if (!decrypted && p->channel == 0 && isToUs(p) && p->to > 0 && !isBroadcast(p->to) &&
+        nodeDB->getMeshNode(p->from) != nullptr && nodeDB->getMeshNode(p->from)->user.public_key.size > 0 &&
+        nodeDB->getMeshNode(p->to)->user.public_key.size > 0 && rawSize > MESHTASTIC_PKC_OVERHEAD) {
         LOG_DEBUG("Attempt PKI decryption");
 
-        if (crypto->decryptCurve25519(p->from, nodeDB->getMeshNode(p->from)->user.public_key, p->id, rawSize, ScratchEncrypted,
-                                      bytes)) {
+        beginStage(ROUTER_STAGE_DECRYPT);
+        bool pkiDecrypted = crypto->decryptCurve25519(p->from, nodeDB->getMeshNode(p->from)->user.public_key, p->id, rawSize,
+                                                      ScratchEncrypted, bytes);
+        endStage(ROUTER_STAGE_DECRYPT);
+        if (pkiDecrypted) {
             LOG_INFO("PKI Decryption worked!");
             memset(&p->decoded, 0, sizeof(p->decoded));
             rawSize -= MESHTASTIC_PKC_OVERHEAD;
-            if (pb_decode_from_bytes(bytes, rawSize, &meshtastic_Data_msg, &p->decoded) &&
-                p->decoded.portnum != meshtastic_PortNum_UNKNOWN_APP) {
+            beginStage(ROUTER_STAGE_DECODE);
+            bool pkiDecoded = pb_decode_from_bytes(bytes, rawSize, &meshtastic_Data_msg, &p->decoded);
+            endStage(ROUTER_STAGE_DECODE);
+            if (pkiDecoded && p->decoded.portnum != meshtastic_PortNum_UNKNOWN_APP) {
                 decrypted = true;
                 LOG_INFO("Packet decrypted using PKI!");
                 p->pki_encrypted = true;
@@ -367,13 +538,18 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
             // Try to use this hash/channel pair
             if (channels.decryptForHash(chIndex, p->channel)) {
                 // Try to decrypt the packet if we can
+                beginStage(ROUTER_STAGE_DECRYPT);
                 crypto->decrypt(p->from, p->id, rawSize, bytes);
+                endStage(ROUTER_STAGE_DECRYPT);
 
                 // printBytes("plaintext", bytes, p->encrypted.size);
 
                 // Take those raw bytes and convert them back into a well structured protobuf we can understand
                 memset(&p->decoded, 0, sizeof(p->decoded));
-                if (!pb_decode_from_bytes(bytes, rawSize, &meshtastic_Data_msg, &p->decoded)) {
+                beginStage(ROUTER_STAGE_DECODE);
+                bool pbDecoded = pb_decode_from_bytes(bytes, rawSize, &meshtastic_Data_msg, &p->decoded);
+                endStage(ROUTER_STAGE_DECODE);
+                if (!pbDecoded) {
                     LOG_ERROR("Invalid protobufs in received mesh packet id=0x%08x (bad psk?)!", p->id);
                 } else if (p->decoded.portnum == meshtastic_PortNum_UNKNOWN_APP) {
                     LOG_ERROR("Invalid portnum (bad psk?)!");
@@ -391,25 +567,26 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
         if (p->decoded.has_bitfield)
             p->decoded.want_response |= p->decoded.bitfield & BITFIELD_WANT_RESPONSE_MASK;
 
-        /* Not actually ever used.
-        // Decompress if needed. jm
+        // Decompress if needed, the rest of the firmware (and the phone) only ever sees the plain text port
         if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP) {
-            // Decompress the payload
-            char compressed_in[meshtastic_Constants_DATA_PAYLOAD_LEN] = {};
             char decompressed_out[meshtastic_Constants_DATA_PAYLOAD_LEN] = {};
-            int decompressed_len;
-
-            memcpy(compressed_in, p->decoded.payload.bytes, p->decoded.payload.size);
-
-            decompressed_len = unishox2_decompress_simple(compressed_in, p->decoded.payload.size, decompressed_out);
-
-            // LOG_DEBUG("**Decompressed length - %d ", decompressed_len);
+            int decompressed_len = unishox2_decompress((const char *)p->decoded.payload.bytes, p->decoded.payload.size,
+                                                       decompressed_out, sizeof(decompressed_out), USX_PSET_DFLT);
+            if (decompressed_len < 0 || decompressed_len > (int)sizeof(decompressed_out)) {
+                LOG_ERROR("Invalid compressed text from 0x%x", p->from);
+                return false;
+            }
 
+            compressedFrom = p->from;
+            compressedId = p->id;
+            compressedPayload = p->decoded.payload;
             memcpy(p->decoded.payload.bytes, decompressed_out, decompressed_len);
-
-            // Switch the port from PortNum_TEXT_MESSAGE_COMPRESSED_APP to PortNum_TEXT_MESSAGE_APP
+            p->decoded.payload.size = decompressed_len;
             p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
-        } */
+        }
+
+        // Likewise, telemetry sent as only the metrics that changed is filled in from that node's last full report
+        telemetryDeltaCache.handleReceived(p);
 
         printPacket("decoded message", p);
 #if ENABLE_JSON_LOGGING
@@ -426,6 +603,16 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
     }
 }
 
+void restoreCompressedForRelay(meshtastic_MeshPacket *p)
+{
+    if (p->which_payload_variant != meshtastic_MeshPacket_decoded_tag ||
+        p->decoded.portnum != meshtastic_PortNum_TEXT_MESSAGE_APP || p->from != compressedFrom || p->id != compressedId)
+        return;
+
+    p->decoded.payload = compressedPayload;
+    p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP;
+}
+
 /** Return 0 for success or a Routing_Error code for failure
  */
 meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p)
@@ -440,44 +627,25 @@ meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p)
             p->decoded.has_bitfield = true;
             p->decoded.bitfield |= (config.lora.config_ok_to_mqtt << BITFIELD_OK_TO_MQTT_SHIFT);
             p->decoded.bitfield |= (p->decoded.want_response << BITFIELD_WANT_RESPONSE_SHIFT);
+            p->decoded.bitfield |= BITFIELD_DECOMPRESS_OK_MASK;
         }
 
-        size_t numbytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_Data_msg, &p->decoded);
-
-        /* Not actually used, so save the cycles
-        //  TODO: Allow modules to opt into compression.
-        if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP) {
+        // Compress text we send directly to nodes that told us they can decompress it, but only if it actually gets smaller
+        if (isFromUs(p) && p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP && !isBroadcast(p->to) &&
+            nodeDB->canDecompress(p->to)) {
+            char compressed_out[meshtastic_Constants_DATA_PAYLOAD_LEN] = {};
+            int compressed_len = unishox2_compress((const char *)p->decoded.payload.bytes, p->decoded.payload.size,
+                                                   compressed_out, sizeof(compressed_out), USX_PSET_DFLT);
 
-            char original_payload[meshtastic_Constants_DATA_PAYLOAD_LEN];
-            memcpy(original_payload, p->decoded.payload.bytes, p->decoded.payload.size);
-
-            char compressed_out[meshtastic_Constants_DATA_PAYLOAD_LEN] = {0};
-
-            int compressed_len;
-            compressed_len = unishox2_compress_simple(original_payload, p->decoded.payload.size, compressed_out);
-
-            LOG_DEBUG("Original length - %d ", p->decoded.payload.size);
-            LOG_DEBUG("Compressed length - %d ", compressed_len);
-            LOG_DEBUG("Original message - %s ", p->decoded.payload.bytes);
-
-            // If the compressed length is greater than or equal to the original size, don't use the compressed form
-            if (compressed_len >= p->decoded.payload.size) {
-
-                LOG_DEBUG("Not using compressing message");
-                // Set the uncompressed payload variant anyway. Shouldn't hurt?
-                // p->decoded.which_payloadVariant = Data_payload_tag;
-
-                // Otherwise we use the compressor
-            } else {
-                LOG_DEBUG("Use compressed message");
-                // Copy the compressed data into the meshpacket
-
-                p->decoded.payload.size = compressed_len;
+            if (compressed_len > 0 && compressed_len < (int)p->decoded.payload.size) {
+                LOG_DEBUG("Use compressed text, %d bytes instead of %d", compressed_len, p->decoded.payload.size);
                 memcpy(p->decoded.payload.bytes, compressed_out, compressed_len);
-
+                p->decoded.payload.size = compressed_len;
                 p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP;
             }
-        } */
+        }
+
+        size_t numbytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_Data_msg, &p->decoded);
 
         if (numbytes + MESHTASTIC_HEADER_LENGTH > MAX_LORA_PAYLOAD_LEN)
             return meshtastic_Routing_Error_TOO_LARGE;
@@ -577,6 +745,15 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
 
     // Take those raw bytes and convert them back into a well structured protobuf we can understand
     bool decoded = perhapsDecode(p);
+#if ARCH_PORTDUINO
+    if (packetCapture && src == RX_SRC_RADIO) {
+        char result[48] = "not decoded";
+        if (decoded)
+            snprintf(result, sizeof(result), "decoded channel=%u portnum=%d%s", p->channel, p->decoded.portnum,
+                     p->pki_encrypted ? " pki" : "");
+        capturePacket(p_encrypted, result);
+    }
+#endif
     if (decoded) {
         // parsing was successful, queue for our recipient
         if (src == RX_SRC_LOCAL)
@@ -613,9 +790,16 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
         printPacket("packet decoding failed or skipped (no PSK?)", p);
     }
 
+    RadioInterface *radio = rxIface ? rxIface : iface;
+    if (src == RX_SRC_RADIO && radio)
+        radio->getAirTime()->logPortAirtime(decoded ? p->decoded.portnum : meshtastic_PortNum_UNKNOWN_APP,
+                                            radio->getPacketTime(p_encrypted));
+
     // call modules here
     if (!skipHandle) {
+        beginStage(ROUTER_STAGE_MODULES);
         MeshModule::callModules(*p, src);
+        endStage(ROUTER_STAGE_MODULES);
 
 #if !MESHTASTIC_EXCLUDE_MQTT
         // Mark as pki_encrypted if it is not yet decoded and MQTT encryption is also enabled, hash matches and it's a DM not to
@@ -631,6 +815,45 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
     packetPool.release(p_encrypted); // Release the encrypted packet
 }
 
+bool Router::wantsEveryFrame()
+{
+#if ENABLE_JSON_LOGGING
+    return true; // Even ignored packets get logged in the trace, see perhapsHandleReceived()
+#elif ARCH_PORTDUINO
+    return packetCapture || settingsStrings[traceFilename] != "" || settingsMap[logoutputlevel] == level_trace;
+#else
+    return false;
+#endif
+}
+
+bool Router::shouldDropReceivedHeader(const PacketHeader &h, uint32_t airtimeMsec, RadioInterface *radio)
+{
+    if (wantsEveryFrame())
+        return false;
+
+    // Same checks as perhapsHandleReceived(), keep them in sync
+    bool ignore = is_in_repeated(config.lora.ignore_incoming, h.from) || h.from == NODENUM_BROADCAST ||
+                  (config.lora.ignore_mqtt && (h.flags & PACKET_FLAGS_VIA_MQTT_MASK));
+    if (!ignore) {
+        meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(h.from);
+        ignore = node != NULL && node->is_ignored;
+    }
+
+    if (ignore) {
+        LOG_DEBUG("Ignore frame from 0x%x before decoding, id=0x%x", h.from, h.id);
+        rxEarlyIgnored++;
+    }
+    return ignore;
+}
+
+void Router::capturePacket(const meshtastic_MeshPacket *p, const char *result)
+{
+#if ARCH_PORTDUINO
+    if (packetCapture)
+        packetCapture->record(p, rxIface, result);
+#endif
+}
+
 void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
 {
 #if ENABLE_JSON_LOGGING
@@ -647,6 +870,7 @@ void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
     // assert(radioConfig.has_preferences);
     if (is_in_repeated(config.lora.ignore_incoming, p->from)) {
         LOG_DEBUG("Ignore msg, 0x%x is in our ignore list", p->from);
+        capturePacket(p, "ignored node");
         packetPool.release(p);
         return;
     }
@@ -654,24 +878,31 @@ void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
     meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(p->from);
     if (node != NULL && node->is_ignored) {
         LOG_DEBUG("Ignore msg, 0x%x is ignored", p->from);
+        capturePacket(p, "ignored node");
         packetPool.release(p);
         return;
     }
 
     if (p->from == NODENUM_BROADCAST) {
         LOG_DEBUG("Ignore msg from broadcast address");
+        capturePacket(p, "from broadcast address");
         packetPool.release(p);
         return;
     }
 
     if (config.lora.ignore_mqtt && p->via_mqtt) {
         LOG_DEBUG("Msg came in via MQTT from 0x%x", p->from);
+        capturePacket(p, "ignored, via MQTT");
         packetPool.release(p);
         return;
     }
 
-    if (shouldFilterReceived(p)) {
+    beginStage(ROUTER_STAGE_DEDUP);
+    bool filtered = shouldFilterReceived(p);
+    endStage(ROUTER_STAGE_DEDUP);
+    if (filtered) {
         LOG_DEBUG("Incoming msg was filtered from 0x%x", p->from);
+        capturePacket(p, "filtered (duplicate)");
         packetPool.release(p);
         return;
     }
@@ -7,6 +7,34 @@
 #include "PointerQueue.h"
 #include "RadioInterface.h"
 #include "concurrency/OSThread.h"
+#include <unordered_map>
+#include <vector>
+
+/// The stages of handling a packet a RouterProfiler is told about
+enum RouterStage {
+    ROUTER_STAGE_DEDUP,   // shouldFilterReceived()
+    ROUTER_STAGE_DECRYPT, // channel or PKI decryption
+    ROUTER_STAGE_DECODE,  // decoding the Data protobuf
+    ROUTER_STAGE_MODULES, // MeshModule::callModules()
+    ROUTER_STAGE_ENCODE,  // perhapsEncode() of a packet we send or relay
+    ROUTER_STAGE_ENQUEUE, // handing it to a radio's TX queue
+    NUM_ROUTER_STAGES
+};
+
+/**
+ * Told when each stage of handling a packet begins and ends, so a benchmark can see where the time goes (see
+ * test/test_router_bench).  Stages nest: a relay is encoded and enqueued from within module dispatch.
+ */
+class RouterProfiler
+{
+  public:
+    virtual ~RouterProfiler() {}
+    virtual void beginStage(RouterStage stage) = 0;
+    virtual void endStage(RouterStage stage) = 0;
+};
+
+/// NULL unless something is profiling the Router
+extern RouterProfiler *routerProfiler;
 
 /**
  * A mesh aware router that supports multiple interfaces.
@@ -18,9 +46,31 @@ class Router : protected concurrency::OSThread
     /// forwarded to the phone.
     PointerQueue<meshtastic_MeshPacket> fromRadioQueue;
 
+    /// The radio each packet in fromRadioQueue came in on, only kept when we have more than one
+    std::unordered_map<const meshtastic_MeshPacket *, RadioInterface *> receivedOn;
+
+    /// Remove and return the radio p came in on, NULL if we don't know
+    RadioInterface *takeReceivedOn(const meshtastic_MeshPacket *p);
+
+    /// Handle a packet from fromRadioQueue, unbundling it first if it is an aggregate
+    void handleFromRadio(meshtastic_MeshPacket *mp, RadioInterface *radio);
+
+    /// Write a packet we received to the packet capture, if we keep one, with what we made of it
+    void capturePacket(const meshtastic_MeshPacket *p, const char *result);
+
   protected:
+    /// Our main radio, which everything that only knows about one radio (like retransmission timing) goes by
     RadioInterface *iface = NULL;
 
+    /// All our radios, iface first
+    std::vector<RadioInterface *> interfaces;
+
+    /// The radio the packet we are handling came in on, NULL if we don't know or it didn't come from a radio
+    RadioInterface *rxIface = NULL;
+
+    /// Whether every frame we hear has to make it to perhapsHandleReceived(), for the trace or the packet capture
+    bool wantsEveryFrame();
+
   public:
     /**
      * Constructor
@@ -29,9 +79,10 @@ class Router : protected concurrency::OSThread
     Router();
 
     /**
-     * Currently we only allow one interface, that may change in the future
+     * Add a radio, the first one is our main radio.  Packets from us go out on all of them, packets we relay on the one they
+     * came in on and on the others that bridge them (see RadioBridgeMode).
      */
-    void addInterface(RadioInterface *_iface) { iface = _iface; }
+    void addInterface(RadioInterface *_iface);
 
     /**
      * do idle processing
@@ -55,7 +106,7 @@ class Router : protected concurrency::OSThread
      */
     meshtastic_MeshPacket *allocForSending();
 
-    /** Return Underlying interface's TX queue status */
+    /** Return the TX queue status of the fullest radio, as our own packets have to fit in all of them */
     meshtastic_QueueStatus getQueueStatus();
 
     /**
@@ -70,8 +121,10 @@ class Router : protected concurrency::OSThread
     /**
      * RadioInterface calls this to queue up packets that have been received from the radio.  The router is now responsible for
      * freeing the packet
+     *
+     * @param radio the radio that received it, NULL for packets from elsewhere (e.g. MQTT)
      */
-    void enqueueReceivedMessage(meshtastic_MeshPacket *p);
+    void enqueueReceivedMessage(meshtastic_MeshPacket *p, RadioInterface *radio = NULL);
 
     /**
      * Send a packet on a suitable interface.  This routine will
@@ -82,10 +135,27 @@ class Router : protected concurrency::OSThread
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p);
 
+    /**
+     * Called by the radio for every frame it receives, with only the raw header decoded and before a MeshPacket is
+     * allocated for it.  Does the cheap checks perhapsHandleReceived() and shouldFilterReceived() would do later (and their
+     * bookkeeping), so duplicates and frames from ignored nodes never cost us a packet from the pool.
+     *
+     * @param airtimeMsec how long the frame was on air
+     * @param radio the radio that heard it
+     * @return true to drop the frame right away, false to deliver it as usual
+     */
+    virtual bool shouldDropReceivedHeader(const PacketHeader &h, uint32_t airtimeMsec, RadioInterface *radio);
+
     /* Statistics for the amount of duplicate received packets and the amount of times we cancel a relay because someone did it
         before us */
     uint32_t rxDupe = 0, txRelayCanceled = 0;
 
+    /* Statistics for frames dropped by shouldDropReceivedHeader(), early dupes are counted in rxDupe as well */
+    uint32_t rxEarlyDupe = 0, rxEarlyIgnored = 0;
+
+    /* Statistics for received packets dropped because fromRadioQueue was full */
+    uint32_t rxQueueDropped = 0;
+
   protected:
     friend class RoutingModule;
 
@@ -105,6 +175,13 @@ class Router : protected concurrency::OSThread
      */
     virtual void sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Routing *c);
 
+    /**
+     * Someone else relayed a packet on radio heardOn (NULL if we don't know which), cancel our own relay of it there.  Our
+     * bridged copies on the other radios still need to go out.
+     * @return true if a packet was found we could cancel
+     */
+    bool cancelRelay(NodeNum from, PacketId id, RadioInterface *heardOn);
+
     /**
      * Send an ack or a nak packet back towards whoever sent idFrom
      */
@@ -133,6 +210,9 @@ class Router : protected concurrency::OSThread
 
     /** Frees the provided packet, and generates a NAK indicating the specifed error while sending */
     void abortSendAndNak(meshtastic_Routing_Error err, meshtastic_MeshPacket *p);
+
+    /** The radios p should go out on, as a bitmask of indices into interfaces */
+    uint32_t getSendMask(const meshtastic_MeshPacket *p);
 };
 
 /** FIXME - move this into a mesh packet class
@@ -142,6 +222,9 @@ class Router : protected concurrency::OSThread
  */
 bool perhapsDecode(meshtastic_MeshPacket *p);
 
+/// If p is a copy of the text message perhapsDecode() last decompressed, put the compressed payload it arrived with back
+void restoreCompressedForRelay(meshtastic_MeshPacket *p);
+
 /** Return 0 for success or a Routing_Error code for failure
  */
 meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p);
@@ -152,7 +235,14 @@ extern Router *router;
 // FIXME, move this someplace better
 PacketId generatePacketId();
 
+#define BITFIELD_TELEMETRY_DELTA_SHIFT 4
+#define BITFIELD_TELEMETRY_KEYFRAME_SHIFT 3
+#define BITFIELD_DECOMPRESS_OK_SHIFT 2
 #define BITFIELD_WANT_RESPONSE_SHIFT 1
 #define BITFIELD_OK_TO_MQTT_SHIFT 0
+// Telemetry carrying only the metrics that changed, and the full reports those build on
+#define BITFIELD_TELEMETRY_DELTA_MASK (1 << BITFIELD_TELEMETRY_DELTA_SHIFT)
+#define BITFIELD_TELEMETRY_KEYFRAME_MASK (1 << BITFIELD_TELEMETRY_KEYFRAME_SHIFT)
+#define BITFIELD_DECOMPRESS_OK_MASK (1 << BITFIELD_DECOMPRESS_OK_SHIFT) // sender understands TEXT_MESSAGE_COMPRESSED_APP
 #define BITFIELD_WANT_RESPONSE_MASK (1 << BITFIELD_WANT_RESPONSE_SHIFT)
 #define BITFIELD_OK_TO_MQTT_MASK (1 << BITFIELD_OK_TO_MQTT_SHIFT)
\ No newline at end of file
@@ -293,7 +293,7 @@ template <typename T> void SX126xInterface<T>::startReceive()
     RadioLibInterface::startReceive();
 
     // Must be done AFTER, starting transmit, because startTransmit clears (possibly stale) interrupt pending register bits
-    enableInterrupt(isrRxLevel0);
+    enableInterrupt(getRxIsr());
 #endif
 }
 
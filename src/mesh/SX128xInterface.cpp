@@ -267,7 +267,7 @@ template <typename T> void SX128xInterface<T>::startReceive()
     RadioLibInterface::startReceive();
 
     // Must be done AFTER, starting transmit, because startTransmit clears (possibly stale) interrupt pending register bits
-    enableInterrupt(isrRxLevel0);
+    enableInterrupt(getRxIsr());
 #endif
 }
 
@@ -23,6 +23,12 @@ class SinglePortModule : public MeshModule
      */
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override { return p->decoded.portnum == ourPortNum; }
 
+    /**
+     * Subclasses that override wantPacket() to accept other portnums must also override this to return
+     * meshtastic_PortNum_UNKNOWN_APP
+     */
+    virtual meshtastic_PortNum getDispatchPortNum() override { return ourPortNum; }
+
     /**
      * Return a mesh packet which has been preinited as a data packet with a particular port number.
      * You can then send this packet (after customizing any of the payload fields you might need) with
@@ -1,6 +1,8 @@
 #if !MESHTASTIC_EXCLUDE_WEBSERVER
+#include "BootTimeline.h"
 #include "NodeDB.h"
 #include "PowerFSM.h"
+#include "PowerMon.h"
 #include "RadioLibInterface.h"
 #include "airtime.h"
 #include "main.h"
@@ -48,10 +50,17 @@ using namespace httpsserver;
 
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
+#include <map>
 HTTPClient httpClient;
 
 #define DEST_FS_USES_LITTLEFS
 
+// Most we send in one batched fromradio response, so a big backlog doesn't hold up the main loop for too long
+#define HTTP_FROMRADIO_BATCH_MAX_BYTES 4096
+
+// How long browsers may use static assets (not pages) without asking us again, in seconds
+#define STATIC_FILE_MAX_AGE "3600"
+
 // We need to specify some content-type mapping, so the resources get delivered with the
 // right content type and are displayed correctly in the browser
 char contentTypes[][2][32] = {{".txt", "text/plain"},     {".html", "text/html"},
@@ -66,6 +75,47 @@ char contentTypes[][2][32] = {{".txt", "text/plain"},     {".html", "text/html"}
 // Our API to handle messages to and from the radio.
 HttpAPI webAPI;
 
+/// ETag of a static file, the hash is only good for as long as the file keeps its size and nothing was uploaded or deleted
+struct StaticFileTag {
+    size_t size;
+    std::string etag;
+};
+
+static std::map<std::string, StaticFileTag> staticFileTags;
+
+/// Forget the ETags of the static files, after their content may have changed
+static void clearStaticFileTags()
+{
+    staticFileTags.clear();
+}
+
+/**
+ * Get the ETag of an open file, hashing its content only the first time we see it
+ */
+static const std::string &getStaticFileTag(const std::string &filename, File &file)
+{
+    auto it = staticFileTags.find(filename);
+    if (it != staticFileTags.end() && it->second.size == file.size())
+        return it->second.etag;
+
+    // FNV-1a over the content, so the tag changes whenever the content does
+    uint32_t hash = 2166136261u;
+    uint8_t buffer[512];
+    size_t length;
+    while ((length = file.read(buffer, sizeof(buffer))) > 0) {
+        for (size_t i = 0; i < length; i++)
+            hash = (hash ^ buffer[i]) * 16777619u;
+    }
+    file.seek(0);
+
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%08x-%x\"", (unsigned)hash, (unsigned)file.size());
+    StaticFileTag &tag = staticFileTags[filename];
+    tag.size = file.size();
+    tag.etag = etag;
+    return tag.etag;
+}
+
 void registerHandlers(HTTPServer *insecureServer, HTTPSServer *secureServer)
 {
 
@@ -174,6 +224,19 @@ void handleAPIv1FromRadio(HTTPRequest *req, HTTPResponse *res)
 
     uint8_t txBuf[MAX_STREAM_BUF_SIZE];
     uint32_t len = 1;
+    std::string valueBatch;
+
+    if (params->getQueryParameter("batch", valueBatch) && valueBatch == "true") {
+        // Everything we have (up to a limit), each FromRadio preceded by its length as a little endian uint16.  We can't
+        // hold the request open until data arrives like the portduino server does, the web server runs on the main loop.
+        uint32_t total = 0;
+        while (total < HTTP_FROMRADIO_BATCH_MAX_BYTES && (len = webAPI.getFromRadioBatch(txBuf, sizeof(txBuf))) > 0) {
+            res->write(txBuf, len);
+            total += len;
+        }
+        LOG_DEBUG("webAPI handleAPIv1FromRadio, batch of %u bytes", total);
+        return;
+    }
 
     if (params->getQueryParameter("all", valueAll)) {
 
@@ -349,7 +412,9 @@ void handleFsDeleteStatic(HTTPRequest *req, HTTPResponse *res)
     res->setHeader("Access-Control-Allow-Methods", "DELETE");
     if (params->getQueryParameter("delete", paramValDelete)) {
         std::string pathDelete = "/" + paramValDelete;
+        clearStaticFileTags();
         if (FSCom.remove(pathDelete.c_str())) {
+            updateFilesManifest(pathDelete.c_str());
             LOG_INFO("%s", pathDelete.c_str());
             JSONObject jsonObjOuter;
             jsonObjOuter["status"] = new JSONValue("ok");
@@ -391,20 +456,27 @@ void handleStatic(HTTPRequest *req, HTTPResponse *res)
             filenameGzip = "/static/index.html.gz";
         }
 
-        if (FSCom.exists(filename.c_str())) {
-            file = FSCom.open(filename.c_str());
-            if (!file.available()) {
-                LOG_WARN("File not available - %s", filename.c_str());
-            }
-        } else if (FSCom.exists(filenameGzip.c_str())) {
+        // The web client build ships gzipped files, send those to every client that can take them
+        bool acceptsGzip = req->getHeader("Accept-Encoding").find("gzip") != std::string::npos;
+        std::string servedFilename;
+
+        if (FSCom.exists(filenameGzip.c_str()) && (acceptsGzip || !FSCom.exists(filename.c_str()))) {
+            servedFilename = filenameGzip;
             file = FSCom.open(filenameGzip.c_str());
             res->setHeader("Content-Encoding", "gzip");
             if (!file.available()) {
                 LOG_WARN("File not available - %s", filenameGzip.c_str());
             }
+        } else if (FSCom.exists(filename.c_str())) {
+            servedFilename = filename;
+            file = FSCom.open(filename.c_str());
+            if (!file.available()) {
+                LOG_WARN("File not available - %s", filename.c_str());
+            }
         } else {
             has_set_content_type = true;
             filenameGzip = "/static/index.html.gz";
+            servedFilename = filenameGzip;
             file = FSCom.open(filenameGzip.c_str());
             res->setHeader("Content-Type", "text/html");
             if (!file.available()) {
@@ -419,6 +491,20 @@ void handleStatic(HTTPRequest *req, HTTPResponse *res)
             }
         }
 
+        // Pages are checked with the server on every load (a 304 costs us next to nothing), the assets they load are kept
+        // for a while
+        bool isPage = has_set_content_type || filename.rfind(".html") == filename.size() - 5;
+        res->setHeader("Cache-Control", isPage ? "no-cache" : "public, max-age=" STATIC_FILE_MAX_AGE);
+        res->setHeader("Vary", "Accept-Encoding");
+
+        const std::string &etag = getStaticFileTag(servedFilename, file);
+        res->setHeader("ETag", etag);
+        if (req->getHeader("If-None-Match").find(etag) != std::string::npos) {
+            res->setStatusCode(304);
+            file.close();
+            return;
+        }
+
         res->setHeader("Content-Length", httpsserver::intToString(file.size()));
 
         // Content-Type is guessed using the definition of the contentTypes-table defined above
@@ -440,10 +526,9 @@ void handleStatic(HTTPRequest *req, HTTPResponse *res)
         // Read the file and write it to the HTTP response body
         size_t length = 0;
         do {
-            char buffer[256];
-            length = file.read((uint8_t *)buffer, 256);
-            std::string bufferString(buffer, length);
-            res->write((uint8_t *)bufferString.c_str(), bufferString.size());
+            uint8_t buffer[1024];
+            length = file.read(buffer, sizeof(buffer));
+            res->write(buffer, length);
         } while (length > 0);
 
         file.close();
@@ -535,6 +620,7 @@ void handleFormUpload(HTTPRequest *req, HTTPResponse *res)
 
         // Create a new file to stream the data into
         File file = FSCom.open(pathname.c_str(), FILE_O_WRITE);
+        clearStaticFileTags();
         size_t fileLength = 0;
         didwrite = true;
 
@@ -551,6 +637,7 @@ void handleFormUpload(HTTPRequest *req, HTTPResponse *res)
             if (FSCom.totalBytes() - FSCom.usedBytes() < 51200) {
                 file.flush();
                 file.close();
+                updateFilesManifest(pathname.c_str());
                 res->println("<p>Write aborted! Reserving 50k on filesystem.</p>");
 
                 // enableLoopWDT();
@@ -569,6 +656,7 @@ void handleFormUpload(HTTPRequest *req, HTTPResponse *res)
 
         file.flush();
         file.close();
+        updateFilesManifest(pathname.c_str());
         res->printf("<p>Saved %d bytes to %s</p>", (int)fileLength, pathname.c_str());
     }
     if (!didwrite) {
@@ -629,6 +717,27 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjAirtime["seconds_per_period"] = new JSONValue(int(airTime->getSecondsPerPeriod()));
     jsonObjAirtime["periods_to_log"] = new JSONValue(airTime->getPeriodsToLog());
 
+    // data->airtime->nodes and data->airtime->ports, busiest first over the last hour
+    AirtimeShare shares[AIRTIME_MAX_NODE_SOURCES];
+    JSONArray nodeValues;
+    size_t numShares = airTime->getNodeAirtime(shares, AIRTIME_MAX_NODE_SOURCES);
+    for (size_t i = 0; i < numShares; i++) {
+        JSONObject share;
+        share["node"] = new JSONValue((unsigned int)shares[i].key);
+        share["airtime_ms"] = new JSONValue((unsigned int)shares[i].airtimeMs);
+        nodeValues.push_back(new JSONValue(share));
+    }
+    JSONArray portValues;
+    numShares = airTime->getPortAirtime(shares, AIRTIME_MAX_PORT_SOURCES);
+    for (size_t i = 0; i < numShares; i++) {
+        JSONObject share;
+        share["portnum"] = new JSONValue((int)shares[i].key);
+        share["airtime_ms"] = new JSONValue((unsigned int)shares[i].airtimeMs);
+        portValues.push_back(new JSONValue(share));
+    }
+    jsonObjAirtime["nodes"] = new JSONValue(nodeValues);
+    jsonObjAirtime["ports"] = new JSONValue(portValues);
+
     // data->wifi
     JSONObject jsonObjWifi;
     jsonObjWifi["rssi"] = new JSONValue(WiFi.RSSI());
@@ -652,10 +761,52 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjPower["has_usb"] = new JSONValue(BoolToString(powerStatus->getHasUSB()));
     jsonObjPower["is_charging"] = new JSONValue(BoolToString(powerStatus->getIsCharging()));
 
+    // data->power->energy
+    PowerMonSubsystem subsystems[POWERMON_NUM_SUBSYSTEMS];
+    JSONArray subsystemValues;
+    size_t numSubsystems = powerMon->getSubsystems(subsystems, POWERMON_NUM_SUBSYSTEMS);
+    for (size_t i = 0; i < numSubsystems; i++) {
+        JSONObject subsystem;
+        subsystem["name"] = new JSONValue(subsystems[i].name);
+        subsystem["on_seconds"] = new JSONValue((unsigned int)(subsystems[i].onMs / 1000));
+        subsystem["mah"] = new JSONValue(subsystems[i].mAh);
+        subsystemValues.push_back(new JSONValue(subsystem));
+    }
+    PowerMonWakeups wakeups[8];
+    JSONArray wakeupValues;
+    size_t numWakeups = powerMon->getWakeups(wakeups, 8);
+    for (size_t i = 0; i < numWakeups; i++) {
+        JSONObject wakeup;
+        wakeup["cause"] = new JSONValue(wakeups[i].cause);
+        wakeup["timer"] = new JSONValue((unsigned int)wakeups[i].timer);
+        wakeup["interrupt"] = new JSONValue((unsigned int)wakeups[i].interrupt);
+        wakeupValues.push_back(new JSONValue(wakeup));
+    }
+    JSONObject jsonObjEnergy;
+    jsonObjEnergy["seconds"] = new JSONValue((unsigned int)(powerMon->getTotalMs() / 1000));
+    jsonObjEnergy["mah"] = new JSONValue(powerMon->getTotalMah());
+    jsonObjEnergy["average_ma"] = new JSONValue(powerMon->getAverageMa());
+    jsonObjEnergy["subsystems"] = new JSONValue(subsystemValues);
+    jsonObjEnergy["wakeups"] = new JSONValue(wakeupValues);
+    jsonObjPower["energy"] = new JSONValue(jsonObjEnergy);
+
     // data->device
     JSONObject jsonObjDevice;
     jsonObjDevice["reboot_counter"] = new JSONValue((int)myNodeInfo.reboot_count);
 
+    // data->boot
+    JSONArray bootPhaseValues;
+    for (size_t i = 0; i < bootTimeline.getNumPhases(); i++) {
+        JSONObject phase;
+        phase["name"] = new JSONValue(bootTimeline.getPhase(i).name);
+        phase["end_ms"] = new JSONValue((unsigned int)bootTimeline.getPhase(i).endMs);
+        bootPhaseValues.push_back(new JSONValue(phase));
+    }
+    JSONObject jsonObjBoot;
+    jsonObjBoot["phases"] = new JSONValue(bootPhaseValues);
+    jsonObjBoot["setup_ms"] = new JSONValue((unsigned int)bootTimeline.getSetupDoneMs());
+    jsonObjBoot["first_packet_ms"] = new JSONValue((unsigned int)bootTimeline.getFirstPacketMs());
+
     // data->radio
     JSONObject jsonObjRadio;
     jsonObjRadio["frequency"] = new JSONValue(RadioLibInterface::instance->getFreq());
@@ -669,6 +820,7 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjInner["power"] = new JSONValue(jsonObjPower);
     jsonObjInner["device"] = new JSONValue(jsonObjDevice);
     jsonObjInner["radio"] = new JSONValue(jsonObjRadio);
+    jsonObjInner["boot"] = new JSONValue(jsonObjBoot);
 
     // create json output structure
     JSONObject jsonObjOuter;
@@ -714,6 +866,8 @@ void handleDeleteFsContent(HTTPRequest *req, HTTPResponse *res)
     LOG_INFO("Delete files from /static/* : ");
 
     htmlDeleteDir("/static");
+    clearStaticFileTags();
+    invalidateFilesManifest();
 
     res->println("<p><hr><p><a href=/admin>Back to admin</a>");
 }
@@ -37,14 +37,18 @@ mail:   marchammermann@googlemail.com
 #ifdef PORTDUINO_LINUX_HARDWARE
 #if __has_include(<ulfius.h>)
 #include "PiWebServer.h"
+#include "BootTimeline.h"
+#include "MeshTopology.h"
 #include "NodeDB.h"
 #include "PhoneAPI.h"
 #include "PowerFSM.h"
+#include "PowerMon.h"
 #include "RadioLibInterface.h"
 #include "airtime.h"
 #include "graphics/Screen.h"
 #include "main.h"
 #include "mesh/wifi/WiFiAPClient.h"
+#include "serialization/JSON.h"
 #include "sleep.h"
 #include <openssl/bn.h>
 #include <openssl/evp.h>
@@ -56,8 +60,14 @@ mail:   marchammermann@googlemail.com
 #include <ulfius.h>
 #include <yder.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <list>
 #include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
 
 #include "PortduinoFS.h"
 #include "platform/portduino/PortduinoGlue.h"
@@ -125,13 +135,105 @@ static void callback_static_file_stream_free(void *cls)
     }
 }
 
+/// A static file we have read recently, see STATIC_FILE_CACHE_BYTES
+struct StaticFileCacheEntry {
+    std::string path; // The file we read, the .gz variant if that is what we serve
+    time_t mtime;
+    off_t size;
+    std::string etag;
+    std::string body; // Empty if the file is too big to keep in memory
+};
+
+static std::list<StaticFileCacheEntry> staticFileCache; // Most recently used first
+static size_t staticFileCacheBytes;
+static std::mutex staticFileCacheLock;
+
+/**
+ * Find (or read) the cache entry of a static file and make it the most recently used one.  Files that changed on disk since
+ * we read them are read again.
+ */
+static StaticFileCacheEntry &getStaticFileCacheEntry(const char *path, const struct stat &st)
+{
+    for (auto it = staticFileCache.begin(); it != staticFileCache.end(); ++it) {
+        if (it->path != path)
+            continue;
+        if (it->mtime == st.st_mtime && it->size == st.st_size) {
+            staticFileCache.splice(staticFileCache.begin(), staticFileCache, it);
+            return staticFileCache.front();
+        }
+        staticFileCacheBytes -= it->body.size();
+        staticFileCache.erase(it);
+        break;
+    }
+
+    StaticFileCacheEntry e;
+    e.path = path;
+    e.mtime = st.st_mtime;
+    e.size = st.st_size;
+
+    char etag[48];
+    FILE *f = st.st_size <= STATIC_FILE_CACHE_MAX_FILE_BYTES ? fopen(path, "rb") : NULL;
+    if (f) {
+        e.body.resize(st.st_size);
+        e.body.resize(fread(&e.body[0], 1, e.body.size(), f));
+        fclose(f);
+
+        // A strong tag from the content, FNV-1a
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : e.body)
+            hash = (hash ^ c) * 16777619u;
+        snprintf(etag, sizeof(etag), "\"%08x-%zx\"", hash, e.body.size());
+    } else {
+        // Streamed from disk every time, tag it by its size and modification time like most web servers do
+        snprintf(etag, sizeof(etag), "\"%lx-%lx\"", (unsigned long)st.st_mtime, (unsigned long)st.st_size);
+    }
+    e.etag = etag;
+
+    staticFileCacheBytes += e.body.size();
+    staticFileCache.push_front(std::move(e));
+    while (staticFileCache.size() > 1 &&
+           (staticFileCacheBytes > STATIC_FILE_CACHE_BYTES || staticFileCache.size() > STATIC_FILE_CACHE_MAX_ENTRIES)) {
+        staticFileCacheBytes -= staticFileCache.back().body.size();
+        staticFileCache.pop_back();
+    }
+    return staticFileCache.front();
+}
+
+/**
+ * Answer with a static file from the cache, a 304 if the client has it already or else stream it from disk
+ */
+static void sendStaticFile(const struct _u_request *request, struct _u_response *response, const char *path,
+                           const struct stat &st)
+{
+    std::lock_guard<std::mutex> guard(staticFileCacheLock);
+    StaticFileCacheEntry &e = getStaticFileCacheEntry(path, st);
+
+    u_map_put(response->map_header, "ETag", e.etag.c_str());
+    const char *ifNoneMatch = u_map_get_case(request->map_header, "If-None-Match");
+    if (ifNoneMatch && strstr(ifNoneMatch, e.etag.c_str())) {
+        response->status = 304;
+        return;
+    }
+
+    if (e.body.size() == (size_t)st.st_size) {
+        ulfius_set_binary_body_response(response, 200, e.body.data(), e.body.size());
+        return;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f || ulfius_set_stream_response(response, 200, callback_static_file_stream, callback_static_file_stream_free, st.st_size,
+                                         STATIC_FILE_CHUNK, f) != U_OK) {
+        LOG_DEBUG("callback_static_file - Error ulfius_set_stream_response");
+        if (f)
+            fclose(f);
+    }
+}
+
 /**
  * static file callback endpoint that delivers the content for WebServer calls
  */
 int callback_static_file(const struct _u_request *request, struct _u_response *response, void *user_data)
 {
-    size_t length;
-    FILE *f;
     char *file_requested, *file_path, *url_dup_save, *real_path = NULL;
     const char *content_type;
 
@@ -166,36 +268,35 @@ int callback_static_file(const struct _u_request *request, struct _u_response *r
         }
 
         file_path = msprintf("%s/%s", configWeb.files_path, file_requested);
-        real_path = realpath(file_path, NULL);
-        if (0 == o_strncmp(configWeb.files_path, real_path, o_strlen(configWeb.files_path))) {
-            if (access(file_path, F_OK) != -1) {
-                f = fopen(file_path, "rb");
-                if (f) {
-                    fseek(f, 0, SEEK_END);
-                    length = ftell(f);
-                    fseek(f, 0, SEEK_SET);
-
-                    content_type = u_map_get_case(&configWeb.mime_types, get_filename_ext(file_requested));
-                    if (content_type == NULL) {
-                        content_type = u_map_get(&configWeb.mime_types, "*");
-                        LOG_DEBUG("Static File Server - Unknown mime type for extension %s ", get_filename_ext(file_requested));
-                    }
-                    u_map_put(response->map_header, "Content-Type", content_type);
-                    u_map_copy_into(response->map_header, &configWeb.map_header);
-
-                    if (ulfius_set_stream_response(response, 200, callback_static_file_stream, callback_static_file_stream_free,
-                                                   length, STATIC_FILE_CHUNK, f) != U_OK) {
-                        LOG_DEBUG("callback_static_file - Error ulfius_set_stream_response");
-                    }
-                }
-            } else {
-                if (configWeb.redirect_on_404 == NULL) {
-                    ulfius_set_string_body_response(response, 404, "File not found");
-                } else {
-                    ulfius_add_header_to_response(response, "Location", configWeb.redirect_on_404);
-                    response->status = 302;
-                }
+
+        // Serve the precompressed variant from the web client build to every client that can take it (or if it is all
+        // we have)
+        std::string gzipPath = std::string(file_path) + ".gz";
+        const char *acceptEncoding = u_map_get_case(request->map_header, "Accept-Encoding");
+        bool gzip = access(gzipPath.c_str(), F_OK) != -1 &&
+                    ((acceptEncoding && strstr(acceptEncoding, "gzip")) || access(file_path, F_OK) == -1);
+
+        struct stat st;
+        real_path = realpath(gzip ? gzipPath.c_str() : file_path, NULL);
+        if (real_path && 0 == o_strncmp(configWeb.files_path, real_path, o_strlen(configWeb.files_path)) &&
+            stat(real_path, &st) == 0 && S_ISREG(st.st_mode)) {
+            content_type = u_map_get_case(&configWeb.mime_types, get_filename_ext(file_requested));
+            if (content_type == NULL) {
+                content_type = u_map_get(&configWeb.mime_types, "*");
+                LOG_DEBUG("Static File Server - Unknown mime type for extension %s ", get_filename_ext(file_requested));
             }
+            u_map_put(response->map_header, "Content-Type", content_type);
+            u_map_copy_into(response->map_header, &configWeb.map_header);
+            if (gzip)
+                u_map_put(response->map_header, "Content-Encoding", "gzip");
+            u_map_put(response->map_header, "Vary", "Accept-Encoding");
+
+            // Pages are checked with us on every load (a 304 is cheap), the assets they load are kept for a while
+            const char *ext = get_filename_ext(file_requested);
+            bool isPage = o_strcmp(ext, ".html") == 0 || o_strcmp(ext, ".htm") == 0;
+            u_map_put(response->map_header, "Cache-Control", isPage ? "no-cache" : "public, max-age=" STATIC_FILE_MAX_AGE);
+
+            sendStaticFile(request, response, real_path, st);
         } else {
             if (configWeb.redirect_on_404 == NULL) {
                 ulfius_set_string_body_response(response, 404, "File not found");
@@ -252,6 +353,43 @@ int handleAPIv1ToRadio(const struct _u_request *req, struct _u_response *res, vo
     return U_CALLBACK_COMPLETE;
 }
 
+void HttpAPI::onNowHasData(uint32_t fromRadioNum)
+{
+    PhoneAPI::onNowHasData(fromRadioNum);
+    dataAvailable.notify_all();
+}
+
+bool HttpAPI::waitForData(uint32_t timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true) {
+        // available() takes packets out of the queues too, so it needs readLock like any other reader.  Always readLock first,
+        // then dataLock, but don't keep the other requests from reading while we wait.
+        std::unique_lock<std::mutex> reading(readLock);
+        std::unique_lock<std::mutex> lock(dataLock);
+        if (available())
+            return true;
+        reading.unlock();
+
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        dataAvailable.wait_for(lock, std::chrono::milliseconds(HTTP_FROMRADIO_POLL_MS));
+    }
+}
+
+/**
+ * Fill buf with as many length prefixed FromRadio packets as fit (see PhoneAPI::getFromRadioBatch)
+ */
+static size_t getFromRadioBatched(uint8_t *buf, size_t maxLen)
+{
+    std::lock_guard<std::mutex> guard(webAPI.readLock);
+    size_t total = 0, len;
+    while (maxLen - total >= FROMRADIO_BATCH_MAX_SIZE &&
+           (len = webAPI.getFromRadioBatch(buf + total, FROMRADIO_BATCH_MAX_SIZE)) > 0)
+        total += len;
+    return total;
+}
+
 /*
  * Adapt the radioapi to the Webservice handleAPIv1FromRadio
  * Trigger : WebGui(POLL)->handleAPIv1FromRadio->phoneapi->Meshtastic(Radio) events
@@ -274,8 +412,21 @@ int handleAPIv1FromRadio(const struct _u_request *req, struct _u_response *res,
         return U_CALLBACK_COMPLETE;
     }
 
+    const char *valueWait = u_map_get(req->map_url, "wait");
+    if (valueWait)
+        webAPI.waitForData(std::min<uint32_t>(strtoul(valueWait, NULL, 10), HTTP_FROMRADIO_MAX_WAIT_MS));
+
+    const char *valueBatch = u_map_get(req->map_url, "batch");
+    if (valueBatch && strcmp(valueBatch, "true") == 0) {
+        std::vector<uint8_t> batch(HTTP_FROMRADIO_BATCH_MAX_BYTES);
+        size_t batchLen = getFromRadioBatched(batch.data(), batch.size());
+        ulfius_set_binary_body_response(res, 200, (const char *)batch.data(), batchLen);
+        return U_CALLBACK_COMPLETE;
+    }
+
     uint8_t txBuf[MAX_STREAM_BUF_SIZE];
     uint32_t len = 1;
+    std::lock_guard<std::mutex> guard(webAPI.readLock);
 
     if (valueAll == "true") {
         while (len) {
@@ -301,6 +452,271 @@ int handleAPIv1FromRadio(const struct _u_request *req, struct _u_response *res,
     return U_CALLBACK_COMPLETE;
 }
 
+/// A client following /api/v1/fromradio/events
+struct FromRadioEventStream {
+    std::string pending; // Event text the server hasn't taken yet
+    size_t offset = 0;
+};
+
+/**
+ * Streaming callback of the fromradio event stream, blocks (in the thread of this connection) until there is data to send
+ */
+static ssize_t callback_fromradio_events_stream(void *cls, uint64_t pos, char *buf, size_t max)
+{
+    (void)(pos);
+    auto *stream = (FromRadioEventStream *)cls;
+
+    while (stream->offset >= stream->pending.size()) {
+        stream->pending.clear();
+        stream->offset = 0;
+
+        if (!webAPI.waitForData(HTTP_EVENTS_KEEPALIVE_MS)) {
+            stream->pending = ": keepalive\n\n";
+            break;
+        }
+
+        uint8_t batch[FROMRADIO_BATCH_MAX_SIZE];
+        size_t batchLen = getFromRadioBatched(batch, sizeof(batch));
+        if (!batchLen) {
+            // Another client took it
+            std::this_thread::sleep_for(std::chrono::milliseconds(HTTP_FROMRADIO_POLL_MS));
+            continue;
+        }
+
+        // One event per FromRadio, base64 encoded as event data must be text
+        for (size_t i = 0; i + FROMRADIO_BATCH_HEADER_SIZE <= batchLen;) {
+            size_t len = batch[i] | (batch[i + 1] << 8);
+            i += FROMRADIO_BATCH_HEADER_SIZE;
+
+            unsigned char encoded[(meshtastic_FromRadio_size + 2) / 3 * 4 + 1];
+            size_t encodedLen = 0;
+            if (o_base64_encode(batch + i, len, encoded, &encodedLen)) {
+                stream->pending += "event: fromradio\ndata: ";
+                stream->pending.append((const char *)encoded, encodedLen);
+                stream->pending += "\n\n";
+            }
+            i += len;
+        }
+    }
+
+    size_t len = std::min(max, stream->pending.size() - stream->offset);
+    memcpy(buf, stream->pending.data() + stream->offset, len);
+    stream->offset += len;
+    return len;
+}
+
+static void callback_fromradio_events_stream_free(void *cls)
+{
+    LOG_DEBUG("fromradio event stream closed");
+    delete (FromRadioEventStream *)cls;
+}
+
+/*
+ * Server-Sent Events stream of FromRadio packets, so web clients get packets as they arrive instead of polling
+ */
+int handleAPIv1FromRadioEvents(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    ulfius_add_header_to_response(res, "Content-Type", "text/event-stream");
+    ulfius_add_header_to_response(res, "Cache-Control", "no-cache");
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Origin", "*");
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Methods", "GET");
+
+    if (strcmp(req->http_verb, "OPTIONS") == 0) {
+        ulfius_set_response_properties(res, U_OPT_STATUS, 204);
+        return U_CALLBACK_COMPLETE;
+    }
+
+    LOG_DEBUG("fromradio event stream opened");
+    auto *stream = new FromRadioEventStream();
+    if (ulfius_set_stream_response(res, 200, callback_fromradio_events_stream, callback_fromradio_events_stream_free,
+                                   U_STREAM_SIZE_UNKNOWN, STATIC_FILE_CHUNK, stream) != U_OK) {
+        LOG_ERROR("handleAPIv1FromRadioEvents - Error ulfius_set_stream_response");
+        delete stream;
+        return U_CALLBACK_ERROR;
+    }
+    return U_CALLBACK_COMPLETE;
+}
+
+/*
+ * How long each phase of the boot took, and when we first heard a packet (all in ms since start)
+ */
+int handleJsonBoot(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    JSONArray phaseValues;
+    for (size_t i = 0; i < bootTimeline.getNumPhases(); i++) {
+        JSONObject phase;
+        phase["name"] = new JSONValue(bootTimeline.getPhase(i).name);
+        phase["end_ms"] = new JSONValue((unsigned int)bootTimeline.getPhase(i).endMs);
+        phaseValues.push_back(new JSONValue(phase));
+    }
+
+    JSONObject jsonObjBoot;
+    jsonObjBoot["phases"] = new JSONValue(phaseValues);
+    jsonObjBoot["setup_ms"] = new JSONValue((unsigned int)bootTimeline.getSetupDoneMs());
+    jsonObjBoot["first_packet_ms"] = new JSONValue((unsigned int)bootTimeline.getFirstPacketMs());
+
+    JSONObject jsonObjOuter;
+    jsonObjOuter["data"] = new JSONValue(jsonObjBoot);
+    jsonObjOuter["status"] = new JSONValue("ok");
+    JSONValue *value = new JSONValue(jsonObjOuter);
+    std::string body = value->Stringify();
+    delete value;
+
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    ulfius_set_string_body_response(res, 200, body.c_str());
+    return U_CALLBACK_COMPLETE;
+}
+
+/*
+ * Estimated charge used by each subsystem since boot, and who keeps waking the main loop
+ */
+int handleJsonEnergy(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    PowerMonSubsystem subsystems[POWERMON_NUM_SUBSYSTEMS];
+    JSONArray subsystemValues;
+    size_t numSubsystems = powerMon->getSubsystems(subsystems, POWERMON_NUM_SUBSYSTEMS);
+    for (size_t i = 0; i < numSubsystems; i++) {
+        JSONObject subsystem;
+        subsystem["name"] = new JSONValue(subsystems[i].name);
+        subsystem["on_seconds"] = new JSONValue((unsigned int)(subsystems[i].onMs / 1000));
+        subsystem["mah"] = new JSONValue(subsystems[i].mAh);
+        subsystemValues.push_back(new JSONValue(subsystem));
+    }
+
+    PowerMonWakeups wakeups[MAX_THREADS + POWERMON_MAX_WAKE_CAUSES];
+    JSONArray wakeupValues;
+    size_t numWakeups = powerMon->getWakeups(wakeups, MAX_THREADS + POWERMON_MAX_WAKE_CAUSES);
+    for (size_t i = 0; i < numWakeups; i++) {
+        JSONObject wakeup;
+        wakeup["cause"] = new JSONValue(wakeups[i].cause);
+        wakeup["timer"] = new JSONValue((unsigned int)wakeups[i].timer);
+        wakeup["interrupt"] = new JSONValue((unsigned int)wakeups[i].interrupt);
+        wakeupValues.push_back(new JSONValue(wakeup));
+    }
+
+    PowerMonCombo combos[POWERMON_MAX_COMBOS];
+    JSONArray comboValues;
+    size_t numCombos = powerMon->getCombos(combos, POWERMON_MAX_COMBOS);
+    for (size_t i = 0; i < numCombos; i++) {
+        JSONObject combo;
+        combo["states"] = new JSONValue((unsigned int)combos[i].states);
+        combo["seconds"] = new JSONValue((unsigned int)(combos[i].ms / 1000));
+        comboValues.push_back(new JSONValue(combo));
+    }
+
+    JSONObject jsonObjEnergy;
+    jsonObjEnergy["seconds"] = new JSONValue((unsigned int)(powerMon->getTotalMs() / 1000));
+    jsonObjEnergy["mah"] = new JSONValue(powerMon->getTotalMah());
+    jsonObjEnergy["average_ma"] = new JSONValue(powerMon->getAverageMa());
+    jsonObjEnergy["subsystems"] = new JSONValue(subsystemValues);
+    jsonObjEnergy["wakeups"] = new JSONValue(wakeupValues);
+    jsonObjEnergy["states"] = new JSONValue(comboValues);
+
+    JSONObject jsonObjOuter;
+    jsonObjOuter["data"] = new JSONValue(jsonObjEnergy);
+    jsonObjOuter["status"] = new JSONValue("ok");
+    JSONValue *value = new JSONValue(jsonObjOuter);
+    std::string body = value->Stringify();
+    delete value;
+
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    ulfius_set_string_body_response(res, 200, body.c_str());
+    return U_CALLBACK_COMPLETE;
+}
+
+/*
+ * Channel usage and which nodes and portnums used it over the last hour, busiest first
+ */
+int handleJsonAirtime(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    AirtimeShare shares[AIRTIME_MAX_NODE_SOURCES];
+
+    JSONArray nodeValues;
+    size_t numShares = airTime->getNodeAirtime(shares, AIRTIME_MAX_NODE_SOURCES);
+    for (size_t i = 0; i < numShares; i++) {
+        JSONObject share;
+        share["node"] = new JSONValue((unsigned int)shares[i].key);
+        share["airtime_ms"] = new JSONValue((unsigned int)shares[i].airtimeMs);
+        nodeValues.push_back(new JSONValue(share));
+    }
+
+    JSONArray portValues;
+    numShares = airTime->getPortAirtime(shares, AIRTIME_MAX_PORT_SOURCES);
+    for (size_t i = 0; i < numShares; i++) {
+        JSONObject share;
+        share["portnum"] = new JSONValue((int)shares[i].key);
+        share["airtime_ms"] = new JSONValue((unsigned int)shares[i].airtimeMs);
+        portValues.push_back(new JSONValue(share));
+    }
+
+    JSONObject jsonObjAirtime;
+    jsonObjAirtime["channel_utilization"] = new JSONValue(airTime->channelUtilizationPercent());
+    jsonObjAirtime["utilization_tx"] = new JSONValue(airTime->utilizationTXPercent());
+    jsonObjAirtime["seconds_since_boot"] = new JSONValue((unsigned int)airTime->getSecondsSinceBoot());
+    jsonObjAirtime["nodes"] = new JSONValue(nodeValues);
+    jsonObjAirtime["ports"] = new JSONValue(portValues);
+
+    JSONObject jsonObjOuter;
+    jsonObjOuter["data"] = new JSONValue(jsonObjAirtime);
+    jsonObjOuter["status"] = new JSONValue("ok");
+    JSONValue *value = new JSONValue(jsonObjOuter);
+    std::string body = value->Stringify();
+    delete value;
+
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    ulfius_set_string_body_response(res, 200, body.c_str());
+    return U_CALLBACK_COMPLETE;
+}
+
+/*
+ * The links of the mesh we know about, newest first. With ?from=<node>&to=<node> also the shortest known path between them
+ */
+int handleJsonTopology(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    JSONObject jsonObjTopology;
+
+    if (meshTopology) {
+        std::vector<MeshTopologyEdge> edges(MESH_TOPOLOGY_MAX_EDGES);
+        edges.resize(meshTopology->getAllEdges(edges.data(), edges.size()));
+        uint32_t now = millis();
+
+        JSONArray edgeValues;
+        for (const auto &e : edges) {
+            JSONObject edge;
+            edge["from"] = new JSONValue((unsigned int)e.from);
+            edge["to"] = new JSONValue((unsigned int)e.to);
+            if (e.snr != MESH_TOPOLOGY_SNR_UNKNOWN)
+                edge["snr"] = new JSONValue((float)e.snr / 4);
+            edge["age_secs"] = new JSONValue((unsigned int)((now - e.lastHeardMs) / 1000));
+            edge["sources"] = new JSONValue((int)e.sources);
+            edgeValues.push_back(new JSONValue(edge));
+        }
+        jsonObjTopology["edges"] = new JSONValue(edgeValues);
+
+        const char *from = u_map_get(req->map_url, "from");
+        const char *to = u_map_get(req->map_url, "to");
+        if (from && to) {
+            NodeNum path[HOP_MAX + 2];
+            size_t numNodes = meshTopology->getShortestPath(strtoul(from, NULL, 0), strtoul(to, NULL, 0), path, HOP_MAX + 2);
+            JSONArray pathValues;
+            for (size_t i = 0; i < numNodes; i++)
+                pathValues.push_back(new JSONValue((unsigned int)path[i]));
+            jsonObjTopology["path"] = new JSONValue(pathValues);
+        }
+    }
+
+    JSONObject jsonObjOuter;
+    jsonObjOuter["data"] = new JSONValue(jsonObjTopology);
+    jsonObjOuter["status"] = new JSONValue(meshTopology ? "ok" : "disabled");
+    JSONValue *value = new JSONValue(jsonObjOuter);
+    std::string body = value->Stringify();
+    delete value;
+
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    ulfius_set_string_body_response(res, 200, body.c_str());
+    return U_CALLBACK_COMPLETE;
+}
+
 /*
 OpenSSL RSA Key Gen
 */
@@ -497,10 +913,19 @@ PiWebServerThread::PiWebServerThread()
         u_map_put(instanceWeb.default_headers, "Access-Control-Allow-Origin", "*");
         // Maximum body size sent by the client is 1 Kb
         instanceWeb.max_post_body_size = 1024;
+        // Before the generic fromradio endpoints (priority 0), which would match as well
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/api/v1/fromradio/events", 0, &handleAPIv1FromRadioEvents,
+                                   NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/fromradio/events", 0, &handleAPIv1FromRadioEvents,
+                                   NULL);
         ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/api/v1/fromradio/*", 1, &handleAPIv1FromRadio, NULL);
         ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/fromradio/*", 1, &handleAPIv1FromRadio, NULL);
         ulfius_add_endpoint_by_val(&instanceWeb, "PUT", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, configWeb.rootPath);
         ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/airtime", 1, &handleJsonAirtime, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/topology", 1, &handleJsonTopology, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/boot", 1, &handleJsonBoot, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/energy", 1, &handleJsonEnergy, NULL);
 
         // Add callback function to all endpoints for the Web Server
         ulfius_add_endpoint_by_val(&instanceWeb, "GET", NULL, "/*", 2, &callback_static_file, &configWeb);
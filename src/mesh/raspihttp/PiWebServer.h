@@ -5,10 +5,33 @@
 #include "ulfius-cfg.h"
 #include "ulfius.h"
 #include <Arduino.h>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
 
 #define STATIC_FILE_CHUNK 256
 
+/// Static files we keep in memory (most recently used), so serving the web client doesn't read it from disk every time
+#define STATIC_FILE_CACHE_BYTES (4 * 1024 * 1024)
+#define STATIC_FILE_CACHE_MAX_ENTRIES 128
+/// Bigger files are streamed from disk
+#define STATIC_FILE_CACHE_MAX_FILE_BYTES (1024 * 1024)
+
+/// How long browsers may use static assets (not pages) without asking us again, in seconds
+#define STATIC_FILE_MAX_AGE "3600"
+
+/// Longest a client may hold a fromradio request open (?wait=ms) waiting for data
+#define HTTP_FROMRADIO_MAX_WAIT_MS 30000
+
+/// Most we send in one batched fromradio response (?batch=true)
+#define HTTP_FROMRADIO_BATCH_MAX_BYTES 16384
+
+/// How often a waiting request checks for data that didn't come with a notification (e.g. the config after want_config)
+#define HTTP_FROMRADIO_POLL_MS 100
+
+/// Idle fromradio event streams send a comment this often, so proxies keep them open and we notice clients that left
+#define HTTP_EVENTS_KEEPALIVE_MS 15000
+
 void initWebServer();
 void createSSLCert();
 int callback_static_file(const struct _u_request *request, struct _u_response *response, void *user_data);
@@ -45,14 +68,22 @@ class HttpAPI : public PhoneAPI
 {
 
   public:
-    // Nothing here yet
+    /// Block the calling (web server) thread until we have something for the client or timeoutMs passed
+    bool waitForData(uint32_t timeoutMs);
+
+    /// Each web request runs in its own thread, hold this while taking packets out (including available()), before dataLock
+    std::mutex readLock;
 
   private:
-    // Nothing here yet
+    std::mutex dataLock;
+    std::condition_variable dataAvailable;
 
   protected:
     /// Check the current underlying physical link to see if the client is currently connected
     virtual bool checkIsConnected() override { return true; } // FIXME, be smarter about this
+
+    /// Wake up the requests waiting for data
+    virtual void onNowHasData(uint32_t fromRadioNum) override;
 };
 
 extern PiWebServerThread *piwebServerThread;
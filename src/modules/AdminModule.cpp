@@ -3,6 +3,7 @@
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "PowerFSM.h"
+#include "PowerMon.h"
 #include "RTC.h"
 #include "meshUtils.h"
 #include <FSCommon.h>
@@ -349,6 +350,7 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
 #ifdef FSCom
         if (FSCom.remove(r->delete_file_request)) {
             LOG_DEBUG("Successfully deleted file");
+            updateFilesManifest(r->delete_file_request);
         } else {
             LOG_DEBUG("Failed to delete file");
         }
@@ -751,6 +753,9 @@ void AdminModule::handleGetConfig(const meshtastic_MeshPacket &req, const uint32
             LOG_INFO("Get config: Power");
             res.get_config_response.which_payload_variant = meshtastic_Config_power_tag;
             res.get_config_response.payload_variant.power = config.power;
+            // There is no field for it, so our own client gets the energy estimate as a notification
+            if (powerMon && isFromUs(&req))
+                powerMon->sendSummaryToPhone(req.id);
             break;
         case meshtastic_AdminMessage_ConfigType_NETWORK_CONFIG:
             LOG_INFO("Get config: Network");
@@ -92,6 +92,7 @@ class CannedMessageModule : public SinglePortModule, public Observable<const UIF
             return false;
         }
     }
+    virtual meshtastic_PortNum getDispatchPortNum() override { return meshtastic_PortNum_UNKNOWN_APP; }
 
   protected:
     virtual int32_t runOnce() override;
@@ -54,6 +54,9 @@
 #if HAS_TELEMETRY
 #include "modules/Telemetry/DeviceTelemetry.h"
 #endif
+#if (HAS_SENSOR || HAS_TELEMETRY) && !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
+#include "modules/Telemetry/SensorScheduler.h"
+#endif
 #if HAS_SENSOR && !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
 #include "main.h"
 #include "modules/Telemetry/AirQualityTelemetry.h"
@@ -190,6 +193,9 @@ void setupModules()
 #if HAS_TELEMETRY
         new DeviceTelemetryModule();
 #endif
+#if (HAS_SENSOR || HAS_TELEMETRY) && !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
+        sensorScheduler = new SensorScheduler();
+#endif
 #if HAS_SENSOR && !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
         new EnvironmentTelemetryModule();
         if (nodeTelemetrySensorsMap[meshtastic_TelemetrySensorType_PMSA003I].first > 0) {
@@ -1,9 +1,11 @@
 #include "NeighborInfoModule.h"
 #include "Default.h"
 #include "MeshService.h"
+#include "MeshTopology.h"
 #include "NodeDB.h"
 #include "RTC.h"
 #include <Throttle.h>
+#include <algorithm>
 
 NeighborInfoModule *neighborInfoModule;
 
@@ -136,9 +138,19 @@ Pass it to an upper client; do not persist this data on the mesh
 */
 bool NeighborInfoModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshtastic_NeighborInfo *np)
 {
+    // Our own client asking for the mesh map, the NeighborInfo packets we send it are the response
+    bool isTopologyRequest = np && isFromUs(&mp) && isToUs(&mp) && mp.decoded.want_response;
+    ignoreRequest = isTopologyRequest;
+    if (isTopologyRequest) {
+        sendTopologyToPhone();
+        return true;
+    }
+
     if (np) {
         printNeighborInfo("RECEIVED", np);
         updateNeighbors(mp, np);
+        if (meshTopology)
+            meshTopology->addNeighborInfo(np);
     } else if (mp.hop_start != 0 && mp.hop_start == mp.hop_limit) {
         // If the hopLimit is the same as hopStart, then it is a neighbor
         getOrCreateNeighbor(mp.from, mp.from, 0, mp.rx_snr); // Set the broadcast interval to 0, as we don't know it
@@ -147,6 +159,70 @@ bool NeighborInfoModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp,
     return false;
 }
 
+/*
+Send what we know about the mesh topology to the phone, as one NeighborInfo per node that hears others.
+Only nodes with links that changed since the last export to this client are sent, the ones that changed longest ago first,
+and at most MAX_TOPOLOGY_EXPORT_PACKETS per request so we don't overrun the queue to the phone. The client asks again for the
+rest.
+*/
+void NeighborInfoModule::sendTopologyToPhone()
+{
+    if (!meshTopology) {
+        LOG_WARN("Mesh topology is not tracked on this device");
+        return;
+    }
+
+    std::vector<MeshTopologyEdge> edges(MESH_TOPOLOGY_MAX_EDGES);
+    edges.resize(meshTopology->getAllEdges(edges.data(), edges.size()));
+
+    // Edges come newest first, so the first one we see for a node is its most recent change.  Nodes that changed at the
+    // same time are exported in node order, so a request that stops between them knows where to go on.
+    uint32_t now = millis();
+    uint32_t exportedAge = now - lastTopologyExportMs;
+    std::vector<MeshTopologyEdge> newestPerNode;
+    for (const auto &e : edges) {
+        bool known = std::any_of(newestPerNode.begin(), newestPerNode.end(),
+                                 [&e](const MeshTopologyEdge &n) { return n.to == e.to; });
+        uint32_t age = now - e.lastHeardMs;
+        bool isNew = !topologyExportStarted || age < exportedAge || (age == exportedAge && e.to > lastTopologyExportNode);
+        if (!known && isNew)
+            newestPerNode.push_back(e);
+    }
+    std::sort(newestPerNode.begin(), newestPerNode.end(), [now](const MeshTopologyEdge &a, const MeshTopologyEdge &b) {
+        uint32_t ageA = now - a.lastHeardMs, ageB = now - b.lastHeardMs;
+        return ageA != ageB ? ageA > ageB : a.to < b.to;
+    });
+    if (newestPerNode.size() > MAX_TOPOLOGY_EXPORT_PACKETS)
+        newestPerNode.resize(MAX_TOPOLOGY_EXPORT_PACKETS);
+
+    uint32_t rxTime = getValidTime(RTCQualityFromNet);
+    for (const auto &n : newestPerNode) {
+        meshtastic_NeighborInfo neighborInfo = meshtastic_NeighborInfo_init_zero;
+        neighborInfo.node_id = n.to;
+        neighborInfo.last_sent_by_id = nodeDB->getNodeNum();
+        for (const auto &e : edges) {
+            if (e.to != n.to || neighborInfo.neighbors_count >= MAX_NUM_NEIGHBORS)
+                continue;
+            meshtastic_Neighbor &nbr = neighborInfo.neighbors[neighborInfo.neighbors_count++];
+            nbr.node_id = e.from;
+            nbr.snr = e.snr == MESH_TOPOLOGY_SNR_UNKNOWN ? 0 : (float)e.snr / 4;
+            if (rxTime)
+                nbr.last_rx_time = rxTime - (now - e.lastHeardMs) / 1000;
+        }
+
+        meshtastic_MeshPacket *p = allocDataProtobuf(neighborInfo);
+        p->from = n.to; // Looks to the phone as if the node sent its NeighborInfo itself
+        p->to = nodeDB->getNodeNum();
+        p->rx_time = rxTime;
+        p->priority = meshtastic_MeshPacket_Priority_BACKGROUND;
+        service->sendToPhone(p);
+        topologyExportStarted = true;
+        lastTopologyExportMs = n.lastHeardMs;
+        lastTopologyExportNode = n.to;
+    }
+    LOG_INFO("Sent topology of %u nodes to phone (%u links known)", (unsigned)newestPerNode.size(), (unsigned)edges.size());
+}
+
 /*
 Copy the content of a current NeighborInfo packet into a new one and update the last_sent_by_id to our NodeNum
 */
@@ -1,6 +1,7 @@
 #pragma once
 #include "ProtobufModule.h"
 #define MAX_NUM_NEIGHBORS 10 // also defined in NeighborInfo protobuf options
+#define MAX_TOPOLOGY_EXPORT_PACKETS 8
 
 /*
  * Neighborinfo module for sending info on each node's 0-hop neighbors to the mesh
@@ -12,6 +13,11 @@ class NeighborInfoModule : public ProtobufModule<meshtastic_NeighborInfo>, priva
 
     std::vector<meshtastic_Neighbor> neighbors;
 
+    // How far the topology export to the phone got: millis() of the last change we sent, and which node it was about
+    bool topologyExportStarted = false;
+    uint32_t lastTopologyExportMs = 0;
+    NodeNum lastTopologyExportNode = 0;
+
   public:
     /*
      * Expose the constructor
@@ -21,6 +27,9 @@ class NeighborInfoModule : public ProtobufModule<meshtastic_NeighborInfo>, priva
     /* Reset neighbor info after clearing nodeDB*/
     void resetNeighbors();
 
+    /* Start the topology export over, for a phone that just connected and doesn't have any of it yet */
+    void resetTopologyExport() { topologyExportStarted = false; }
+
   protected:
     /*
      * Called to handle a particular incoming message
@@ -50,6 +59,9 @@ class NeighborInfoModule : public ProtobufModule<meshtastic_NeighborInfo>, priva
      */
     void sendNeighborInfo(NodeNum dest = NODENUM_BROADCAST, bool wantReplies = false);
 
+    /* Send the mesh topology (see MeshTopology) to the phone as NeighborInfo packets */
+    void sendTopologyToPhone();
+
     /* update neighbors with subpacket sniffed from network */
     void updateNeighbors(const meshtastic_MeshPacket &mp, const meshtastic_NeighborInfo *np);
 
@@ -62,6 +74,7 @@ class NeighborInfoModule : public ProtobufModule<meshtastic_NeighborInfo>, priva
     /* Override wantPacket to say we want to see all packets when enabled, not just those for our port number.
       Exception is when the packet came via MQTT */
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override { return enabled && !p->via_mqtt; }
+    virtual meshtastic_PortNum getDispatchPortNum() override { return meshtastic_PortNum_UNKNOWN_APP; }
 
     /* These are for debugging only */
     void printNeighborInfo(const char *header, const meshtastic_NeighborInfo *np);
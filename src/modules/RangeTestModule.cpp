@@ -18,9 +18,14 @@
 #include "airtime.h"
 #include "configuration.h"
 #include "gps/GeoCoord.h"
+#include "sleep.h"
 #include <Arduino.h>
 #include <Throttle.h>
 
+#if RANGE_TEST_LOG_BUFFER_SIZE < 512
+#error "RANGE_TEST_LOG_BUFFER_SIZE must hold at least one record"
+#endif
+
 RangeTestModule *rangeTestModule;
 RangeTestModuleRadio *rangeTestModuleRadio;
 
@@ -99,6 +104,19 @@ int32_t RangeTestModule::runOnce()
     return disable();
 }
 
+RangeTestModuleRadio::RangeTestModuleRadio()
+    : SinglePortModule("RangeTestModuleRadio", meshtastic_PortNum_RANGE_TEST_APP), concurrency::OSThread("RangeTestLog")
+{
+    loopbackOk = true; // Allow locally generated messages to loop back to the client
+    notifyDeepSleepObserver.observe(&notifyDeepSleep);
+}
+
+int32_t RangeTestModuleRadio::runOnce()
+{
+    flushLog();
+    return INT32_MAX; // Sleep until appendFile() starts holding records again
+}
+
 /**
  * Sends a payload to a specified destination node.
  *
@@ -209,6 +227,90 @@ bool RangeTestModuleRadio::appendFile(const meshtastic_MeshPacket &mp)
         LOG_DEBUG("gpsStatus->getDOP()          %d", gpsStatus->getDOP());
         LOG_DEBUG("-----------------------------------------");
     */
+    uint8_t record[512];
+    size_t len = 0;
+
+    struct timeval tv;
+    bool haveTime = !gettimeofday(&tv, NULL);
+
+#ifdef USERPREFS_RANGE_TEST_BINARY_LOG
+    RangeTestLogRecord r = {};
+    r.time = haveTime ? tv.tv_sec : 0;
+    r.from = getFrom(&mp);
+    r.senderLatitudeI = n->position.latitude_i;
+    r.senderLongitudeI = n->position.longitude_i;
+    r.rxLatitudeI = gpsStatus->getLatitude();
+    r.rxLongitudeI = gpsStatus->getLongitude();
+    r.rxAltitude = gpsStatus->getAltitude();
+    r.rxSnr = mp.rx_snr;
+    r.hopLimit = mp.hop_limit;
+    r.payloadLen = p.payload.size;
+
+    memcpy(record, &r, sizeof(r));
+    memcpy(record + sizeof(r), p.payload.bytes, p.payload.size);
+    len = sizeof(r) + p.payload.size;
+#else
+    char *line = (char *)record;
+
+    if (haveTime) {
+        long hms = tv.tv_sec % SEC_PER_DAY;
+        hms = (hms + SEC_PER_DAY) % SEC_PER_DAY;
+
+        // Tear apart hms into h:m:s
+        int hour = hms / SEC_PER_HOUR;
+        int min = (hms % SEC_PER_HOUR) / SEC_PER_MIN;
+        int sec = (hms % SEC_PER_HOUR) % SEC_PER_MIN; // or hms % SEC_PER_MIN
+
+        len += sprintf(line + len, "%02d:%02d:%02d,", hour, min, sec); // Time
+    } else {
+        len += sprintf(line + len, "??:??:??,"); // Time
+    }
+
+    len += sprintf(line + len, "%d,", (int)getFrom(&mp));                // From
+    len += sprintf(line + len, "%s,", n->user.long_name);                // Long Name
+    len += sprintf(line + len, "%f,", n->position.latitude_i * 1e-7);    // Sender Lat
+    len += sprintf(line + len, "%f,", n->position.longitude_i * 1e-7);   // Sender Long
+    len += sprintf(line + len, "%f,", gpsStatus->getLatitude() * 1e-7);  // RX Lat
+    len += sprintf(line + len, "%f,", gpsStatus->getLongitude() * 1e-7); // RX Long
+    len += sprintf(line + len, "%d,", (int)gpsStatus->getAltitude());    // RX Altitude
+
+    len += sprintf(line + len, "%f,", mp.rx_snr); // RX SNR
+
+    if (n->position.latitude_i && n->position.longitude_i && gpsStatus->getLatitude() && gpsStatus->getLongitude()) {
+        float distance = GeoCoord::latLongToMeter(n->position.latitude_i * 1e-7, n->position.longitude_i * 1e-7,
+                                                  gpsStatus->getLatitude() * 1e-7, gpsStatus->getLongitude() * 1e-7);
+        len += sprintf(line + len, "%f,", distance); // Distance in meters
+    } else {
+        len += sprintf(line + len, "0,");
+    }
+
+    len += sprintf(line + len, "%d,", mp.hop_limit); // Packet Hop Limit
+
+    // TODO: If quotes are found in the payload, it has to be escaped.
+    len += sprintf(line + len, "\"%.*s\"\n", (int)p.payload.size, p.payload.bytes);
+#endif
+
+    // Writing to flash for every packet can't keep up with a fast sender, so collect records and write them in one go
+    if (logBufferLen + len > sizeof(logBuffer))
+        flushLog();
+    if (!logBufferLen)
+        setIntervalFromNow(RANGE_TEST_LOG_FLUSH_MS);
+    memcpy(logBuffer + logBufferLen, record, len);
+    logBufferLen += len;
+#endif
+
+    return 1;
+}
+
+bool RangeTestModuleRadio::flushLog()
+{
+#ifdef ARCH_ESP32
+    if (!logBufferLen)
+        return 1;
+
+    size_t len = logBufferLen;
+    logBufferLen = 0; // Whatever happens, don't try to write the same records again
+
     if (!FSBegin()) {
         LOG_DEBUG("An Error has occurred while mounting the filesystem");
         return 0;
@@ -222,18 +324,23 @@ bool RangeTestModuleRadio::appendFile(const meshtastic_MeshPacket &mp)
     FSCom.mkdir("/static");
 
     // If the file doesn't exist, write the header.
-    if (!FSCom.exists("/static/rangetest.csv")) {
+    if (!FSCom.exists(RANGE_TEST_LOG_FILE)) {
         //--------- Write to file
-        File fileToWrite = FSCom.open("/static/rangetest.csv", FILE_WRITE);
+        File fileToWrite = FSCom.open(RANGE_TEST_LOG_FILE, FILE_WRITE);
 
         if (!fileToWrite) {
             LOG_ERROR("There was an error opening the file for writing");
             return 0;
         }
 
+#ifdef USERPREFS_RANGE_TEST_BINARY_LOG
+        bool written = fileToWrite.print(RANGE_TEST_LOG_MAGIC);
+#else
         // Print the CSV header
-        if (fileToWrite.println(
-                "time,from,sender name,sender lat,sender long,rx lat,rx long,rx elevation,rx snr,distance,hop limit,payload")) {
+        bool written = fileToWrite.println(
+            "time,from,sender name,sender lat,sender long,rx lat,rx long,rx elevation,rx snr,distance,hop limit,payload");
+#endif
+        if (written) {
             LOG_INFO("File was written");
         } else {
             LOG_ERROR("File write failed");
@@ -243,53 +350,21 @@ bool RangeTestModuleRadio::appendFile(const meshtastic_MeshPacket &mp)
     }
 
     //--------- Append content to file
-    File fileToAppend = FSCom.open("/static/rangetest.csv", FILE_APPEND);
+    File fileToAppend = FSCom.open(RANGE_TEST_LOG_FILE, FILE_APPEND);
 
     if (!fileToAppend) {
         LOG_ERROR("There was an error opening the file for appending");
         return 0;
     }
 
-    struct timeval tv;
-    if (!gettimeofday(&tv, NULL)) {
-        long hms = tv.tv_sec % SEC_PER_DAY;
-        hms = (hms + SEC_PER_DAY) % SEC_PER_DAY;
-
-        // Tear apart hms into h:m:s
-        int hour = hms / SEC_PER_HOUR;
-        int min = (hms % SEC_PER_HOUR) / SEC_PER_MIN;
-        int sec = (hms % SEC_PER_HOUR) % SEC_PER_MIN; // or hms % SEC_PER_MIN
-
-        fileToAppend.printf("%02d:%02d:%02d,", hour, min, sec); // Time
-    } else {
-        fileToAppend.printf("??:??:??,"); // Time
-    }
-
-    fileToAppend.printf("%d,", getFrom(&mp));                     // From
-    fileToAppend.printf("%s,", n->user.long_name);                // Long Name
-    fileToAppend.printf("%f,", n->position.latitude_i * 1e-7);    // Sender Lat
-    fileToAppend.printf("%f,", n->position.longitude_i * 1e-7);   // Sender Long
-    fileToAppend.printf("%f,", gpsStatus->getLatitude() * 1e-7);  // RX Lat
-    fileToAppend.printf("%f,", gpsStatus->getLongitude() * 1e-7); // RX Long
-    fileToAppend.printf("%d,", gpsStatus->getAltitude());         // RX Altitude
-
-    fileToAppend.printf("%f,", mp.rx_snr); // RX SNR
-
-    if (n->position.latitude_i && n->position.longitude_i && gpsStatus->getLatitude() && gpsStatus->getLongitude()) {
-        float distance = GeoCoord::latLongToMeter(n->position.latitude_i * 1e-7, n->position.longitude_i * 1e-7,
-                                                  gpsStatus->getLatitude() * 1e-7, gpsStatus->getLongitude() * 1e-7);
-        fileToAppend.printf("%f,", distance); // Distance in meters
-    } else {
-        fileToAppend.printf("0,");
-    }
-
-    fileToAppend.printf("%d,", mp.hop_limit); // Packet Hop Limit
-
-    // TODO: If quotes are found in the payload, it has to be escaped.
-    fileToAppend.printf("\"%s\"\n", p.payload.bytes);
+    size_t written = fileToAppend.write(logBuffer, len);
     fileToAppend.flush();
     fileToAppend.close();
-#endif
+    updateFilesManifest(RANGE_TEST_LOG_FILE);
 
+    LOG_DEBUG("Range test log: wrote %u bytes", (unsigned)written);
+    return written == len;
+#else
     return 1;
+#endif
 }
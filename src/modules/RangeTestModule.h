@@ -20,19 +20,48 @@ class RangeTestModule : private concurrency::OSThread
 
 extern RangeTestModule *rangeTestModule;
 
+/// Received range test packets are collected in RAM and written to flash in one go once this many bytes are waiting...
+#ifndef RANGE_TEST_LOG_BUFFER_SIZE
+#define RANGE_TEST_LOG_BUFFER_SIZE 2048
+#endif
+
+/// ...or the oldest of them has waited this long
+#ifndef RANGE_TEST_LOG_FLUSH_MS
+#define RANGE_TEST_LOG_FLUSH_MS (30 * 1000)
+#endif
+
+#ifdef USERPREFS_RANGE_TEST_BINARY_LOG
+/// Log in compact binary records instead of CSV, bin/rangetest-bin-to-csv.py turns the file into the usual CSV
+#define RANGE_TEST_LOG_FILE "/static/rangetest.bin"
+#define RANGE_TEST_LOG_MAGIC "RTB1"
+
+/// One received packet in the binary log (little endian, followed by payloadLen bytes of payload)
+struct __attribute__((packed)) RangeTestLogRecord {
+    uint32_t time; // Seconds since the epoch, 0 if we don't know the time
+    uint32_t from;
+    int32_t senderLatitudeI;
+    int32_t senderLongitudeI;
+    int32_t rxLatitudeI;
+    int32_t rxLongitudeI;
+    int32_t rxAltitude;
+    float rxSnr;
+    uint8_t hopLimit;
+    uint8_t payloadLen;
+};
+#else
+#define RANGE_TEST_LOG_FILE "/static/rangetest.csv"
+#endif
+
 /*
  * Radio interface for RangeTestModule
  *
  */
-class RangeTestModuleRadio : public SinglePortModule
+class RangeTestModuleRadio : public SinglePortModule, private concurrency::OSThread
 {
     uint32_t lastRxID = 0;
 
   public:
-    RangeTestModuleRadio() : SinglePortModule("RangeTestModuleRadio", meshtastic_PortNum_RANGE_TEST_APP)
-    {
-        loopbackOk = true; // Allow locally generated messages to loop back to the client
-    }
+    RangeTestModuleRadio();
 
     /**
      * Send our payload into the mesh
@@ -40,10 +69,15 @@ class RangeTestModuleRadio : public SinglePortModule
     void sendPayload(NodeNum dest = NODENUM_BROADCAST, bool wantReplies = false);
 
     /**
-     * Append range test data to the file on the Filesystem
+     * Append range test data to the file on the Filesystem (once enough of it is waiting, see flushLog())
      */
     bool appendFile(const meshtastic_MeshPacket &mp);
 
+    /**
+     * Write the range test data we are holding to the file on the Filesystem
+     */
+    bool flushLog();
+
   protected:
     /** Called to handle a particular incoming message
 
@@ -51,6 +85,24 @@ class RangeTestModuleRadio : public SinglePortModule
     it
     */
     virtual ProcessMessage handleReceived(const meshtastic_MeshPacket &mp) override;
+
+    /// Flushes the log once RANGE_TEST_LOG_FLUSH_MS passed since the first record went in
+    virtual int32_t runOnce() override;
+
+  private:
+#ifdef ARCH_ESP32
+    uint8_t logBuffer[RANGE_TEST_LOG_BUFFER_SIZE];
+    size_t logBufferLen = 0;
+#endif
+
+    CallbackObserver<RangeTestModuleRadio, void *> notifyDeepSleepObserver =
+        CallbackObserver<RangeTestModuleRadio, void *>(this, &RangeTestModuleRadio::onDeepSleep);
+
+    int onDeepSleep(void *unused)
+    {
+        flushLog();
+        return 0;
+    }
 };
 
 extern RangeTestModuleRadio *rangeTestModuleRadio;
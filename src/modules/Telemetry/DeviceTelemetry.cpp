@@ -4,6 +4,7 @@
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "PowerFSM.h"
+#include "PowerMon.h"
 #include "RTC.h"
 #include "RadioLibInterface.h"
 #include "Router.h"
@@ -80,6 +81,12 @@ meshtastic_MeshPacket *DeviceTelemetryModule::allocReply()
             return allocDataProtobuf(getDeviceTelemetry());
         } else if (decoded->which_variant == meshtastic_Telemetry_local_stats_tag) {
             LOG_INFO("Device telemetry reply w/ LocalStats to request");
+            // LocalStats has no room for them, so tell our own phone who is using the channel and the battery separately
+            if (isFromUs(&req)) {
+                sendAirtimeSummaryToPhone(req.id);
+                if (powerMon)
+                    powerMon->sendSummaryToPhone(req.id);
+            }
             return allocDataProtobuf(getLocalStatsTelemetry());
         }
     }
@@ -143,9 +150,41 @@ meshtastic_Telemetry DeviceTelemetryModule::getLocalStatsTelemetry()
     LOG_INFO("num_packets_tx=%i, num_packets_rx=%i, num_packets_rx_bad=%i", telemetry.variant.local_stats.num_packets_tx,
              telemetry.variant.local_stats.num_packets_rx, telemetry.variant.local_stats.num_packets_rx_bad);
 
+    if (router) {
+        LOG_INFO("num_rx_dupe=%i (%i before decoding), num_rx_ignored_before_decoding=%i", router->rxDupe, router->rxEarlyDupe,
+                 router->rxEarlyIgnored);
+    }
+    if (powerMon)
+        powerMon->logSummary();
+
     return telemetry;
 }
 
+void DeviceTelemetryModule::sendAirtimeSummaryToPhone(uint32_t replyId)
+{
+    AirtimeShare shares[5];
+    meshtastic_ClientNotification *cn = clientNotificationPool.allocZeroed();
+    cn->has_reply_id = true;
+    cn->reply_id = replyId;
+    cn->level = meshtastic_LogRecord_Level_INFO;
+    cn->time = getValidTime(RTCQualityFromNet);
+
+    // At most 5 entries of each kind, well within the size of the message
+    size_t len = snprintf(cn->message, sizeof(cn->message), "Airtime last hour by node:");
+    size_t numShares = airTime->getNodeAirtime(shares, 5);
+    for (size_t i = 0; i < numShares; i++)
+        len += snprintf(cn->message + len, sizeof(cn->message) - len, " !%08x %u.%us", shares[i].key,
+                        shares[i].airtimeMs / 1000, (shares[i].airtimeMs % 1000) / 100);
+    len += snprintf(cn->message + len, sizeof(cn->message) - len, ", by portnum:");
+    numShares = airTime->getPortAirtime(shares, 5);
+    for (size_t i = 0; i < numShares; i++)
+        len += snprintf(cn->message + len, sizeof(cn->message) - len, " %u %u.%us", shares[i].key, shares[i].airtimeMs / 1000,
+                        (shares[i].airtimeMs % 1000) / 100);
+
+    LOG_INFO("%s", cn->message);
+    service->sendClientNotification(cn);
+}
+
 void DeviceTelemetryModule::sendLocalStatsToPhone()
 {
     meshtastic_MeshPacket *p = allocDataProtobuf(getLocalStatsTelemetry());
@@ -170,12 +209,6 @@ bool DeviceTelemetryModule::sendTelemetry(NodeNum dest, bool phoneOnly)
     p->priority = meshtastic_MeshPacket_Priority_BACKGROUND;
 
     nodeDB->updateTelemetry(nodeDB->getNodeNum(), telemetry, RX_SRC_LOCAL);
-    if (phoneOnly) {
-        LOG_INFO("Send packet to phone");
-        service->sendToPhone(p);
-    } else {
-        LOG_INFO("Send packet to mesh");
-        service->sendToMesh(p, RX_SRC_LOCAL, true);
-    }
+    deadband.send(p, telemetry, phoneOnly);
     return true;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "../mesh/generated/meshtastic/telemetry.pb.h"
 #include "NodeDB.h"
 #include "ProtobufModule.h"
+#include "TelemetryDeadband.h"
 #include <OLEDDisplay.h>
 #include <OLEDDisplayUi.h>
 
@@ -45,10 +46,13 @@ class DeviceTelemetryModule : private concurrency::OSThread, public ProtobufModu
     meshtastic_Telemetry getLocalStatsTelemetry();
 
     void sendLocalStatsToPhone();
+    /// Send the nodes and portnums using the most airtime to the phone, as a ClientNotification replying to replyId
+    void sendAirtimeSummaryToPhone(uint32_t replyId);
     uint32_t sendToPhoneIntervalMs = SECONDS_IN_MINUTE * 1000;           // Send to phone every minute
     uint32_t sendStatsToPhoneIntervalMs = 15 * SECONDS_IN_MINUTE * 1000; // Send stats to phone every 15 minutes
     uint32_t lastSentStatsToPhone = 0;
     uint32_t lastSentToMesh = 0;
+    TelemetryDeadband deadband;
 
     void refreshUptime()
     {
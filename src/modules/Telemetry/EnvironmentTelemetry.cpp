@@ -10,6 +10,7 @@
 #include "PowerFSM.h"
 #include "RTC.h"
 #include "Router.h"
+#include "SensorScheduler.h"
 #include "UnitConversions.h"
 #include "main.h"
 #include "power.h"
@@ -63,6 +64,15 @@ T1000xSensor t1000xSensor;
 #endif
 CGRadSensSensor cgRadSens;
 
+#ifndef T1000X_SENSOR_EN
+// Sensors whose metrics are merged as they are, in this order.  The AHT10 is special cased as it may only provide the humidity
+static TelemetrySensor *const environmentSensors[] = {
+    &dfRobotLarkSensor, &sht31Sensor,    &sht4xSensor,   &lps22hbSensor,  &shtc3Sensor,    &bmp085Sensor,
+    &bmp280Sensor,      &bme280Sensor,   &bmp3xxSensor,  &bme680Sensor,   &mcp9808Sensor,  &ina219Sensor,
+    &ina260Sensor,      &ina3221Sensor,  &veml7700Sensor, &tsl2591Sensor, &opt3001Sensor,  &mlx90632Sensor,
+    &rcwl9620Sensor,    &nau7802Sensor,  &max17048Sensor, &cgRadSens};
+#endif
+
 #define FAILED_STATE_SENSOR_READ_MULTIPLIER 10
 #define DISPLAY_RECEIVEID_MEASUREMENTS_ON_SCREEN true
 
@@ -151,6 +161,19 @@ int32_t EnvironmentTelemetryModule::runOnce()
                 result = max17048Sensor.runOnce();
             if (cgRadSens.hasSensor())
                 result = cgRadSens.runOnce();
+#endif
+            // From now on the sensors are sampled in the background, at the rate we send our metrics to the mesh
+            uint32_t samplePeriodMs = Default::getConfiguredOrDefaultMs(moduleConfig.telemetry.environment_update_interval,
+                                                                        default_telemetry_broadcast_interval_secs);
+#ifdef T1000X_SENSOR_EN
+            sensorScheduler->add(&t1000xSensor, meshtastic_Telemetry_environment_metrics_tag, samplePeriodMs);
+#else
+            for (auto sensor : environmentSensors) {
+                if (sensor->hasSensor())
+                    sensorScheduler->add(sensor, meshtastic_Telemetry_environment_metrics_tag, samplePeriodMs);
+            }
+            if (aht10Sensor.hasSensor())
+                sensorScheduler->add(&aht10Sensor, meshtastic_Telemetry_environment_metrics_tag, samplePeriodMs);
 #endif
         }
         return result;
@@ -296,117 +319,37 @@ bool EnvironmentTelemetryModule::getEnvironmentTelemetry(meshtastic_Telemetry *m
     m->variant.environment_metrics = meshtastic_EnvironmentMetrics_init_zero;
 
 #ifdef T1000X_SENSOR_EN // add by WayenWeng
-    valid = valid && t1000xSensor.getMetrics(m);
+    valid = valid && sensorScheduler->getMetrics(&t1000xSensor, m);
     hasSensor = true;
 #else
-    if (dfRobotLarkSensor.hasSensor()) {
-        valid = valid && dfRobotLarkSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (sht31Sensor.hasSensor()) {
-        valid = valid && sht31Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (sht4xSensor.hasSensor()) {
-        valid = valid && sht4xSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (lps22hbSensor.hasSensor()) {
-        valid = valid && lps22hbSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (shtc3Sensor.hasSensor()) {
-        valid = valid && shtc3Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bmp085Sensor.hasSensor()) {
-        valid = valid && bmp085Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bmp280Sensor.hasSensor()) {
-        valid = valid && bmp280Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bme280Sensor.hasSensor()) {
-        valid = valid && bme280Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bmp3xxSensor.hasSensor()) {
-        valid = valid && bmp3xxSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bme680Sensor.hasSensor()) {
-        valid = valid && bme680Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (mcp9808Sensor.hasSensor()) {
-        valid = valid && mcp9808Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (ina219Sensor.hasSensor()) {
-        valid = valid && ina219Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (ina260Sensor.hasSensor()) {
-        valid = valid && ina260Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (ina3221Sensor.hasSensor()) {
-        valid = valid && ina3221Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (veml7700Sensor.hasSensor()) {
-        valid = valid && veml7700Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (tsl2591Sensor.hasSensor()) {
-        valid = valid && tsl2591Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (opt3001Sensor.hasSensor()) {
-        valid = valid && opt3001Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (mlx90632Sensor.hasSensor()) {
-        valid = valid && mlx90632Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (rcwl9620Sensor.hasSensor()) {
-        valid = valid && rcwl9620Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (nau7802Sensor.hasSensor()) {
-        valid = valid && nau7802Sensor.getMetrics(m);
-        hasSensor = true;
+    for (auto sensor : environmentSensors) {
+        if (sensor->hasSensor()) {
+            valid = valid && sensorScheduler->getMetrics(sensor, m);
+            hasSensor = true;
+        }
     }
     if (aht10Sensor.hasSensor()) {
         if (!bmp280Sensor.hasSensor() && !bmp3xxSensor.hasSensor()) {
-            valid = valid && aht10Sensor.getMetrics(m);
+            valid = valid && sensorScheduler->getMetrics(&aht10Sensor, m);
             hasSensor = true;
         } else if (bmp280Sensor.hasSensor()) {
             // prefer bmp280 temp if both sensors are present, fetch only humidity
             meshtastic_Telemetry m_ahtx = meshtastic_Telemetry_init_zero;
+            m_ahtx.which_variant = meshtastic_Telemetry_environment_metrics_tag;
             LOG_INFO("AHTX0+BMP280 module detected: using temp from BMP280 and humy from AHTX0");
-            aht10Sensor.getMetrics(&m_ahtx);
+            sensorScheduler->getMetrics(&aht10Sensor, &m_ahtx);
             m->variant.environment_metrics.relative_humidity = m_ahtx.variant.environment_metrics.relative_humidity;
             m->variant.environment_metrics.has_relative_humidity = m_ahtx.variant.environment_metrics.has_relative_humidity;
         } else {
             // prefer bmp3xx temp if both sensors are present, fetch only humidity
             meshtastic_Telemetry m_ahtx = meshtastic_Telemetry_init_zero;
+            m_ahtx.which_variant = meshtastic_Telemetry_environment_metrics_tag;
             LOG_INFO("AHTX0+BMP3XX module detected: using temp from BMP3XX and humy from AHTX0");
-            aht10Sensor.getMetrics(&m_ahtx);
+            sensorScheduler->getMetrics(&aht10Sensor, &m_ahtx);
             m->variant.environment_metrics.relative_humidity = m_ahtx.variant.environment_metrics.relative_humidity;
             m->variant.environment_metrics.has_relative_humidity = m_ahtx.variant.environment_metrics.has_relative_humidity;
         }
     }
-    if (max17048Sensor.hasSensor()) {
-        valid = valid && max17048Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (cgRadSens.hasSensor()) {
-        valid = valid && cgRadSens.getMetrics(m);
-        hasSensor = true;
-    }
 
 #endif
     return valid && hasSensor;
@@ -446,7 +389,7 @@ bool EnvironmentTelemetryModule::sendTelemetry(NodeNum dest, bool phoneOnly)
     m.which_variant = meshtastic_Telemetry_environment_metrics_tag;
     m.time = getTime();
 #ifdef T1000X_SENSOR_EN
-    if (t1000xSensor.getMetrics(&m)) {
+    if (sensorScheduler->getMetrics(&t1000xSensor, &m)) {
 #else
     if (getEnvironmentTelemetry(&m)) {
 #endif
@@ -476,18 +419,11 @@ bool EnvironmentTelemetryModule::sendTelemetry(NodeNum dest, bool phoneOnly)
             packetPool.release(lastMeasurementPacket);
 
         lastMeasurementPacket = packetPool.allocCopy(*p);
-        if (phoneOnly) {
-            LOG_INFO("Send packet to phone");
-            service->sendToPhone(p);
-        } else {
-            LOG_INFO("Send packet to mesh");
-            service->sendToMesh(p, RX_SRC_LOCAL, true);
-
-            if (config.device.role == meshtastic_Config_DeviceConfig_Role_SENSOR && config.power.is_power_saving) {
-                LOG_DEBUG("Start next execution in 5s, then sleep");
-                sleepOnNextExecution = true;
-                setIntervalFromNow(5000);
-            }
+        deadband.send(p, m, phoneOnly);
+        if (!phoneOnly && config.device.role == meshtastic_Config_DeviceConfig_Role_SENSOR && config.power.is_power_saving) {
+            LOG_DEBUG("Start next execution in 5s, then sleep");
+            sleepOnNextExecution = true;
+            setIntervalFromNow(5000);
         }
         return true;
     }
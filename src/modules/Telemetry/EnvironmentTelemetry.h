@@ -6,6 +6,7 @@
 #include "../mesh/generated/meshtastic/telemetry.pb.h"
 #include "NodeDB.h"
 #include "ProtobufModule.h"
+#include "TelemetryDeadband.h"
 #include <OLEDDisplay.h>
 #include <OLEDDisplayUi.h>
 
@@ -56,6 +57,7 @@ class EnvironmentTelemetryModule : private concurrency::OSThread, public Protobu
     meshtastic_MeshPacket *lastMeasurementPacket;
     uint32_t sendToPhoneIntervalMs = SECONDS_IN_MINUTE * 1000; // Send to phone every minute
     uint32_t lastSentToMesh = 0;
+    TelemetryDeadband deadband;
     uint32_t lastSentToPhone = 0;
     uint32_t sensor_read_error_count = 0;
 };
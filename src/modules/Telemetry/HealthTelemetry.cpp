@@ -10,6 +10,7 @@
 #include "PowerFSM.h"
 #include "RTC.h"
 #include "Router.h"
+#include "SensorScheduler.h"
 #include "UnitConversions.h"
 #include "main.h"
 #include "power.h"
@@ -61,6 +62,14 @@ int32_t HealthTelemetryModule::runOnce()
                 result = mlx90614Sensor.runOnce();
             if (max30102Sensor.hasSensor())
                 result = max30102Sensor.runOnce();
+
+            // From now on the sensors are sampled in the background, at the rate we send our metrics to the mesh
+            uint32_t samplePeriodMs = Default::getConfiguredOrDefaultMs(moduleConfig.telemetry.health_update_interval,
+                                                                        default_telemetry_broadcast_interval_secs);
+            if (mlx90614Sensor.hasSensor())
+                sensorScheduler->add(&mlx90614Sensor, meshtastic_Telemetry_health_metrics_tag, samplePeriodMs);
+            if (max30102Sensor.hasSensor())
+                sensorScheduler->add(&max30102Sensor, meshtastic_Telemetry_health_metrics_tag, samplePeriodMs);
         }
         return result;
     } else {
@@ -166,11 +175,11 @@ bool HealthTelemetryModule::getHealthTelemetry(meshtastic_Telemetry *m)
     m->variant.health_metrics = meshtastic_HealthMetrics_init_zero;
 
     if (max30102Sensor.hasSensor()) {
-        valid = valid && max30102Sensor.getMetrics(m);
+        valid = valid && sensorScheduler->getMetrics(&max30102Sensor, m);
         hasSensor = true;
     }
     if (mlx90614Sensor.hasSensor()) {
-        valid = valid && mlx90614Sensor.getMetrics(m);
+        valid = valid && sensorScheduler->getMetrics(&mlx90614Sensor, m);
         hasSensor = true;
     }
 
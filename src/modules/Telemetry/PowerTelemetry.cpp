@@ -10,6 +10,7 @@
 #include "PowerTelemetry.h"
 #include "RTC.h"
 #include "Router.h"
+#include "SensorScheduler.h"
 #include "main.h"
 #include "power.h"
 #include "sleep.h"
@@ -62,6 +63,18 @@ int32_t PowerTelemetryModule::runOnce()
                 result = ina3221Sensor.runOnce();
             if (max17048Sensor.hasSensor() && !max17048Sensor.isInitialized())
                 result = max17048Sensor.runOnce();
+
+            // From now on the sensors are sampled in the background, at the rate we send our metrics to the mesh
+            uint32_t samplePeriodMs = Default::getConfiguredOrDefaultMs(moduleConfig.telemetry.power_update_interval,
+                                                                        default_telemetry_broadcast_interval_secs);
+            if (ina219Sensor.hasSensor())
+                sensorScheduler->add(&ina219Sensor, meshtastic_Telemetry_power_metrics_tag, samplePeriodMs);
+            if (ina260Sensor.hasSensor())
+                sensorScheduler->add(&ina260Sensor, meshtastic_Telemetry_power_metrics_tag, samplePeriodMs);
+            if (ina3221Sensor.hasSensor())
+                sensorScheduler->add(&ina3221Sensor, meshtastic_Telemetry_power_metrics_tag, samplePeriodMs);
+            if (max17048Sensor.hasSensor())
+                sensorScheduler->add(&max17048Sensor, meshtastic_Telemetry_power_metrics_tag, samplePeriodMs);
         }
         return result;
 #else
@@ -169,13 +182,13 @@ bool PowerTelemetryModule::getPowerTelemetry(meshtastic_Telemetry *m)
     m->variant.power_metrics = meshtastic_PowerMetrics_init_zero;
 #if HAS_TELEMETRY && !defined(ARCH_PORTDUINO)
     if (ina219Sensor.hasSensor())
-        valid = ina219Sensor.getMetrics(m);
+        valid = sensorScheduler->getMetrics(&ina219Sensor, m);
     if (ina260Sensor.hasSensor())
-        valid = ina260Sensor.getMetrics(m);
+        valid = sensorScheduler->getMetrics(&ina260Sensor, m);
     if (ina3221Sensor.hasSensor())
-        valid = ina3221Sensor.getMetrics(m);
+        valid = sensorScheduler->getMetrics(&ina3221Sensor, m);
     if (max17048Sensor.hasSensor())
-        valid = max17048Sensor.getMetrics(m);
+        valid = sensorScheduler->getMetrics(&max17048Sensor, m);
 #endif
 
     return valid;
@@ -235,18 +248,11 @@ bool PowerTelemetryModule::sendTelemetry(NodeNum dest, bool phoneOnly)
             packetPool.release(lastMeasurementPacket);
 
         lastMeasurementPacket = packetPool.allocCopy(*p);
-        if (phoneOnly) {
-            LOG_INFO("Send packet to phone");
-            service->sendToPhone(p);
-        } else {
-            LOG_INFO("Send packet to mesh");
-            service->sendToMesh(p, RX_SRC_LOCAL, true);
-
-            if (config.device.role == meshtastic_Config_DeviceConfig_Role_SENSOR && config.power.is_power_saving) {
-                LOG_DEBUG("Start next execution in 5s then sleep");
-                sleepOnNextExecution = true;
-                setIntervalFromNow(5000);
-            }
+        deadband.send(p, m, phoneOnly);
+        if (!phoneOnly && config.device.role == meshtastic_Config_DeviceConfig_Role_SENSOR && config.power.is_power_saving) {
+            LOG_DEBUG("Start next execution in 5s then sleep");
+            sleepOnNextExecution = true;
+            setIntervalFromNow(5000);
         }
         return true;
     }
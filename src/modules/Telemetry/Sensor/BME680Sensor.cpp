@@ -126,6 +126,7 @@ void BME680Sensor::updateState()
         } else {
             LOG_INFO("Can't write %s state (File: %s)", sensorName, bsecConfigFileName);
         }
+        updateFilesManifest(bsecConfigFileName);
     }
 #else
     LOG_ERROR("ERROR: Filesystem not implemented");
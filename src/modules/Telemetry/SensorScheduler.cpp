@@ -0,0 +1,101 @@
+#include "configuration.h"
+
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
+
+#include "SensorScheduler.h"
+#include "mesh/mesh-pb-constants.h"
+#include <Throttle.h>
+#include <algorithm>
+#include <pb_decode.h>
+
+SensorScheduler *sensorScheduler;
+
+SensorScheduler::SensorScheduler() : concurrency::OSThread("SensorScheduler")
+{
+    setIntervalFromNow(INT32_MAX); // Nothing to sample until sensors are added
+}
+
+void SensorScheduler::add(TelemetrySensor *sensor, pb_size_t variant, uint32_t periodMs)
+{
+    for (auto &e : entries) {
+        if (e.sensor == sensor && e.variant == variant) {
+            e.periodMs = std::min(e.periodMs, periodMs);
+            return;
+        }
+    }
+
+    // Give the freshly initialized sensor time to settle, and spread the first samples out rather than hitting the bus with
+    // every sensor at once
+    Entry e = {};
+    e.sensor = sensor;
+    e.variant = variant;
+    e.periodMs = periodMs;
+    e.nextSampleMs = millis() + DEFAULT_SENSOR_MINIMUM_WAIT_TIME_BETWEEN_READS + entries.size() * SENSOR_SCHEDULER_STAGGER_MS;
+    entries.push_back(e);
+
+    LOG_DEBUG("Sample sensor %u (variant %u) every %ums", (unsigned)entries.size(), variant, periodMs);
+    setIntervalFromNow(0);
+}
+
+bool SensorScheduler::sample(Entry &e)
+{
+    memset(&e.reading, 0, sizeof(e.reading));
+    e.reading.which_variant = e.variant;
+    e.valid = e.sensor->getMetrics(&e.reading);
+
+    lastSampleMs = e.sampledAtMs = millis();
+    e.nextSampleMs = e.sampledAtMs + e.periodMs;
+    return e.valid;
+}
+
+bool SensorScheduler::getMetrics(TelemetrySensor *sensor, meshtastic_Telemetry *m)
+{
+    Entry *entry = NULL;
+    for (auto &e : entries) {
+        if (e.sensor == sensor && e.variant == m->which_variant)
+            entry = &e;
+    }
+    if (!entry)
+        return sensor->getMetrics(m);
+
+    if (!entry->valid || !Throttle::isWithinTimespanMs(entry->sampledAtMs, entry->periodMs)) {
+        // Reading on demand also pushes the next background sample back by a whole period
+        if (!sample(*entry))
+            return false;
+    }
+
+    // Merge the reading into what other sensors already filled in, like getMetrics() would have done.  Re-encoding also
+    // leaves out fields the sensor did not set (reading.time is zero so m->time is left alone as well).
+    uint8_t buf[meshtastic_Telemetry_size];
+    size_t len = pb_encode_to_bytes(buf, sizeof(buf), &meshtastic_Telemetry_msg, &entry->reading);
+    pb_istream_t stream = pb_istream_from_buffer(buf, len);
+    return pb_decode_ex(&stream, &meshtastic_Telemetry_msg, m, PB_DECODE_NOINIT);
+}
+
+int32_t SensorScheduler::runOnce()
+{
+    if (entries.empty())
+        return INT32_MAX;
+
+    uint32_t now = millis();
+    Entry *next = NULL;
+    for (auto &e : entries) {
+        if (!next || (int32_t)(e.nextSampleMs - next->nextSampleMs) < 0)
+            next = &e;
+    }
+
+    int32_t untilDue = (int32_t)(next->nextSampleMs - now);
+    if (untilDue > 0)
+        return untilDue;
+
+    // Give the bus a quiet moment after the previous transaction, whoever made it
+    if (Throttle::isWithinTimespanMs(lastSampleMs, SENSOR_SCHEDULER_STAGGER_MS))
+        return SENSOR_SCHEDULER_STAGGER_MS - (now - lastSampleMs);
+
+    if (!sample(*next))
+        LOG_WARN("Sensor read failed in background sample");
+
+    return SENSOR_SCHEDULER_STAGGER_MS;
+}
+
+#endif
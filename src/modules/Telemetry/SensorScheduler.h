@@ -0,0 +1,65 @@
+#pragma once
+
+#include "configuration.h"
+
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
+
+#include "Sensor/TelemetrySensor.h"
+#include "concurrency/OSThread.h"
+#include <vector>
+
+/// Minimum time between two transactions of the scheduler on the sensor bus, so reads don't arrive in bursts
+#define SENSOR_SCHEDULER_STAGGER_MS 100
+
+/**
+ * Samples the telemetry sensors in the background, one sensor at a time and each at its own period, and keeps the latest
+ * reading of every sensor around.
+ *
+ * The telemetry modules read from this cache instead of polling every sensor each time they build a packet, so sending the
+ * same metrics to the phone every minute no longer costs a round of I2C transactions.
+ */
+class SensorScheduler : private concurrency::OSThread
+{
+  public:
+    SensorScheduler();
+
+    /**
+     * Start sampling an (initialized) sensor every periodMs, its readings are taken as the given telemetry variant.
+     * The same sensor may be added once per variant, e.g. an INA219 is read both as environment and as power metrics.
+     */
+    void add(TelemetrySensor *sensor, pb_size_t variant, uint32_t periodMs);
+
+    /**
+     * Merge the latest reading of a sensor into m, which must already have its variant set.  The sensor is read right now
+     * if we have no reading yet or the one we have is older than its sample period.  Sensors we don't sample are always
+     * read directly.
+     *
+     * @return false if the sensor could not be read
+     */
+    bool getMetrics(TelemetrySensor *sensor, meshtastic_Telemetry *m);
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    struct Entry {
+        TelemetrySensor *sensor;
+        pb_size_t variant;
+        uint32_t periodMs;
+        uint32_t nextSampleMs;
+        uint32_t sampledAtMs;
+        bool valid; // reading holds a successful sample
+        meshtastic_Telemetry reading;
+    };
+
+    std::vector<Entry> entries;
+
+    /// millis() of our last transaction on the sensor bus
+    uint32_t lastSampleMs = 0;
+
+    bool sample(Entry &e);
+};
+
+extern SensorScheduler *sensorScheduler;
+
+#endif
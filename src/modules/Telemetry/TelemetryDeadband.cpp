@@ -0,0 +1,265 @@
+#include "TelemetryDeadband.h"
+#include "MeshService.h"
+#include "Router.h"
+#include "mesh/mesh-pb-constants.h"
+#include <algorithm>
+#include <math.h>
+#include <pb_common.h>
+
+TelemetryDeltaCache telemetryDeltaCache;
+
+/// A metric never counts as changed, e.g. the uptime, which always does
+#define TELEMETRY_DEADBAND_NEVER -1
+
+struct MetricDeadband {
+    pb_size_t variant;
+    pb_size_t tag;
+    float deadband; // in the unit of the metric
+};
+
+static const MetricDeadband metricDeadbands[] = {
+    {meshtastic_Telemetry_device_metrics_tag, meshtastic_DeviceMetrics_battery_level_tag, 2},
+    {meshtastic_Telemetry_device_metrics_tag, meshtastic_DeviceMetrics_voltage_tag, 0.05},
+    {meshtastic_Telemetry_device_metrics_tag, meshtastic_DeviceMetrics_channel_utilization_tag, 2},
+    {meshtastic_Telemetry_device_metrics_tag, meshtastic_DeviceMetrics_air_util_tx_tag, 1},
+    {meshtastic_Telemetry_device_metrics_tag, meshtastic_DeviceMetrics_uptime_seconds_tag, TELEMETRY_DEADBAND_NEVER},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_temperature_tag, 0.5},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_relative_humidity_tag, 2},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_barometric_pressure_tag, 1},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_voltage_tag, 0.05},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_current_tag, 5},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_iaq_tag, 10},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_wind_direction_tag, 30},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_wind_speed_tag, 1},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_wind_gust_tag, 1},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_wind_lull_tag, 1},
+    {meshtastic_Telemetry_environment_metrics_tag, meshtastic_EnvironmentMetrics_weight_tag, 0.1},
+    {meshtastic_Telemetry_power_metrics_tag, meshtastic_PowerMetrics_ch1_voltage_tag, 0.05},
+    {meshtastic_Telemetry_power_metrics_tag, meshtastic_PowerMetrics_ch1_current_tag, 5},
+    {meshtastic_Telemetry_power_metrics_tag, meshtastic_PowerMetrics_ch2_voltage_tag, 0.05},
+    {meshtastic_Telemetry_power_metrics_tag, meshtastic_PowerMetrics_ch2_current_tag, 5},
+    {meshtastic_Telemetry_power_metrics_tag, meshtastic_PowerMetrics_ch3_voltage_tag, 0.05},
+    {meshtastic_Telemetry_power_metrics_tag, meshtastic_PowerMetrics_ch3_current_tag, 5},
+    {meshtastic_Telemetry_air_quality_metrics_tag, meshtastic_AirQualityMetrics_pm10_standard_tag, 5},
+    {meshtastic_Telemetry_air_quality_metrics_tag, meshtastic_AirQualityMetrics_pm25_standard_tag, 5},
+    {meshtastic_Telemetry_air_quality_metrics_tag, meshtastic_AirQualityMetrics_pm100_standard_tag, 5},
+    {meshtastic_Telemetry_air_quality_metrics_tag, meshtastic_AirQualityMetrics_pm10_environmental_tag, 5},
+    {meshtastic_Telemetry_air_quality_metrics_tag, meshtastic_AirQualityMetrics_pm25_environmental_tag, 5},
+    {meshtastic_Telemetry_air_quality_metrics_tag, meshtastic_AirQualityMetrics_pm100_environmental_tag, 5},
+    {meshtastic_Telemetry_air_quality_metrics_tag, meshtastic_AirQualityMetrics_co2_tag, 50},
+};
+
+/// The metrics message of a Telemetry variant, or NULL for the ones we always send as they are
+static const pb_msgdesc_t *getMetricsMsg(pb_size_t variant)
+{
+    switch (variant) {
+    case meshtastic_Telemetry_device_metrics_tag:
+        return &meshtastic_DeviceMetrics_msg;
+    case meshtastic_Telemetry_environment_metrics_tag:
+        return &meshtastic_EnvironmentMetrics_msg;
+    case meshtastic_Telemetry_power_metrics_tag:
+        return &meshtastic_PowerMetrics_msg;
+    case meshtastic_Telemetry_air_quality_metrics_tag:
+        return &meshtastic_AirQualityMetrics_msg;
+    default:
+        return NULL;
+    }
+}
+
+/// The has_ flag of an optional metric, singular ones are always there
+static bool hasMetric(const pb_field_iter_t &field)
+{
+    return PB_HTYPE(field.type) != PB_HTYPE_OPTIONAL || *(bool *)field.pSize;
+}
+
+static float getMetric(const pb_field_iter_t &field)
+{
+    switch (PB_LTYPE(field.type)) {
+    case PB_LTYPE_FIXED32:
+        return *(float *)field.pData;
+    case PB_LTYPE_BOOL:
+        return *(bool *)field.pData;
+    default:
+        // The metrics messages only have unsigned varints, of either size
+        return field.data_size == sizeof(uint16_t) ? *(uint16_t *)field.pData : *(uint32_t *)field.pData;
+    }
+}
+
+static bool movedPastDeadband(pb_size_t variant, pb_size_t tag, float sent, float now)
+{
+    for (const auto &d : metricDeadbands) {
+        if (d.variant == variant && d.tag == tag)
+            return d.deadband != TELEMETRY_DEADBAND_NEVER && fabsf(now - sent) > d.deadband;
+    }
+    return fabsf(now - sent) > fabsf(sent) * TELEMETRY_DEFAULT_DEADBAND_PERCENT / 100;
+}
+
+/**
+ * Walk the metrics of two Telemetry messages of the same variant side by side.  fn gets the fields of both and returns false to
+ * stop early.
+ */
+template <typename F> static void forEachMetric(meshtastic_Telemetry &a, meshtastic_Telemetry &b, F fn)
+{
+    const pb_msgdesc_t *msg = getMetricsMsg(a.which_variant);
+    pb_field_iter_t fieldA, fieldB;
+    if (!msg || a.which_variant != b.which_variant || !pb_field_iter_begin(&fieldA, msg, &a.variant) ||
+        !pb_field_iter_begin(&fieldB, msg, &b.variant))
+        return;
+    do {
+        if (!fn(fieldA, fieldB))
+            return;
+    } while (pb_field_iter_next(&fieldA) && pb_field_iter_next(&fieldB));
+}
+
+/// Copy every metric that from has into into, leaving the others alone
+static void mergeMetrics(meshtastic_Telemetry &into, meshtastic_Telemetry &from)
+{
+    into.time = from.time;
+    forEachMetric(into, from, [](pb_field_iter_t &i, pb_field_iter_t &f) {
+        if (hasMetric(f)) {
+            memcpy(i.pData, f.pData, f.data_size);
+            if (PB_HTYPE(i.type) == PB_HTYPE_OPTIONAL)
+                *(bool *)i.pSize = true;
+        }
+        return true;
+    });
+}
+
+bool TelemetryDeadband::shouldBroadcast(const meshtastic_Telemetry &m)
+{
+    intervalsSinceKeyframe++;
+    if (!hasLastSent || lastSent.which_variant != m.which_variant || !getMetricsMsg(m.which_variant) ||
+        ++skippedIntervals >= TELEMETRY_HEARTBEAT_INTERVALS)
+        return true;
+
+    bool changed = false;
+    meshtastic_Telemetry now = m;
+    forEachMetric(lastSent, now, [&](pb_field_iter_t &sent, pb_field_iter_t &current) {
+        // A metric that comes or goes is a change as well
+        changed = hasMetric(sent) != hasMetric(current) ||
+                  (hasMetric(current) && movedPastDeadband(now.which_variant, current.tag, getMetric(sent), getMetric(current)));
+        return !changed;
+    });
+    if (!changed)
+        LOG_DEBUG("Telemetry within deadbands, skip broadcast (%u/%u)", skippedIntervals, TELEMETRY_HEARTBEAT_INTERVALS);
+    return changed;
+}
+
+void TelemetryDeadband::markBroadcast(meshtastic_MeshPacket *p, const meshtastic_Telemetry &m)
+{
+    meshtastic_Telemetry sent = m;
+    skippedIntervals = 0;
+
+#ifdef USERPREFS_TELEMETRY_DELTA_ENCODING
+    if (!getMetricsMsg(m.which_variant)) {
+        lastSent = sent;
+        hasLastSent = true;
+        return;
+    }
+
+    // Deltas can only say what changed, not that a metric went away, so that takes a full report as well
+    bool keyframe = !hasLastSent || lastSent.which_variant != m.which_variant ||
+                    intervalsSinceKeyframe >= TELEMETRY_HEARTBEAT_INTERVALS;
+    forEachMetric(lastSent, sent, [&](pb_field_iter_t &last, pb_field_iter_t &current) {
+        keyframe |= hasMetric(last) && !hasMetric(current);
+        return !keyframe;
+    });
+
+    p->decoded.has_bitfield = true;
+    if (keyframe) {
+        p->decoded.bitfield |= BITFIELD_TELEMETRY_KEYFRAME_MASK;
+        intervalsSinceKeyframe = 0;
+        lastSent = sent;
+    } else {
+        // Leave out whatever receivers already have close enough, and only remember what they will actually get
+        forEachMetric(lastSent, sent, [&](pb_field_iter_t &last, pb_field_iter_t &current) {
+            if (PB_HTYPE(current.type) == PB_HTYPE_OPTIONAL && hasMetric(last) && hasMetric(current) &&
+                !movedPastDeadband(sent.which_variant, current.tag, getMetric(last), getMetric(current)))
+                *(bool *)current.pSize = false;
+            return true;
+        });
+        mergeMetrics(lastSent, sent);
+
+        p->decoded.bitfield |= BITFIELD_TELEMETRY_DELTA_MASK;
+        p->decoded.payload.size =
+            pb_encode_to_bytes(p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes), &meshtastic_Telemetry_msg, &sent);
+    }
+#else
+    lastSent = sent;
+#endif
+    hasLastSent = true;
+}
+
+void TelemetryDeadband::send(meshtastic_MeshPacket *p, const meshtastic_Telemetry &m, bool phoneOnly)
+{
+    if (phoneOnly || !shouldBroadcast(m)) {
+        LOG_INFO("Send packet to phone");
+        service->sendToPhone(p);
+        return;
+    }
+
+    LOG_INFO("Send packet to mesh");
+    // Copy before markBroadcast, which may cut p down to a delta
+    service->sendToPhone(packetPool.allocCopy(*p));
+    markBroadcast(p, m);
+    service->sendToMesh(p, RX_SRC_LOCAL, false);
+}
+
+TelemetryDeltaCache::Source *TelemetryDeltaCache::findSource(NodeNum node, pb_size_t variant)
+{
+    for (auto &source : sources) {
+        if (source.node == node && source.metrics.which_variant == variant)
+            return &source;
+    }
+    return NULL;
+}
+
+void TelemetryDeltaCache::handleReceived(meshtastic_MeshPacket *p)
+{
+    uint32_t flags = p->decoded.bitfield & (BITFIELD_TELEMETRY_DELTA_MASK | BITFIELD_TELEMETRY_KEYFRAME_MASK);
+    if (p->decoded.portnum != meshtastic_PortNum_TELEMETRY_APP || !p->decoded.has_bitfield || !flags || isFromUs(p))
+        return;
+
+    meshtastic_Telemetry t = meshtastic_Telemetry_init_zero;
+    if (!pb_decode_from_bytes(p->decoded.payload.bytes, p->decoded.payload.size, &meshtastic_Telemetry_msg, &t))
+        return;
+
+    Source *source = findSource(p->from, t.which_variant);
+    if (flags & BITFIELD_TELEMETRY_KEYFRAME_MASK) {
+        if (!source && sources.size() < TELEMETRY_DELTA_MAX_SOURCES) {
+            sources.push_back({});
+            source = &sources.back();
+        } else if (!source) {
+            source = &*std::min_element(sources.begin(), sources.end(), [](const Source &a, const Source &b) {
+                return a.lastHeardMs < b.lastHeardMs;
+            });
+        }
+        *source = {p->from, millis(), t};
+        return;
+    }
+
+    if (!source) {
+        LOG_DEBUG("Delta telemetry from 0x%x before any full report, pass it on as is", p->from);
+        return;
+    }
+    source->lastHeardMs = millis();
+    mergeMetrics(source->metrics, t);
+
+    expandedFrom = p->from;
+    expandedId = p->id;
+    expandedPayload = p->decoded.payload;
+    expandedBitfield = p->decoded.bitfield;
+
+    p->decoded.bitfield &= ~BITFIELD_TELEMETRY_DELTA_MASK;
+    p->decoded.payload.size = pb_encode_to_bytes(p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes),
+                                                 &meshtastic_Telemetry_msg, &source->metrics);
+}
+
+void TelemetryDeltaCache::restoreForRelay(meshtastic_MeshPacket *p)
+{
+    if (p->which_payload_variant != meshtastic_MeshPacket_decoded_tag || p->from != expandedFrom || p->id != expandedId)
+        return;
+
+    p->decoded.payload = expandedPayload;
+    p->decoded.bitfield = expandedBitfield;
+}
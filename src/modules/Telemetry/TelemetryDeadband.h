@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../userPrefs.h"
+#include "../mesh/generated/meshtastic/telemetry.pb.h"
+#include "MeshTypes.h"
+#include "configuration.h"
+#include <vector>
+
+/// Broadcast telemetry at least once every this many update intervals, even if nothing moved past its deadband (1 means every
+/// interval, as before deadbands)
+#ifdef USERPREFS_TELEMETRY_HEARTBEAT_INTERVALS
+#define TELEMETRY_HEARTBEAT_INTERVALS USERPREFS_TELEMETRY_HEARTBEAT_INTERVALS
+#else
+#define TELEMETRY_HEARTBEAT_INTERVALS 4
+#endif
+
+/// A metric we have no deadband for counts as changed when it moved by more than this percentage
+#define TELEMETRY_DEFAULT_DEADBAND_PERCENT 5
+
+/// Nodes whose last full report we keep so their delta reports can be filled in, least recently heard is forgotten first
+#define TELEMETRY_DELTA_MAX_SOURCES 16
+
+/**
+ * Decides which of our periodic telemetry broadcasts are worth the airtime.
+ *
+ * The telemetry modules still look at their readings every update interval, but a broadcast only goes out if some metric moved
+ * past its deadband since the values we last sent, or if TELEMETRY_HEARTBEAT_INTERVALS intervals went by without one.  Skipped
+ * readings still go to our own phone.
+ *
+ * With USERPREFS_TELEMETRY_DELTA_ENCODING the broadcasts in between heartbeats only carry the metrics that changed, flagged
+ * with BITFIELD_TELEMETRY_DELTA; the heartbeats are full reports flagged with BITFIELD_TELEMETRY_KEYFRAME.  Receivers fill in
+ * the missing metrics from the sender's last report, see TelemetryDeltaCache.
+ */
+class TelemetryDeadband
+{
+  public:
+    /**
+     * Send p, built from the reading m, to our phone and, if it is worth the airtime, to the mesh.  The phone always gets the
+     * full report.  Call this once per update interval, as the intervals we declined are what makes the next heartbeat come due.
+     */
+    void send(meshtastic_MeshPacket *p, const meshtastic_Telemetry &m, bool phoneOnly);
+
+  private:
+    meshtastic_Telemetry lastSent = meshtastic_Telemetry_init_zero;
+    bool hasLastSent = false;
+
+    /// Update intervals since our last broadcast
+    uint32_t skippedIntervals = 0;
+
+    /// Update intervals since our last full report, when delta encoding
+    uint32_t intervalsSinceKeyframe = 0;
+
+    /// Whether the reading m is worth broadcasting
+    bool shouldBroadcast(const meshtastic_Telemetry &m);
+
+    /**
+     * Remember m as broadcast in p, which was built from it.  With delta encoding on, p gets re-encoded with only the metrics
+     * that changed (unless this is a heartbeat) and flagged accordingly.
+     */
+    void markBroadcast(meshtastic_MeshPacket *p, const meshtastic_Telemetry &m);
+};
+
+/**
+ * Rebuilds delta telemetry reports from other nodes into full ones, so NodeDB, the modules and the phone never see the gaps.
+ *
+ * Relays should pass on the compact report they received rather than the rebuilt one, so the original payload of the packet
+ * we last expanded is kept around for FloodingRouter.
+ */
+class TelemetryDeltaCache
+{
+  public:
+    /// Called on every decoded packet, expands p in place if it is a delta report we have a base for
+    void handleReceived(meshtastic_MeshPacket *p);
+
+    /// If p is a copy of the packet we just expanded, put the payload it arrived with back
+    void restoreForRelay(meshtastic_MeshPacket *p);
+
+  private:
+    struct Source {
+        NodeNum node;
+        uint32_t lastHeardMs;
+        meshtastic_Telemetry metrics;
+    };
+    std::vector<Source> sources;
+
+    // The packet we last expanded, as it came in
+    NodeNum expandedFrom = 0;
+    PacketId expandedId = 0;
+    meshtastic_Data_payload_t expandedPayload = {};
+    uint32_t expandedBitfield = 0;
+
+    Source *findSource(NodeNum node, pb_size_t variant);
+};
+
+extern TelemetryDeltaCache telemetryDeltaCache;
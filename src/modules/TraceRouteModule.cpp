@@ -1,11 +1,16 @@
 #include "TraceRouteModule.h"
 #include "MeshService.h"
+#include "MeshTopology.h"
 #include "meshUtils.h"
 
 TraceRouteModule *traceRouteModule;
 
 bool TraceRouteModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshtastic_RouteDiscovery *r)
 {
+    // Every route that goes past us tells us a bit more about the mesh
+    if (r && meshTopology)
+        meshTopology->addRoute(mp, r);
+
     // We only alter the packet in alterReceivedProtobuf()
     return false; // let it be handled by RoutingModule
 }
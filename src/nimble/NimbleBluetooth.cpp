@@ -77,6 +77,21 @@ class NimbleBluetoothFromRadioCallback : public NimBLECharacteristicCallbacks
     }
 };
 
+static uint8_t fromRadioBatchBytes[FROMRADIO_BATCH_MAX_SIZE];
+
+class NimbleBluetoothFromRadioBatchCallback : public NimBLECharacteristicCallbacks
+{
+    virtual void onRead(NimBLECharacteristic *pCharacteristic, ble_gap_conn_desc *desc)
+    {
+        // Fill one ATT read response (MTU - 3, the same limit NimBLE uses to spot long reads) so the phone needs no
+        // follow up reads
+        uint16_t maxLen = bleServer->getPeerMTU(desc->conn_handle) - 3;
+        size_t numBytes = bluetoothPhoneAPI->getFromRadioBatch(fromRadioBatchBytes, maxLen);
+
+        pCharacteristic->setValue(fromRadioBatchBytes, numBytes);
+    }
+};
+
 class NimbleBluetoothServerCallback : public NimBLEServerCallbacks
 {
     virtual uint32_t onPassKeyRequest()
@@ -123,6 +138,15 @@ class NimbleBluetoothServerCallback : public NimBLEServerCallbacks
         return passkey;
     }
 
+    virtual void onConnect(NimBLEServer *pServer, ble_gap_conn_desc *desc)
+    {
+        // Longer link layer packets and, where the controller has it, the 2M PHY make large (batched) reads much faster
+        pServer->setDataLen(desc->conn_handle, 251);
+#ifndef CONFIG_IDF_TARGET_ESP32 // The original ESP32 is a BLE 4.2 part without 2M PHY
+        ble_gap_set_prefered_le_phy(desc->conn_handle, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_CODED_ANY);
+#endif
+    }
+
     virtual void onAuthenticationComplete(ble_gap_conn_desc *desc)
     {
         LOG_INFO("BLE authentication complete");
@@ -145,6 +169,7 @@ class NimbleBluetoothServerCallback : public NimBLEServerCallbacks
 
 static NimbleBluetoothToRadioCallback *toRadioCallbacks;
 static NimbleBluetoothFromRadioCallback *fromRadioCallbacks;
+static NimbleBluetoothFromRadioBatchCallback *fromRadioBatchCallbacks;
 
 void NimbleBluetooth::shutdown()
 {
@@ -197,6 +222,8 @@ void NimbleBluetooth::setup()
 
     NimBLEDevice::init(getDeviceName());
     NimBLEDevice::setPower(ESP_PWR_LVL_P9);
+    // Let phones negotiate the largest ATT MTU, so a batched FromRadio read carries up to 512 bytes
+    NimBLEDevice::setMTU(517);
 
     if (config.bluetooth.mode != meshtastic_Config_BluetoothConfig_PairingMode_NO_PIN) {
         NimBLEDevice::setSecurityAuth(BLE_SM_PAIR_AUTHREQ_BOND | BLE_SM_PAIR_AUTHREQ_MITM | BLE_SM_PAIR_AUTHREQ_SC);
@@ -217,10 +244,13 @@ void NimbleBluetooth::setupService()
     NimBLEService *bleService = bleServer->createService(MESH_SERVICE_UUID);
     NimBLECharacteristic *ToRadioCharacteristic;
     NimBLECharacteristic *FromRadioCharacteristic;
+    NimBLECharacteristic *FromRadioBatchCharacteristic;
     // Define the characteristics that the app is looking for
     if (config.bluetooth.mode == meshtastic_Config_BluetoothConfig_PairingMode_NO_PIN) {
         ToRadioCharacteristic = bleService->createCharacteristic(TORADIO_UUID, NIMBLE_PROPERTY::WRITE);
         FromRadioCharacteristic = bleService->createCharacteristic(FROMRADIO_UUID, NIMBLE_PROPERTY::READ);
+        FromRadioBatchCharacteristic =
+            bleService->createCharacteristic(FROMRADIO_BATCH_UUID, NIMBLE_PROPERTY::READ, FROMRADIO_BATCH_MAX_SIZE);
         fromNumCharacteristic = bleService->createCharacteristic(FROMNUM_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ);
         logRadioCharacteristic =
             bleService->createCharacteristic(LOGRADIO_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ, 512U);
@@ -229,6 +259,9 @@ void NimbleBluetooth::setupService()
             TORADIO_UUID, NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_AUTHEN | NIMBLE_PROPERTY::WRITE_ENC);
         FromRadioCharacteristic = bleService->createCharacteristic(
             FROMRADIO_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC);
+        FromRadioBatchCharacteristic = bleService->createCharacteristic(
+            FROMRADIO_BATCH_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC,
+            FROMRADIO_BATCH_MAX_SIZE);
         fromNumCharacteristic =
             bleService->createCharacteristic(FROMNUM_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ |
                                                                NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC);
@@ -244,6 +277,9 @@ void NimbleBluetooth::setupService()
     fromRadioCallbacks = new NimbleBluetoothFromRadioCallback();
     FromRadioCharacteristic->setCallbacks(fromRadioCallbacks);
 
+    fromRadioBatchCallbacks = new NimbleBluetoothFromRadioBatchCallback();
+    FromRadioBatchCharacteristic->setCallbacks(fromRadioBatchCallbacks);
+
     bleService->start();
 
     // Setup the battery service
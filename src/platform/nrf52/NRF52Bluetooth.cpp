@@ -11,6 +11,7 @@
 static BLEService meshBleService = BLEService(BLEUuid(MESH_SERVICE_UUID_16));
 static BLECharacteristic fromNum = BLECharacteristic(BLEUuid(FROMNUM_UUID_16));
 static BLECharacteristic fromRadio = BLECharacteristic(BLEUuid(FROMRADIO_UUID_16));
+static BLECharacteristic fromRadioBatch = BLECharacteristic(BLEUuid(FROMRADIO_BATCH_UUID_16));
 static BLECharacteristic toRadio = BLECharacteristic(BLEUuid(TORADIO_UUID_16));
 static BLECharacteristic logRadio = BLECharacteristic(BLEUuid(LOGRADIO_UUID_16));
 
@@ -26,6 +27,7 @@ static BLEDfuSecure bledfusecure;                                             //
 // process at once
 // static uint8_t trBytes[_max(_max(_max(_max(ToRadio_size, RadioConfig_size), User_size), MyNodeInfo_size), FromRadio_size)];
 static uint8_t fromRadioBytes[meshtastic_FromRadio_size];
+static uint8_t fromRadioBatchBytes[FROMRADIO_BATCH_MAX_SIZE];
 static uint8_t toRadioBytes[meshtastic_ToRadio_size];
 
 static uint16_t connectionHandle;
@@ -61,6 +63,11 @@ void onConnect(uint16_t conn_handle)
     char central_name[32] = {0};
     connection->getPeerName(central_name, sizeof(central_name));
     LOG_INFO("BLE Connected to %s", central_name);
+
+    // Larger ATT and link layer packets on the 2M PHY (if the phone agrees) make large (batched) reads much faster
+    connection->requestPHY();
+    connection->requestDataLengthUpdate();
+    connection->requestMtuExchange(Bluefruit.getMaxMtu(BLE_GAP_ROLE_PERIPH));
 }
 /**
  * Callback invoked when a connection is dropped
@@ -141,6 +148,19 @@ void onFromRadioAuthorize(uint16_t conn_hdl, BLECharacteristic *chr, ble_gatts_e
     }
     authorizeRead(conn_hdl);
 }
+/**
+ * Same as onFromRadioAuthorize, but packs as many FromRadio packets as fit the MTU into the value
+ */
+void onFromRadioBatchAuthorize(uint16_t conn_hdl, BLECharacteristic *chr, ble_gatts_evt_read_t *request)
+{
+    if (request->offset == 0) {
+        // One ATT read response carries MTU - 1 bytes, anything bigger (a single large packet) takes a long read
+        uint16_t maxLen = Bluefruit.Connection(conn_hdl)->getMtu() - 1;
+        size_t numBytes = bluetoothPhoneAPI->getFromRadioBatch(fromRadioBatchBytes, maxLen);
+        fromRadioBatch.write(fromRadioBatchBytes, numBytes);
+    }
+    authorizeRead(conn_hdl);
+}
 // Last ToRadio value received from the phone
 static uint8_t lastToRadio[MAX_TO_FROM_RADIO_SIZE];
 
@@ -187,6 +207,13 @@ void setupMeshService(void)
     // for two copies
     fromRadio.begin();
 
+    fromRadioBatch.setProperties(CHR_PROPS_READ);
+    fromRadioBatch.setPermission(secMode, SECMODE_NO_ACCESS);
+    fromRadioBatch.setMaxLen(sizeof(fromRadioBatchBytes));
+    fromRadioBatch.setReadAuthorizeCallback(onFromRadioBatchAuthorize, false);
+    fromRadioBatch.setBuffer(fromRadioBatchBytes, sizeof(fromRadioBatchBytes));
+    fromRadioBatch.begin();
+
     toRadio.setProperties(CHR_PROPS_WRITE);
     toRadio.setPermission(secMode, secMode); // FIXME secure this!
     toRadio.setFixedLen(0);
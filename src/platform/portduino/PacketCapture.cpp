@@ -0,0 +1,226 @@
+#include "PacketCapture.h"
+#include "configuration.h"
+#include <chrono>
+#include <string.h>
+#include <sys/time.h>
+
+PacketCapture *packetCapture;
+
+// pcapng block types, see https://www.ietf.org/archive/id/draft-ietf-opsawg-pcapng-02.html
+#define PCAPNG_SECTION_HEADER 0x0A0D0D0A
+#define PCAPNG_INTERFACE_DESCRIPTION 1
+#define PCAPNG_ENHANCED_PACKET 6
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_OPT_COMMENT 1
+
+// LoRaTap version 0, see https://github.com/eriknl/LoRaTap
+#define LORATAP_HEADER_LEN 15
+
+#define CAPTURE_MAX_COMMENT 80
+
+#define PAD4(len) (((len) + 3) & ~(size_t)3)
+
+// pcapng fields are in our own byte order (the section header tells readers which that is)
+static uint8_t *put16(uint8_t *out, uint16_t v)
+{
+    memcpy(out, &v, sizeof(v));
+    return out + sizeof(v);
+}
+
+static uint8_t *put32(uint8_t *out, uint32_t v)
+{
+    memcpy(out, &v, sizeof(v));
+    return out + sizeof(v);
+}
+
+// LoRaTap fields are big endian
+static uint8_t *put16be(uint8_t *out, uint16_t v)
+{
+    *out++ = v >> 8;
+    *out++ = v;
+    return out;
+}
+
+static uint8_t *put32be(uint8_t *out, uint32_t v)
+{
+    out = put16be(out, v >> 16);
+    return put16be(out, v);
+}
+
+PacketCapture::PacketCapture(const std::string &_path, size_t _maxFileBytes, uint8_t _numFiles)
+    : path(_path), maxFileBytes(_maxFileBytes), numFiles(_numFiles)
+{
+    pending.reserve(CAPTURE_FLUSH_BYTES);
+    writer = std::thread(&PacketCapture::writerLoop, this);
+}
+
+PacketCapture::~PacketCapture()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    writer.join();
+}
+
+void PacketCapture::record(const meshtastic_MeshPacket *p, RadioInterface *radio, const char *result)
+{
+    if (openFailed && !reportedFailure) {
+        LOG_ERROR("Can't open packet capture file %s", path.c_str());
+        reportedFailure = true;
+    }
+    if (p->which_payload_variant != meshtastic_MeshPacket_encrypted_tag)
+        return;
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    uint64_t usec = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+
+    // The frame as it was on air, see RadioInterface::beginSending()
+    uint8_t frame[LORATAP_HEADER_LEN + sizeof(PacketHeader) + sizeof(p->encrypted.bytes)];
+    uint8_t *out = frame;
+    *out++ = 0; // version
+    *out++ = 0; // padding
+    out = put16be(out, LORATAP_HEADER_LEN);
+    out = put32be(out, radio ? (uint32_t)(radio->getFreq() * 1000000) : 0);
+    *out++ = radio ? (uint8_t)(radio->getBandwidth() / 125) : 0; // In 125kHz steps
+    *out++ = radio ? radio->getSpreadingFactor() : 0;
+    int32_t rssi = p->rx_rssi ? p->rx_rssi + 139 : 0; // Offset by -139dBm
+    rssi = rssi < 0 ? 0 : (rssi > 255 ? 255 : rssi);
+    *out++ = rssi; // packet RSSI
+    *out++ = rssi; // max RSSI
+    *out++ = 0;    // current RSSI, unknown
+    *out++ = (int8_t)(p->rx_snr * 4);
+    *out++ = 0x2b; // sync word, see RadioLibInterface::syncWord
+
+    PacketHeader h = {};
+    h.to = p->to;
+    h.from = p->from;
+    h.id = p->id;
+    h.channel = p->channel;
+    h.next_hop = p->next_hop;
+    h.relay_node = p->relay_node;
+    h.flags = (p->hop_limit & PACKET_FLAGS_HOP_LIMIT_MASK) | (p->want_ack ? PACKET_FLAGS_WANT_ACK_MASK : 0) |
+              (p->via_mqtt ? PACKET_FLAGS_VIA_MQTT_MASK : 0) |
+              ((p->hop_start << PACKET_FLAGS_HOP_START_SHIFT) & PACKET_FLAGS_HOP_START_MASK);
+    memcpy(out, &h, sizeof(h));
+    out += sizeof(h);
+    memcpy(out, p->encrypted.bytes, p->encrypted.size);
+    out += p->encrypted.size;
+    size_t frameLen = out - frame;
+
+    size_t commentLen = strnlen(result, CAPTURE_MAX_COMMENT);
+    size_t blockLen = 28 + PAD4(frameLen) + 4 + PAD4(commentLen) + 4 + 4;
+    uint8_t block[28 + PAD4(sizeof(frame)) + 4 + PAD4(CAPTURE_MAX_COMMENT) + 4 + 4] = {};
+    out = block;
+    out = put32(out, PCAPNG_ENHANCED_PACKET);
+    out = put32(out, blockLen);
+    out = put32(out, 0); // interface
+    out = put32(out, usec >> 32);
+    out = put32(out, usec);
+    out = put32(out, frameLen); // captured
+    out = put32(out, frameLen); // on the wire
+    memcpy(out, frame, frameLen);
+    out += PAD4(frameLen);
+    out = put16(out, PCAPNG_OPT_COMMENT);
+    out = put16(out, commentLen);
+    memcpy(out, result, commentLen);
+    out += PAD4(commentLen);
+    out = put32(out, 0); // end of options
+    out = put32(out, blockLen);
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (pending.size() + blockLen > CAPTURE_MAX_PENDING_BYTES) {
+        if (!dropped++)
+            LOG_WARN("Packet capture can't keep up, drop packets from it");
+        return;
+    }
+    if (dropped) {
+        LOG_WARN("Packet capture dropped %u packets", dropped);
+        dropped = 0;
+    }
+    pending.insert(pending.end(), block, block + blockLen);
+    if (pending.size() >= CAPTURE_FLUSH_BYTES)
+        wakeup.notify_one();
+}
+
+void PacketCapture::writerLoop()
+{
+    // No logging from this thread, it isn't safe.  record() reports our problems.
+    openFile();
+
+    std::vector<uint8_t> batch;
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wakeup.wait_for(guard, std::chrono::seconds(1), [&] { return stopping || pending.size() >= CAPTURE_FLUSH_BYTES; });
+        bool stop = stopping;
+        batch.swap(pending);
+        guard.unlock();
+
+        if (file && !batch.empty()) {
+            fwrite(batch.data(), 1, batch.size(), file);
+            fflush(file);
+            fileBytes += batch.size();
+            if (fileBytes >= maxFileBytes)
+                rotate();
+        }
+        batch.clear();
+        if (stop)
+            break;
+        guard.lock();
+    }
+
+    if (file)
+        fclose(file);
+}
+
+bool PacketCapture::openFile()
+{
+    // A pcapng file may hold several sections, so appending to one from an earlier run is fine
+    file = fopen(path.c_str(), "ab");
+    if (!file) {
+        openFailed = true;
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    fileBytes = ftell(file);
+
+    uint8_t headers[28 + 20];
+    uint8_t *out = headers;
+    out = put32(out, PCAPNG_SECTION_HEADER);
+    out = put32(out, 28);
+    out = put32(out, PCAPNG_BYTE_ORDER_MAGIC);
+    out = put16(out, 1); // major version
+    out = put16(out, 0); // minor version
+    out = put32(out, 0xffffffff);
+    out = put32(out, 0xffffffff); // section length unknown
+    out = put32(out, 28);
+
+    out = put32(out, PCAPNG_INTERFACE_DESCRIPTION);
+    out = put32(out, 20);
+    out = put16(out, PCAP_LINKTYPE_LORATAP);
+    out = put16(out, 0);
+    out = put32(out, 0); // no snap length, timestamps default to microseconds
+    out = put32(out, 20);
+
+    fwrite(headers, 1, sizeof(headers), file);
+    fileBytes += sizeof(headers);
+    return true;
+}
+
+void PacketCapture::rotate()
+{
+    fclose(file);
+    file = NULL;
+
+    if (numFiles <= 1) {
+        remove(path.c_str());
+    } else {
+        for (int i = numFiles - 1; i > 0; i--) {
+            std::string from = i == 1 ? path : path + "." + std::to_string(i - 1);
+            rename(from.c_str(), (path + "." + std::to_string(i)).c_str());
+        }
+    }
+    openFile();
+}
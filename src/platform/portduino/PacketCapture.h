@@ -0,0 +1,74 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "RadioInterface.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// pcap link type for LoRa frames behind a LoRaTap header, which Wireshark understands
+#define PCAP_LINKTYPE_LORATAP 270
+
+/// Hand the writer what we have once this much is waiting, it also writes once a second regardless
+#define CAPTURE_FLUSH_BYTES (64 * 1024)
+
+/// If the writer falls this far behind we drop records rather than grow without bound
+#define CAPTURE_MAX_PENDING_BYTES (4 * 1024 * 1024)
+
+/**
+ * Writes every packet we receive to a pcapng file, for Wireshark or offline tools, at far less cost than the JSON trace.
+ *
+ * Each record holds the frame as it was on air (header and still encrypted payload) behind a LoRaTap header with the
+ * frequency, bandwidth, spreading factor, RSSI and SNR, and a comment saying what we made of it (decoded on which channel and
+ * port, dropped as a duplicate, ...).
+ *
+ * record() only appends to a buffer, a thread of our own does the file writing.  Once the file grows past maxFileBytes it is
+ * rotated: path becomes path.1, path.1 becomes path.2 and so on, keeping numFiles files in all.
+ */
+class PacketCapture
+{
+  public:
+    PacketCapture(const std::string &path, size_t maxFileBytes, uint8_t numFiles);
+    ~PacketCapture();
+
+    /**
+     * Capture a packet we received, call from the main thread only
+     * @param p the packet as it came in, still encrypted
+     * @param radio the radio it came in on (for the LoRaTap header), NULL if it didn't come from a radio
+     * @param result what we made of it
+     */
+    void record(const meshtastic_MeshPacket *p, RadioInterface *radio, const char *result);
+
+  private:
+    std::string path;
+    size_t maxFileBytes;
+    uint8_t numFiles;
+
+    std::mutex lock;
+    std::condition_variable wakeup;
+    std::vector<uint8_t> pending; // Records waiting for the writer
+    bool stopping = false;
+
+    /// Records we had to drop, and whether the writer failed to open the file, reported from the main thread
+    uint32_t dropped = 0;
+    std::atomic<bool> openFailed{false};
+    bool reportedFailure = false;
+
+    // Only touched by the writer thread
+    std::thread writer;
+    FILE *file = NULL;
+    size_t fileBytes = 0;
+
+    void writerLoop();
+
+    /// Open path (appending a new section if it exists) and write the pcapng headers
+    bool openFile();
+
+    void rotate();
+};
+
+extern PacketCapture *packetCapture;
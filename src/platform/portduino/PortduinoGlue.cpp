@@ -2,12 +2,14 @@
 #include "PortduinoGPIO.h"
 #include "SPIChip.h"
 #include "mesh/RF95Interface.h"
+#include "mesh/RadioInterface.h"
 #include "sleep.h"
 #include "target_specific.h"
 
 #include <Utility.h>
 #include <assert.h>
 
+#include "PacketCapture.h"
 #include "PortduinoGlue.h"
 #include "linux/gpio/LinuxGPIOPin.h"
 #include "yaml-cpp/yaml.h"
@@ -81,6 +83,10 @@ void portduinoSetup()
                                       irq,
                                       busy,
                                       reset,
+                                      lora2_cs,
+                                      lora2_irq,
+                                      lora2_busy,
+                                      lora2_reset,
                                       sx126x_ant_sw,
                                       txen,
                                       rxen,
@@ -172,6 +178,13 @@ void portduinoSetup()
             settingsMap[reset] = RADIOLIB_NC;
         }
     }
+    for (configNames i : {lora2_cs, lora2_irq, lora2_busy, lora2_reset}) {
+        if (settingsMap.count(i) > 0 && settingsMap[i] != RADIOLIB_NC) {
+            if (initGPIOPin(settingsMap[i], gpioChipName) != ERRNO_OK) {
+                settingsMap[i] = RADIOLIB_NC;
+            }
+        }
+    }
     if (settingsMap.count(sx126x_ant_sw) > 0 && settingsMap[sx126x_ant_sw] != RADIOLIB_NC) {
         if (initGPIOPin(settingsMap[sx126x_ant_sw], gpioChipName) != ERRNO_OK) {
             settingsMap[sx126x_ant_sw] = RADIOLIB_NC;
@@ -221,6 +234,10 @@ void portduinoSetup()
             exit(EXIT_FAILURE);
         }
     }
+    if (settingsStrings[captureFilename] != "") {
+        packetCapture = new PacketCapture(settingsStrings[captureFilename], (size_t)settingsMap[captureMaxMB] * 1024 * 1024,
+                                          settingsMap[captureFiles]);
+    }
 
     return;
 }
@@ -263,6 +280,9 @@ bool loadConfig(const char *configPath)
                 settingsMap[logoutputlevel] = level_error;
             }
             settingsStrings[traceFilename] = yamlConfig["Logging"]["TraceFile"].as<std::string>("");
+            settingsStrings[captureFilename] = yamlConfig["Logging"]["CaptureFile"].as<std::string>("");
+            settingsMap[captureMaxMB] = yamlConfig["Logging"]["CaptureMaxMB"].as<int>(64);
+            settingsMap[captureFiles] = yamlConfig["Logging"]["CaptureFiles"].as<int>(4);
             if (yamlConfig["Logging"]["AsciiLogs"]) {
                 // Default is !isatty(1) but can be set explicitly in config.yaml
                 settingsMap[ascii_logs] = yamlConfig["Logging"]["AsciiLogs"].as<bool>();
@@ -307,6 +327,37 @@ bool loadConfig(const char *configPath)
                 }
             }
         }
+        if (yamlConfig["Lora2"]) {
+            // A second radio on the same SPI bus, for a gateway between two presets or frequency slots
+            static const std::map<std::string, meshtastic_Config_LoRaConfig_ModemPreset> presets = {
+                {"LONG_FAST", meshtastic_Config_LoRaConfig_ModemPreset_LONG_FAST},
+                {"LONG_SLOW", meshtastic_Config_LoRaConfig_ModemPreset_LONG_SLOW},
+                {"VERY_LONG_SLOW", meshtastic_Config_LoRaConfig_ModemPreset_VERY_LONG_SLOW},
+                {"MEDIUM_SLOW", meshtastic_Config_LoRaConfig_ModemPreset_MEDIUM_SLOW},
+                {"MEDIUM_FAST", meshtastic_Config_LoRaConfig_ModemPreset_MEDIUM_FAST},
+                {"SHORT_SLOW", meshtastic_Config_LoRaConfig_ModemPreset_SHORT_SLOW},
+                {"SHORT_FAST", meshtastic_Config_LoRaConfig_ModemPreset_SHORT_FAST},
+                {"LONG_MODERATE", meshtastic_Config_LoRaConfig_ModemPreset_LONG_MODERATE},
+                {"SHORT_TURBO", meshtastic_Config_LoRaConfig_ModemPreset_SHORT_TURBO}};
+
+            settingsStrings[lora2_module] = yamlConfig["Lora2"]["Module"].as<std::string>("");
+            settingsMap[lora2_cs] = yamlConfig["Lora2"]["CS"].as<int>(RADIOLIB_NC);
+            settingsMap[lora2_irq] = yamlConfig["Lora2"]["IRQ"].as<int>(RADIOLIB_NC);
+            settingsMap[lora2_busy] = yamlConfig["Lora2"]["Busy"].as<int>(RADIOLIB_NC);
+            settingsMap[lora2_reset] = yamlConfig["Lora2"]["Reset"].as<int>(RADIOLIB_NC);
+
+            auto preset = presets.find(yamlConfig["Lora2"]["ModemPreset"].as<std::string>(""));
+            settingsMap[lora2_modem_preset] = preset != presets.end() ? preset->second : -1;
+            settingsMap[lora2_channel_num] = yamlConfig["Lora2"]["ChannelNum"].as<int>(0);
+            settingsMap[lora2_frequency_khz] = yamlConfig["Lora2"]["Frequency"].as<float>(0) * 1000;
+
+            settingsMap[lora2_bridge] = BRIDGE_ALL;
+            if (yamlConfig["Lora2"]["Bridge"].as<std::string>("all") == "broadcasts") {
+                settingsMap[lora2_bridge] = BRIDGE_BROADCASTS;
+            } else if (yamlConfig["Lora2"]["Bridge"].as<std::string>("all") == "none") {
+                settingsMap[lora2_bridge] = BRIDGE_NONE;
+            }
+        }
         if (yamlConfig["GPIO"]) {
             settingsMap[user] = yamlConfig["GPIO"]["User"].as<int>(RADIOLIB_NC);
         }
@@ -404,6 +455,7 @@ bool loadConfig(const char *configPath)
             settingsMap[maxnodes] = (yamlConfig["General"]["MaxNodes"]).as<int>(200);
             settingsMap[maxtophone] = (yamlConfig["General"]["MaxMessageQueue"]).as<int>(100);
             settingsStrings[config_directory] = (yamlConfig["General"]["ConfigDirectory"]).as<std::string>("");
+            settingsMap[receive_workers] = (yamlConfig["General"]["ReceiveWorkers"]).as<int>(0);
         }
 
     } catch (YAML::Exception &e) {
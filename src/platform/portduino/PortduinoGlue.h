@@ -17,6 +17,15 @@ enum configNames {
     use_rf95,
     use_sx1280,
     use_sx1268,
+    lora2_module,
+    lora2_cs,
+    lora2_irq,
+    lora2_busy,
+    lora2_reset,
+    lora2_modem_preset,
+    lora2_channel_num,
+    lora2_frequency_khz,
+    lora2_bridge,
     user,
     gpiochip,
     spidev,
@@ -50,13 +59,17 @@ enum configNames {
     keyboardDevice,
     logoutputlevel,
     traceFilename,
+    captureFilename,
+    captureMaxMB,
+    captureFiles,
     webserver,
     webserverport,
     webserverrootpath,
     maxtophone,
     maxnodes,
     ascii_logs,
-    config_directory
+    config_directory,
+    receive_workers
 };
 enum { no_screen, x11, st7789, st7735, st7735s, st7796, ili9341, ili9342, ili9488, hx8357d };
 enum { no_touchscreen, xpt2046, stmpe610, gt911, ft5x06 };
@@ -0,0 +1,154 @@
+#include "ReceivePipeline.h"
+#include "PacketAggregator.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+#include <AES.h>
+#include <CTR.h>
+#include <algorithm>
+
+ReceivePipeline *receivePipeline;
+
+ReceivePipeline::ReceivePipeline(uint8_t numWorkers)
+{
+    numWorkers = std::min(numWorkers, (uint8_t)RECEIVE_PIPELINE_MAX_WORKERS);
+    for (uint8_t i = 0; i < numWorkers; i++) {
+        Worker *w = new Worker();
+        workers.push_back(w);
+        w->thread = std::thread(&ReceivePipeline::workerLoop, this, w);
+    }
+    LOG_INFO("Decode received packets on %u worker threads", numWorkers);
+}
+
+ReceivePipeline::~ReceivePipeline()
+{
+    for (Worker *w : workers) {
+        {
+            std::lock_guard<std::mutex> guard(w->lock);
+            w->stopping = true;
+        }
+        w->wakeup.notify_one();
+        w->thread.join();
+        delete w;
+    }
+}
+
+bool ReceivePipeline::hasRoom()
+{
+    return numInFlight < RECEIVE_PIPELINE_MAX_IN_FLIGHT;
+}
+
+bool ReceivePipeline::isIdle()
+{
+    return numInFlight == 0;
+}
+
+void ReceivePipeline::submit(meshtastic_MeshPacket *p, RadioInterface *radio)
+{
+    Job job = {};
+    job.p = p;
+    job.radio = radio;
+
+    // Gather the keys now, as channels can change under the workers.  Packets that may be for PKI are left to perhapsDecode(),
+    // which tries that first, and aggregates are unbundled before they get decoded.
+    bool maybePki = p->channel == 0 && isToUs(p);
+    if (p->which_payload_variant == meshtastic_MeshPacket_encrypted_tag && !maybePki && !PacketAggregator::isAggregate(p))
+        job.numKeys = channels.getKeysForHash(p->channel, job.chIndexes, job.keys);
+
+    Worker *w = workers[p->from % workers.size()];
+    {
+        std::lock_guard<std::mutex> guard(w->lock);
+        w->jobs.push_back(job);
+    }
+    w->wakeup.notify_one();
+    numInFlight++;
+}
+
+meshtastic_MeshPacket *ReceivePipeline::poll(RadioInterface **radio)
+{
+    for (size_t i = 0; i < workers.size(); i++) {
+        Worker *w = workers[(nextPoll + i) % workers.size()];
+        std::lock_guard<std::mutex> guard(w->lock);
+        if (!w->numDone)
+            continue;
+
+        current = w->jobs.front();
+        w->jobs.pop_front();
+        w->numDone--;
+        numInFlight--;
+        nextPoll = (nextPoll + i + 1) % workers.size();
+
+        *radio = current.radio;
+        return current.p;
+    }
+    return NULL;
+}
+
+bool ReceivePipeline::takeDecoded(meshtastic_MeshPacket *p, ChannelIndex *chIndex)
+{
+    if (current.p != p || !current.decoded)
+        return false;
+
+    memcpy(&p->decoded, &current.data, sizeof(p->decoded));
+    *chIndex = current.chIndex;
+    current.p = NULL;
+    return true;
+}
+
+void ReceivePipeline::workerLoop(Worker *w)
+{
+    std::unique_lock<std::mutex> guard(w->lock);
+    while (true) {
+        w->wakeup.wait(guard, [&] { return w->stopping || w->numDone < w->jobs.size(); });
+        if (w->stopping)
+            return;
+
+        // The main thread only ever removes finished jobs, so this one stays put while we work on it
+        Job &job = w->jobs[w->numDone];
+        guard.unlock();
+        decode(job);
+        guard.lock();
+        w->numDone++;
+    }
+}
+
+void ReceivePipeline::decode(Job &job)
+{
+    // No logging in here, it isn't safe from other threads.  perhapsDecode() complains about whatever we couldn't decode.
+    size_t rawSize = job.p->encrypted.size;
+    if (rawSize > MAX_LORA_PAYLOAD_LEN)
+        return;
+
+    // Same nonce as CryptoEngine::initNonce()
+    uint8_t nonce[16] = {};
+    uint64_t packetId = job.p->id;
+    memcpy(nonce, &packetId, sizeof(uint64_t));
+    memcpy(nonce + sizeof(uint64_t), &job.p->from, sizeof(uint32_t));
+
+    for (uint8_t i = 0; i < job.numKeys; i++) {
+        const CryptoKey &key = job.keys[i];
+        uint8_t bytes[MAX_LORA_PAYLOAD_LEN];
+        if (key.length == 0) {
+            memcpy(bytes, job.p->encrypted.bytes, rawSize);
+        } else if (key.length == 16) {
+            CTR<AES128> ctr;
+            ctr.setKey(key.bytes, key.length);
+            ctr.setIV(nonce, sizeof(nonce));
+            ctr.setCounterSize(4);
+            ctr.encrypt(bytes, job.p->encrypted.bytes, rawSize);
+        } else {
+            CTR<AES256> ctr;
+            ctr.setKey(key.bytes, key.length);
+            ctr.setIV(nonce, sizeof(nonce));
+            ctr.setCounterSize(4);
+            ctr.encrypt(bytes, job.p->encrypted.bytes, rawSize);
+        }
+
+        memset(&job.data, 0, sizeof(job.data));
+        pb_istream_t stream = pb_istream_from_buffer(bytes, rawSize);
+        if (pb_decode(&stream, &meshtastic_Data_msg, &job.data) && job.data.portnum != meshtastic_PortNum_UNKNOWN_APP) {
+            job.decoded = true;
+            job.chIndex = job.chIndexes[i];
+            return;
+        }
+    }
+}
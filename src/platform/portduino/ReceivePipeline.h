@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Channels.h"
+#include "CryptoEngine.h"
+#include "MeshTypes.h"
+#include "RadioInterface.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define RECEIVE_PIPELINE_MAX_WORKERS 16
+
+/// Packets handed to the workers but not yet taken back, the Router leaves the rest in its queue until there is room
+#define RECEIVE_PIPELINE_MAX_IN_FLIGHT 32
+
+/**
+ * Decrypts and decodes received packets on a pool of worker threads, for gateways that hear more traffic than one core keeps
+ * up with.
+ *
+ * Only the self contained part of perhapsDecode() runs on the workers: trying the channel keys that match the packet's hash
+ * (copied on the main thread when the packet is submitted) and decoding the protobuf.  Anything that logs or touches NodeDB,
+ * the global crypto engine or the modules stays on the main thread, which takes the packets back in Router::runOnce() and
+ * handles them as before.  PKI packets and aggregates pass through the workers untouched.
+ *
+ * Packets from the same node always go to the same worker and come back in the order they were submitted, packets from
+ * different nodes may overtake each other.
+ */
+class ReceivePipeline
+{
+  public:
+    explicit ReceivePipeline(uint8_t numWorkers);
+    ~ReceivePipeline();
+
+    /// Whether another packet can be submitted
+    bool hasRoom();
+
+    /// Whether no packets are in the workers or waiting to be taken back
+    bool isIdle();
+
+    /**
+     * Hand a packet we received to the workers, it comes back out of poll() once decoded.  Call from the main thread only.
+     * @param radio the radio it came in on, NULL if we don't know
+     */
+    void submit(meshtastic_MeshPacket *p, RadioInterface *radio);
+
+    /**
+     * Take back the next packet a worker is done with, or NULL if none is ready yet.  Call from the main thread only.
+     * @param radio set to the radio the packet was submitted with
+     */
+    meshtastic_MeshPacket *poll(RadioInterface **radio);
+
+    /**
+     * If p is the packet poll() last returned and a worker managed to decode it, fill in p->decoded and chIndex and return true.
+     * perhapsDecode() calls this so it only has to do the rest of the work.
+     */
+    bool takeDecoded(meshtastic_MeshPacket *p, ChannelIndex *chIndex);
+
+    /// Forget what poll() last returned, once the Router is done with it.  It may well have been released by then.
+    void forgetCurrent() { current.p = NULL; }
+
+  private:
+    struct Job {
+        meshtastic_MeshPacket *p;
+        RadioInterface *radio;
+
+        // Filled in on the main thread by submit()
+        uint8_t numKeys;
+        ChannelIndex chIndexes[MAX_NUM_CHANNELS];
+        CryptoKey keys[MAX_NUM_CHANNELS];
+
+        // Filled in by the worker
+        bool decoded;
+        ChannelIndex chIndex;
+        meshtastic_Data data;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::mutex lock;
+        std::condition_variable wakeup;
+
+        /// In submission order, the first numDone are finished and waiting for poll()
+        std::deque<Job> jobs;
+        size_t numDone = 0;
+
+        bool stopping = false;
+    };
+
+    std::vector<Worker *> workers;
+
+    /// Jobs submitted but not yet returned by poll(), only touched by the main thread
+    size_t numInFlight = 0;
+
+    /// The worker poll() looks at first, so a busy node can't starve the others
+    size_t nextPoll = 0;
+
+    /// What poll() last returned, until perhapsDecode() takes it
+    Job current = {};
+
+    void workerLoop(Worker *w);
+
+    /// Try the job's keys on its packet, the part that runs on a worker
+    static void decode(Job &job);
+};
+
+extern ReceivePipeline *receivePipeline;
@@ -165,7 +165,7 @@ void SimRadio::onNotify(uint32_t notification)
                     startSend(txp);
                     // Packet has been sent, count it toward our TX airtime utilization.
                     uint32_t xmitMsec = getPacketTime(txp);
-                    airTime->logAirtime(TX_LOG, xmitMsec);
+                    getAirTime()->logAirtime(TX_LOG, xmitMsec);
 
                     notifyLater(xmitMsec, ISR_TX, false); // Model the time it is busy sending
                 }
@@ -244,7 +244,7 @@ void SimRadio::handleReceiveInterrupt(meshtastic_MeshPacket *p)
 
     printPacket("Lora RX", mp);
 
-    airTime->logAirtime(RX_LOG, xmitMsec);
+    getAirTime()->logAirtime(RX_LOG, xmitMsec);
 
     deliverToReceiver(mp);
 }
@@ -3,16 +3,35 @@
 #include "graphics/Screen.h"
 #include "main.h"
 #include "power.h"
+#if !MESHTASTIC_EXCLUDE_RANGETEST && !MESHTASTIC_EXCLUDE_GPS
+#include "modules/RangeTestModule.h"
+#endif
 #if defined(ARCH_PORTDUINO)
 #include "api/WiFiServerAPI.h"
 #include "input/LinuxInputImpl.h"
+#include "platform/portduino/PacketCapture.h"
+
+#endif
 
+// Write out what modules hold in RAM before we go down
+static void flushBeforeShutdown()
+{
+#if !MESHTASTIC_EXCLUDE_RANGETEST && !MESHTASTIC_EXCLUDE_GPS
+    if (rangeTestModuleRadio)
+        rangeTestModuleRadio->flushLog();
+#endif
+#if defined(ARCH_PORTDUINO)
+    // Lets the writer thread write out what is still buffered before it stops
+    delete packetCapture;
+    packetCapture = NULL;
 #endif
+}
 
 void powerCommandsCheck()
 {
     if (rebootAtMsec && millis() > rebootAtMsec) {
         LOG_INFO("Rebooting");
+        flushBeforeShutdown();
 #if defined(ARCH_ESP32)
         ESP.restart();
 #elif defined(ARCH_NRF52)
@@ -44,6 +63,7 @@ void powerCommandsCheck()
 
     if (shutdownAtMsec && millis() > shutdownAtMsec) {
         LOG_INFO("Shut down from admin command");
+        flushBeforeShutdown();
 #if defined(ARCH_NRF52) || defined(ARCH_ESP32) || defined(ARCH_RP2040)
         playShutdownMelody();
         power->shutdown();
@@ -49,13 +49,56 @@
  **********************************************************************************************************************/
 
 #include "xmodem.h"
+#include <algorithm>
 
 #ifdef FSCom
 
+#ifdef ARCH_NRF52
+#define FILE_O_APPEND FILE_O_WRITE // Adafruit LittleFS opens files for writing at their end
+#else
+#define FILE_O_APPEND "a"
+#endif
+
 XModemAdapter xModem;
 
 XModemAdapter::XModemAdapter() {}
 
+// CRC-16 CCITT (polynomial 0x1021) of every possible byte value
+static const uint16_t crc16Table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+    0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+    0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+    0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+    0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+    0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+    0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+    0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+    0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+    0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+    0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+    0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+    0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+    0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+    0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+    0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+    0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+    0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+    0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+    0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+    0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+    0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0,
+};
+
 /**
  * Calculates the CRC-16 CCITT checksum of the given buffer.
  *
@@ -66,19 +109,31 @@ XModemAdapter::XModemAdapter() {}
 unsigned short XModemAdapter::crc16_ccitt(const pb_byte_t *buffer, int length)
 {
     unsigned short crc16 = 0;
-    while (length != 0) {
-        crc16 = (unsigned char)(crc16 >> 8) | (crc16 << 8);
-        crc16 ^= *buffer;
-        crc16 ^= (unsigned char)(crc16 & 0xff) >> 4;
-        crc16 ^= (crc16 << 8) << 4;
-        crc16 ^= ((crc16 & 0xff) << 4) << 1;
-        buffer++;
-        length--;
-    }
+    while (length-- > 0)
+        crc16 = (crc16 << 8) ^ crc16Table[((crc16 >> 8) ^ *buffer++) & 0xff];
 
     return crc16;
 }
 
+static void putLE32(pb_byte_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static uint32_t getLE32(const pb_byte_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/// Turn the 16 bit seq of a packet into the block number closest to near
+static uint32_t toBlock(uint32_t seq, uint32_t near)
+{
+    return near + (int16_t)(uint16_t)(seq - near);
+}
+
 /**
  * Calculates the checksum of the given buffer and compares it to the given
  * expected checksum. Returns 1 if the checksums match, 0 otherwise.
@@ -103,6 +158,9 @@ void XModemAdapter::sendControl(meshtastic_XModem_Control c)
 
 meshtastic_XModem XModemAdapter::getForPhone()
 {
+    // A windowed download reads its next block once the phone has picked up the previous one, instead of waiting for an ACK
+    if (isWindowed && isTransmitting && xmodemStore.control == meshtastic_XModem_Control_NUL)
+        prepareNextBlock();
     return xmodemStore;
 }
 
@@ -113,6 +171,21 @@ void XModemAdapter::resetForPhone()
 
 void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
 {
+    if (xmodemPacket.seq == 0 &&
+        (xmodemPacket.control == meshtastic_XModem_Control_SOH || xmodemPacket.control == meshtastic_XModem_Control_STX)) {
+        // During a long upload seq 0 comes round again, as an ordinary data block
+        bool isDataBlock = isReceiving && (!isWindowed || toBlock(0, ackedBlock + 1) - ackedBlock - 1 < window);
+        if (!isDataBlock) {
+            if (startWindowed(xmodemPacket))
+                return;
+            abandonTransfer(); // A plain request replaces a windowed transfer the client gave up on
+        }
+    }
+    if (isWindowed) {
+        handleWindowedPacket(xmodemPacket);
+        return;
+    }
+
     switch (xmodemPacket.control) {
     case meshtastic_XModem_Control_SOH:
     case meshtastic_XModem_Control_STX:
@@ -180,6 +253,8 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
         sendControl(meshtastic_XModem_Control_ACK);
         file.flush();
         file.close();
+        if (isReceiving)
+            updateFilesManifest(filename);
         isReceiving = false;
         break;
     case meshtastic_XModem_Control_CAN:
@@ -188,6 +263,7 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
         file.flush();
         file.close();
         FSCom.remove(filename);
+        updateFilesManifest(filename);
         isReceiving = false;
         break;
     case meshtastic_XModem_Control_ACK:
@@ -251,4 +327,273 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
         break;
     }
 }
+
+/**
+ * Start a windowed transfer if the packet asks for one (see XModemAdapter), replacing any transfer that was going on.
+ *
+ * @return false if this is a plain stop-and-wait request
+ */
+bool XModemAdapter::startWindowed(const meshtastic_XModem &xmodemPacket)
+{
+    const pb_byte_t *bytes = xmodemPacket.buffer.bytes;
+    const pb_byte_t *params = (const pb_byte_t *)memchr(bytes, 0, xmodemPacket.buffer.size);
+    if (!params || bytes + xmodemPacket.buffer.size - params < 8 || params[1] != XMODEM_WINDOW_MAGIC)
+        return false;
+
+    abandonTransfer(); // e.g. the client lost its connection half way and now resumes
+    strcpy(filename, (const char *)bytes);
+    window = std::max(1, std::min((int)params[2], XMODEM_MAX_WINDOW));
+    uint8_t flags = params[3];
+    uint32_t offset = getLE32(params + 4);
+    uint32_t size = 0;
+
+    if (xmodemPacket.control == meshtastic_XModem_Control_SOH) {
+        if (!(flags & XMODEM_FLAG_RESUME))
+            FSCom.remove(filename);
+        file = FSCom.open(filename, (flags & XMODEM_FLAG_RESUME) ? FILE_O_APPEND : FILE_O_WRITE);
+        if (!file) {
+            sendControl(meshtastic_XModem_Control_NAK);
+            return true;
+        }
+        offset = file.size(); // Resume right after what we already have
+        rxBlocks = new pb_byte_t[XMODEM_MAX_WINDOW * XMODEM_BLOCK_SIZE];
+        isReceiving = true;
+        LOG_INFO("XModem: Receive file %s from offset %u, window %u", filename, offset, window);
+    } else {
+        file = FSCom.open(filename, FILE_O_READ);
+        if (!file) {
+            sendControl(meshtastic_XModem_Control_NAK);
+            return true;
+        }
+        size = file.size();
+        offset = std::min(offset, size);
+        lastBlock = (size - offset + XMODEM_BLOCK_SIZE - 1) / XMODEM_BLOCK_SIZE;
+        nextBlock = 1;
+        eotSent = false;
+        isTransmitting = true;
+        LOG_INFO("XModem: Transmit file %s from offset %u, window %u", filename, offset, window);
+    }
+
+    isWindowed = true;
+    startOffset = offset;
+    ackedBlock = 0;
+    blockBits = 0;
+    nakedBlock = UINT32_MAX; // Block 1 may be the one that goes missing
+    statusBlock = sinceNak = 0;
+    retrans = MAXRETRANS;
+
+    xmodemStore = meshtastic_XModem_init_zero;
+    xmodemStore.control = meshtastic_XModem_Control_ACK;
+    xmodemStore.buffer.size = 9;
+    putLE32(xmodemStore.buffer.bytes, offset);
+    putLE32(xmodemStore.buffer.bytes + 4, size);
+    xmodemStore.buffer.bytes[8] = window;
+    packetReady.notifyObservers(0);
+    return true;
+}
+
+void XModemAdapter::handleWindowedPacket(const meshtastic_XModem &xmodemPacket)
+{
+    switch (xmodemPacket.control) {
+    case meshtastic_XModem_Control_SOH:
+    case meshtastic_XModem_Control_STX: {
+        if (!isReceiving)
+            break;
+
+        uint32_t block = toBlock(xmodemPacket.seq, ackedBlock + 1);
+        if (block <= ackedBlock || block > ackedBlock + window)
+            break; // A repeat of something we already have
+        if (!check(xmodemPacket.buffer.bytes, xmodemPacket.buffer.size, xmodemPacket.crc16)) {
+            sendStatus(meshtastic_XModem_Control_NAK);
+            break;
+        }
+
+        if (block != ackedBlock + 1) {
+            // Out of order, hold on to it until the gap is filled and ask for what is missing.  Ask again every half window
+            // while the gap stays, in case what we asked for got lost as well.
+            uint32_t bit = 1u << (block - ackedBlock - 1);
+            if (!(blockBits & bit)) {
+                memcpy(rxBlocks + (block % XMODEM_MAX_WINDOW) * XMODEM_BLOCK_SIZE, xmodemPacket.buffer.bytes,
+                       xmodemPacket.buffer.size);
+                rxSizes[block % XMODEM_MAX_WINDOW] = xmodemPacket.buffer.size;
+                blockBits |= bit;
+            }
+            if (nakedBlock != ackedBlock || ++sinceNak >= (window + 1u) / 2u)
+                sendStatus(meshtastic_XModem_Control_NAK);
+            break;
+        }
+
+        bool written = writeBlock(xmodemPacket.buffer.bytes, xmodemPacket.buffer.size);
+        ackedBlock++;
+        blockBits >>= 1;
+        // The blocks that arrived early may follow on now
+        while (written && (blockBits & 1)) {
+            uint32_t slot = (ackedBlock + 1) % XMODEM_MAX_WINDOW;
+            written = writeBlock(rxBlocks + slot * XMODEM_BLOCK_SIZE, rxSizes[slot]);
+            ackedBlock++;
+            blockBits >>= 1;
+        }
+        if (!written) {
+            LOG_ERROR("XModem: Write to %s failed", filename);
+            sendControl(meshtastic_XModem_Control_CAN);
+            file.close();
+            updateFilesManifest(filename);
+            endTransfer();
+            break;
+        }
+
+        // Acknowledge every half window, so the phone can keep sending while the status is on its way
+        if (ackedBlock - statusBlock >= (window + 1u) / 2u)
+            sendStatus(meshtastic_XModem_Control_ACK);
+        break;
+    }
+    case meshtastic_XModem_Control_EOT:
+        if (!isReceiving)
+            break;
+        if (toBlock(xmodemPacket.seq, ackedBlock) != ackedBlock || blockBits) {
+            sendStatus(meshtastic_XModem_Control_NAK);
+            break;
+        }
+        file.flush();
+        file.close();
+        updateFilesManifest(filename);
+        LOG_INFO("XModem: Finished receive file %s, %u blocks", filename, ackedBlock);
+        sendStatus(meshtastic_XModem_Control_ACK);
+        endTransfer();
+        break;
+    case meshtastic_XModem_Control_ACK:
+    case meshtastic_XModem_Control_NAK: {
+        if (!isTransmitting)
+            break;
+
+        uint32_t acked = toBlock(xmodemPacket.seq, ackedBlock);
+        if (acked < ackedBlock || acked >= nextBlock)
+            break; // Stale, or about blocks we never sent
+        if (acked > ackedBlock)
+            retrans = MAXRETRANS;
+        blockBits >>= acked - ackedBlock;
+        ackedBlock = acked;
+
+        if (eotSent && ackedBlock == lastBlock) {
+            file.close();
+            LOG_INFO("XModem: Finished send file %s", filename);
+            endTransfer();
+            break;
+        }
+
+        if (xmodemPacket.control == meshtastic_XModem_Control_NAK) {
+            if (--retrans <= 0) {
+                sendControl(meshtastic_XModem_Control_CAN);
+                file.close();
+                LOG_INFO("XModem: Retransmit timeout, cancel file %s", filename);
+                endTransfer();
+                break;
+            }
+            // Resend every block in flight the phone doesn't have
+            uint32_t received = xmodemPacket.buffer.size >= 4 ? getLE32(xmodemPacket.buffer.bytes) : 0;
+            uint32_t inFlight = nextBlock - 1 - ackedBlock;
+            blockBits |= ~received & ((1u << inFlight) - 1);
+            eotSent = false;
+        }
+        packetReady.notifyObservers(ackedBlock);
+        break;
+    }
+    case meshtastic_XModem_Control_CAN:
+        sendControl(meshtastic_XModem_Control_ACK);
+        file.flush();
+        file.close();
+        if (isReceiving) {
+            FSCom.remove(filename);
+            updateFilesManifest(filename);
+        }
+        endTransfer();
+        break;
+    default:
+        break;
+    }
+}
+
+/// Close whatever transfer is going on, keeping what an upload has written so far so it can be resumed
+void XModemAdapter::abandonTransfer()
+{
+    if (!isReceiving && !isTransmitting)
+        return;
+
+    LOG_INFO("XModem: Abandon transfer of %s", filename);
+    file.flush();
+    file.close();
+    if (isReceiving)
+        updateFilesManifest(filename);
+    endTransfer();
+}
+
+void XModemAdapter::endTransfer()
+{
+    delete[] rxBlocks;
+    rxBlocks = NULL;
+    isWindowed = false;
+    isReceiving = false;
+    isTransmitting = false;
+    isEOT = false;
+}
+
+/// Send a status for a windowed upload: the last block we have without gaps, and which blocks after it we hold
+void XModemAdapter::sendStatus(meshtastic_XModem_Control c)
+{
+    xmodemStore = meshtastic_XModem_init_zero;
+    xmodemStore.control = c;
+    xmodemStore.seq = (uint16_t)ackedBlock;
+    xmodemStore.buffer.size = 4;
+    putLE32(xmodemStore.buffer.bytes, blockBits);
+    statusBlock = ackedBlock;
+    if (c == meshtastic_XModem_Control_NAK) {
+        nakedBlock = ackedBlock;
+        sinceNak = 0;
+    }
+    packetReady.notifyObservers(ackedBlock);
+}
+
+bool XModemAdapter::writeBlock(const pb_byte_t *buf, pb_size_t size)
+{
+    return file.write(buf, size) == size;
+}
+
+/**
+ * Put the next packet of a windowed download in xmodemStore: a block the phone is missing, a new block if the window allows,
+ * or EOT once every block went out.
+ *
+ * @return false if we have to wait for the phone
+ */
+bool XModemAdapter::prepareNextBlock()
+{
+    uint32_t block;
+    if (blockBits) {
+        block = ackedBlock + 1 + __builtin_ctz(blockBits);
+        blockBits &= blockBits - 1;
+    } else if (nextBlock <= lastBlock && nextBlock <= ackedBlock + window) {
+        block = nextBlock++;
+    } else if (nextBlock > lastBlock && !eotSent) {
+        xmodemStore = meshtastic_XModem_init_zero;
+        xmodemStore.control = meshtastic_XModem_Control_EOT;
+        xmodemStore.seq = (uint16_t)lastBlock;
+        eotSent = true;
+        if (ackedBlock == lastBlock) {
+            // The phone already has everything, it won't acknowledge the EOT
+            file.close();
+            LOG_INFO("XModem: Finished send file %s", filename);
+            endTransfer();
+        }
+        return true;
+    } else {
+        return false;
+    }
+
+    file.seek(startOffset + (block - 1) * XMODEM_BLOCK_SIZE);
+    xmodemStore = meshtastic_XModem_init_zero;
+    xmodemStore.control = meshtastic_XModem_Control_SOH;
+    xmodemStore.seq = (uint16_t)block;
+    xmodemStore.buffer.size = file.read(xmodemStore.buffer.bytes, XMODEM_BLOCK_SIZE);
+    xmodemStore.crc16 = crc16_ccitt(xmodemStore.buffer.bytes, xmodemStore.buffer.size);
+    return true;
+}
 #endif
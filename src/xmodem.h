@@ -38,8 +38,42 @@
 
 #define MAXRETRANS 25
 
+/// Payload bytes in one block
+#define XMODEM_BLOCK_SIZE sizeof(meshtastic_XModem_buffer_t::bytes)
+
+/// Most blocks a windowed transfer keeps in flight, the receiver buffers this many out of order blocks
+#define XMODEM_MAX_WINDOW 16
+
+/// Marks a seq 0 packet as the start of a windowed transfer, see XModemAdapter
+#define XMODEM_WINDOW_MAGIC 0x57
+
+/// Flags of a windowed transfer request
+#define XMODEM_FLAG_RESUME 0x01 // Upload: keep what is already on flash and continue after it
+
 #ifdef FSCom
 
+/**
+ * File transfer between the phone and our filesystem.
+ *
+ * By default this is a stop-and-wait protocol: every block waits for an ACK before the next one goes out.  A client can ask
+ * for a windowed transfer instead, by putting the following after the NUL terminated filename in the seq 0 SOH (upload) or STX
+ * (download) packet:
+ *
+ *   uint8 XMODEM_WINDOW_MAGIC, uint8 window (blocks in flight), uint8 XMODEM_FLAG_*, uint32 offset (little endian)
+ *
+ * We answer with an ACK for seq 0 carrying uint32 offset, uint32 size, uint8 window: the file offset the transfer starts at
+ * (for a resumed upload, what we already have on flash), the size of the file (downloads only) and the window we agreed to.
+ * Block n then holds the bytes at offset + (n - 1) * XMODEM_BLOCK_SIZE, seq is the low 16 bits of n.
+ *
+ * The sender keeps up to window blocks in flight.  The receiver acknowledges with a status: seq is the last block it has
+ * without gaps, the buffer holds a little endian uint32 bitmap of the blocks after that which arrived (bit 0 is seq + 1).
+ * An ACK status just moves the window on, a NAK status asks the sender to repeat the blocks missing from the bitmap.  Once
+ * everything went out, the sender sends EOT with the number of the last block, which the receiver acknowledges (unless it
+ * already acknowledged the last block) or answers with a NAK status if it is still missing blocks.
+ *
+ * A new windowed request replaces whatever transfer was going on, so a client that lost its connection simply starts again
+ * with the offset it got to (or XMODEM_FLAG_RESUME for an upload).
+ */
 class XModemAdapter
 {
   public:
@@ -69,6 +103,29 @@ class XModemAdapter
 
     char filename[sizeof(meshtastic_XModem_buffer_t::bytes)] = {0};
 
+    // Windowed transfers
+    bool isWindowed = false;
+    uint8_t window = 1;
+    uint32_t startOffset = 0; // file offset of block 1
+    uint32_t ackedBlock = 0;  // every block up to this one is on flash (upload) or at the phone (download)
+    uint32_t nextBlock = 0;   // download: the next block that was never sent
+    uint32_t lastBlock = 0;   // download: the final block of the file
+    uint32_t blockBits = 0;   // bit i is about block ackedBlock + 1 + i: held in rxBlocks (upload) or to be resent (download)
+    uint32_t nakedBlock = 0;  // upload: ackedBlock when we last asked for a resend, UINT32_MAX if we haven't yet
+    uint32_t sinceNak = 0;    // upload: out of order blocks that arrived since then
+    uint32_t statusBlock = 0; // upload: ackedBlock when we last sent a status
+    bool eotSent = false;     // download: every block went out and so did EOT
+    uint8_t *rxBlocks = NULL; // upload: out of order blocks, XMODEM_MAX_WINDOW * XMODEM_BLOCK_SIZE
+    pb_size_t rxSizes[XMODEM_MAX_WINDOW] = {0};
+
+    bool startWindowed(const meshtastic_XModem &xmodemPacket);
+    void handleWindowedPacket(const meshtastic_XModem &xmodemPacket);
+    void abandonTransfer();
+    void endTransfer();
+    void sendStatus(meshtastic_XModem_Control c);
+    bool writeBlock(const pb_byte_t *buf, pb_size_t size);
+    bool prepareNextBlock();
+
   protected:
     meshtastic_XModem xmodemStore = meshtastic_XModem_init_zero;
     unsigned short crc16_ccitt(const pb_byte_t *buffer, int length);
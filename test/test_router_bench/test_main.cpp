@@ -0,0 +1,464 @@
+#include "FSCommon.h"
+#include "MeshPacketQueue.h"
+#include "MeshRadio.h"
+#include "MeshService.h"
+#include "NodeDB.h"
+#include "ReliableRouter.h"
+#include "SPILock.h"
+#include "airtime.h"
+#include "modules/NodeInfoModule.h"
+#include "modules/PositionModule.h"
+#include "modules/RoutingModule.h"
+#include "modules/TextMessageModule.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <pb_encode.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+#include <vector>
+
+/*
+ * Feeds a stream of received packets through Router::enqueueReceivedMessage() and the Router's own thread, the way the radio
+ * would, and reports packets/s, how long each stage took (p50/p99) and how many allocations each packet cost.
+ *
+ * The stream is synthetic and the same on every run, so results can be compared between commits.  To replay real traffic
+ * instead, point ROUTER_BENCH_CAPTURE at a pcapng file written by meshtasticd (Logging: CaptureFile).
+ *
+ *   ROUTER_BENCH_CAPTURE=capture.pcapng platformio test -e native -f test_router_bench -v
+ */
+
+#define NUM_NODES 40
+#define FIRST_NODE 0x10000
+#define NUM_PACKETS 20000
+#define WARMUP_PACKETS 2000
+#define DUPLICATE_PERCENT 25 // Most of a busy mesh is the same packets relayed by our neighbours
+#define MAX_NESTED_STAGES 16
+
+#define PCAPNG_SECTION_HEADER 0x0A0D0D0A
+#define PCAPNG_INTERFACE_DESCRIPTION 1
+#define PCAPNG_ENHANCED_PACKET 6
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAP_LINKTYPE_LORATAP 270
+
+typedef std::chrono::steady_clock Clock;
+
+static const char *stageNames[NUM_ROUTER_STAGES] = {"dedup", "decrypt", "decode", "modules", "encode", "enqueue"};
+
+// Count every allocation by standing in for glibc's malloc, operator new ends up here as well
+static std::atomic<uint64_t> allocations{0};
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t num, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+extern "C" void *malloc(size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t num, size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(num, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+/// Stands in for the LoRa chip: queues what the Router sends like RadioLibInterface does, transmitAll() pretends it went out
+class BenchRadio : public RadioInterface
+{
+    MeshPacketQueue txQueue{MAX_TX_QUEUE};
+
+  public:
+    uint32_t numSent = 0;
+
+    virtual ErrorCode send(meshtastic_MeshPacket *p) override
+    {
+        if (!txQueue.enqueue(p)) {
+            packetPool.release(p);
+            return ERRNO_UNKNOWN;
+        }
+        return ERRNO_OK;
+    }
+
+    virtual meshtastic_QueueStatus getQueueStatus() override
+    {
+        meshtastic_QueueStatus qs = meshtastic_QueueStatus_init_zero;
+        qs.free = txQueue.getFree();
+        qs.maxlen = txQueue.getMaxLen();
+        return qs;
+    }
+
+    virtual bool cancelSending(NodeNum from, PacketId id) override
+    {
+        meshtastic_MeshPacket *p = txQueue.remove(from, id);
+        if (p)
+            packetPool.release(p);
+        return p != NULL;
+    }
+
+    void transmitAll()
+    {
+        meshtastic_MeshPacket *p;
+        while ((p = txQueue.dequeue()) != NULL) {
+            numSent++;
+            packetPool.release(p);
+        }
+    }
+};
+
+/// Adds up how long each stage took for the packet at hand, leaving out the time spent in the stages nested inside it
+class BenchProfiler : public RouterProfiler
+{
+    struct Frame {
+        RouterStage stage;
+        Clock::time_point start;
+        uint64_t nestedNsec;
+    };
+    Frame frames[MAX_NESTED_STAGES];
+    size_t depth = 0;
+
+  public:
+    uint64_t stageNsec[NUM_ROUTER_STAGES];
+    bool stageRan[NUM_ROUTER_STAGES];
+
+    void startPacket()
+    {
+        depth = 0;
+        memset(stageNsec, 0, sizeof(stageNsec));
+        memset(stageRan, 0, sizeof(stageRan));
+    }
+
+    virtual void beginStage(RouterStage stage) override
+    {
+        TEST_ASSERT_LESS_THAN(MAX_NESTED_STAGES, depth);
+        frames[depth++] = {stage, Clock::now(), 0};
+    }
+
+    virtual void endStage(RouterStage stage) override
+    {
+        Clock::time_point now = Clock::now();
+        TEST_ASSERT_GREATER_THAN(0, depth);
+        Frame &f = frames[--depth];
+        TEST_ASSERT_EQUAL(f.stage, stage);
+        uint64_t nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(now - f.start).count();
+        stageNsec[stage] += nsec - f.nestedNsec;
+        stageRan[stage] = true;
+        if (depth)
+            frames[depth - 1].nestedNsec += nsec;
+    }
+};
+
+static BenchRadio *radio;
+static BenchProfiler profiler;
+static std::vector<meshtastic_MeshPacket> stream; // Still encrypted, as the radio would hand them to the Router
+static uint32_t seed = 1;
+
+static uint32_t nextRandom()
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/// A packet as some node on a default channel mesh sends it, encrypted and all
+static meshtastic_MeshPacket makePacket(PacketId id)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.from = FIRST_NODE + nextRandom() % NUM_NODES;
+    p.to = NODENUM_BROADCAST;
+    p.id = id;
+    p.hop_limit = p.hop_start = 3;
+    p.rx_snr = 6.25;
+    p.rx_rssi = -95;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+
+    meshtastic_Data &d = p.decoded;
+    uint32_t kind = nextRandom() % 10;
+    if (kind < 5) {
+        meshtastic_Position pos = meshtastic_Position_init_zero;
+        pos.has_latitude_i = pos.has_longitude_i = pos.has_altitude = true;
+        pos.latitude_i = 473000000 + nextRandom() % 100000;
+        pos.longitude_i = 85000000 + nextRandom() % 100000;
+        pos.altitude = 400 + nextRandom() % 100;
+        pos.time = 1700000000 + id;
+        d.portnum = meshtastic_PortNum_POSITION_APP;
+        d.payload.size = pb_encode_to_bytes(d.payload.bytes, sizeof(d.payload.bytes), &meshtastic_Position_msg, &pos);
+    } else if (kind < 9) {
+        d.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+        d.payload.size = snprintf((char *)d.payload.bytes, sizeof(d.payload.bytes), "Message %u from the bench, %s", id,
+                                  "with enough text to look like a real one");
+    } else {
+        meshtastic_User user = meshtastic_User_init_zero;
+        snprintf(user.id, sizeof(user.id), "!%08x", p.from);
+        snprintf(user.long_name, sizeof(user.long_name), "Bench node %u", p.from - FIRST_NODE);
+        snprintf(user.short_name, sizeof(user.short_name), "B%u", (p.from - FIRST_NODE) % 100);
+        d.portnum = meshtastic_PortNum_NODEINFO_APP;
+        d.payload.size = pb_encode_to_bytes(d.payload.bytes, sizeof(d.payload.bytes), &meshtastic_User_msg, &user);
+    }
+
+    TEST_ASSERT_EQUAL(meshtastic_Routing_Error_NONE, perhapsEncode(&p));
+    return p;
+}
+
+static void makeStream(size_t numPackets)
+{
+    stream.clear();
+    stream.reserve(numPackets);
+    while (stream.size() < numPackets) {
+        // A neighbour relaying one of the last few packets, one hop on
+        if (stream.size() > 8 && nextRandom() % 100 < DUPLICATE_PERCENT) {
+            meshtastic_MeshPacket dup = stream[stream.size() - 1 - nextRandom() % 8];
+            if (dup.hop_limit) {
+                dup.hop_limit--;
+                dup.relay_node = nextRandom() & 0xff;
+                stream.push_back(dup);
+                continue;
+            }
+        }
+        stream.push_back(makePacket(stream.size() + 1));
+    }
+}
+
+static uint16_t getBE16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+/// Load the frames in a pcapng capture written by meshtasticd (see PacketCapture), false if there is none to load
+static bool loadCapture(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t len;
+    while ((len = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        data.insert(data.end(), chunk, chunk + len);
+    fclose(f);
+
+    stream.clear();
+    std::vector<uint16_t> linkTypes;
+    for (size_t pos = 0; pos + 12 <= data.size();) {
+        uint32_t type, blockLen;
+        memcpy(&type, &data[pos], 4);
+        memcpy(&blockLen, &data[pos + 4], 4);
+        if (blockLen < 12 || pos + blockLen > data.size())
+            break;
+        const uint8_t *body = &data[pos + 8];
+
+        if (type == PCAPNG_SECTION_HEADER) {
+            uint32_t magic;
+            memcpy(&magic, body, 4);
+            TEST_ASSERT_EQUAL_HEX32_MESSAGE(PCAPNG_BYTE_ORDER_MAGIC, magic, "Capture is from a machine of other endianness");
+            linkTypes.clear(); // Interface numbers start over in each section
+        } else if (type == PCAPNG_INTERFACE_DESCRIPTION) {
+            uint16_t linkType;
+            memcpy(&linkType, body, 2);
+            linkTypes.push_back(linkType);
+        } else if (type == PCAPNG_ENHANCED_PACKET && blockLen >= 32) {
+            uint32_t interface, capturedLen;
+            memcpy(&interface, body, 4);
+            memcpy(&capturedLen, body + 12, 4);
+            const uint8_t *frame = body + 20;
+            size_t headerLen = capturedLen >= 4 ? getBE16(frame + 2) : 0;
+            if (interface < linkTypes.size() && linkTypes[interface] == PCAP_LINKTYPE_LORATAP && headerLen >= 15 &&
+                capturedLen >= headerLen + sizeof(PacketHeader) && capturedLen - headerLen <= MAX_LORA_PAYLOAD_LEN &&
+                capturedLen <= blockLen - 32) {
+                PacketHeader h;
+                memcpy(&h, frame + headerLen, sizeof(h));
+                size_t payloadLen = capturedLen - headerLen - sizeof(h);
+
+                // Same as RadioLibInterface::handleReceiveInterrupt()
+                meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+                p.from = h.from;
+                p.to = h.to;
+                p.id = h.id;
+                p.channel = h.channel;
+                p.hop_limit = h.flags & PACKET_FLAGS_HOP_LIMIT_MASK;
+                p.hop_start = (h.flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
+                p.want_ack = !!(h.flags & PACKET_FLAGS_WANT_ACK_MASK);
+                p.via_mqtt = !!(h.flags & PACKET_FLAGS_VIA_MQTT_MASK);
+                p.next_hop = h.next_hop;
+                p.relay_node = h.relay_node;
+                p.rx_rssi = frame[10] ? frame[10] - 139 : 0;
+                p.rx_snr = (int8_t)frame[13] / 4.0f;
+                p.which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+                memcpy(p.encrypted.bytes, frame + headerLen + sizeof(h), payloadLen);
+                p.encrypted.size = payloadLen;
+                stream.push_back(p);
+            }
+        }
+        pos += blockLen;
+    }
+    return true;
+}
+
+/// Throw away what the Router queued for the phone, nobody is connected
+static void drainToPhone()
+{
+    meshtastic_MeshPacket *p;
+    while ((p = service->getForPhone()) != NULL)
+        service->releaseToPool(p);
+}
+
+static uint32_t percentile(std::vector<uint32_t> &samples, unsigned percent)
+{
+    if (samples.empty())
+        return 0;
+    size_t i = std::min(samples.size() - 1, samples.size() * percent / 100);
+    std::nth_element(samples.begin(), samples.begin() + i, samples.end());
+    return samples[i];
+}
+
+static void reportStage(const char *name, std::vector<uint32_t> &samples)
+{
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%-8s %6u packets, p50 %8.2f us, p99 %8.2f us", name, (unsigned)samples.size(),
+             percentile(samples, 50) / 1000.0, percentile(samples, 99) / 1000.0);
+    TEST_MESSAGE(msg);
+}
+
+/// Run numPackets packets of the stream through the Router, starting with stream[first]
+static void runStream(size_t first, size_t numPackets, bool measure)
+{
+    std::vector<uint32_t> stageSamples[NUM_ROUTER_STAGES];
+    std::vector<uint32_t> totalSamples;
+    if (measure) {
+        for (auto &samples : stageSamples)
+            samples.reserve(numPackets);
+        totalSamples.reserve(numPackets);
+    }
+
+    uint64_t totalNsec = 0;
+    uint64_t totalAllocations = 0;
+    uint32_t sentBefore = radio->numSent;
+    uint32_t dupesBefore = router->rxDupe;
+    routerProfiler = measure ? &profiler : NULL;
+
+    for (size_t i = 0; i < numPackets; i++) {
+        const meshtastic_MeshPacket &next = stream[first + i];
+        profiler.startPacket();
+        uint64_t allocationsBefore = allocations.load(std::memory_order_relaxed);
+        Clock::time_point start = Clock::now();
+
+        // What RadioLibInterface does for every frame it receives
+        meshtastic_MeshPacket *p = packetPool.allocCopy(next);
+        router->enqueueReceivedMessage(p, radio);
+        router->runOnce();
+
+        uint64_t nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        radio->transmitAll();
+        drainToPhone();
+        totalAllocations += allocations.load(std::memory_order_relaxed) - allocationsBefore;
+        totalNsec += nsec;
+
+        if (measure) {
+            totalSamples.push_back(nsec);
+            for (int s = 0; s < NUM_ROUTER_STAGES; s++) {
+                if (profiler.stageRan[s])
+                    stageSamples[s].push_back(profiler.stageNsec[s]);
+            }
+        }
+    }
+    routerProfiler = NULL;
+    if (!measure)
+        return;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%u packets in %u ms: %u packets/s, %u relayed, %u duplicates", (unsigned)numPackets,
+             (unsigned)(totalNsec / 1000000), (unsigned)(numPackets * 1000000000ull / std::max<uint64_t>(1, totalNsec)),
+             radio->numSent - sentBefore, router->rxDupe - dupesBefore);
+    TEST_MESSAGE(msg);
+#ifdef __GLIBC__
+    snprintf(msg, sizeof(msg), "%.2f allocations per packet", (double)totalAllocations / numPackets);
+#else
+    snprintf(msg, sizeof(msg), "allocations per packet: not counted without glibc");
+#endif
+    TEST_MESSAGE(msg);
+    reportStage("total", totalSamples);
+    for (int s = 0; s < NUM_ROUTER_STAGES; s++)
+        reportStage(stageNames[s], stageSamples[s]);
+
+    TEST_ASSERT_EQUAL(numPackets, totalSamples.size());
+}
+
+void setUp(void)
+{
+    // set stuff up here
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_SyntheticTraffic(void)
+{
+    makeStream(WARMUP_PACKETS + NUM_PACKETS);
+    runStream(0, WARMUP_PACKETS, false); // Get the node DB and packet history to where a running node has them
+    runStream(WARMUP_PACKETS, NUM_PACKETS, true);
+
+    // Every packet we heard first goes out again, and the Router catches the copies our neighbours relayed
+    TEST_ASSERT_GREATER_THAN(0, radio->numSent);
+    TEST_ASSERT_GREATER_THAN(0, router->rxDupe);
+    TEST_ASSERT_GREATER_OR_EQUAL(NUM_NODES, nodeDB->getNumMeshNodes());
+}
+
+void test_CapturedTraffic(void)
+{
+    const char *path = getenv("ROUTER_BENCH_CAPTURE");
+    if (!path)
+        TEST_IGNORE_MESSAGE("Set ROUTER_BENCH_CAPTURE to a pcapng capture to replay it");
+    TEST_ASSERT_TRUE_MESSAGE(loadCapture(path), "Can't read the capture");
+    TEST_ASSERT_GREATER_THAN_MESSAGE(0, stream.size(), "No LoRa frames in the capture");
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Replaying %u frames from %s", (unsigned)stream.size(), path);
+    TEST_MESSAGE(msg);
+    runStream(0, stream.size(), true);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    fsInit();
+    initSPI();
+    nodeDB = new NodeDB;
+    service = new MeshService();
+    config.lora.region = meshtastic_Config_LoRaConfig_RegionCode_US;
+    initRegion();
+    airTime = new AirTime();
+
+    router = new ReliableRouter();
+    routingModule = new RoutingModule();
+    nodeInfoModule = new NodeInfoModule();
+    positionModule = new PositionModule();
+    textMessageModule = new TextMessageModule();
+
+    radio = new BenchRadio();
+    radio->init();
+    router->addInterface(radio);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_SyntheticTraffic);
+    RUN_TEST(test_CapturedTraffic);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,417 @@
+#include "FSCommon.h"
+#include "MeshService.h"
+#include "NodeDB.h"
+#include "SPILock.h"
+#include "StreamAPI.h"
+#include "xmodem.h"
+
+#include <algorithm>
+#include <deque>
+#include <pb_decode.h>
+#include <pb_encode.h>
+#include <unity.h>
+#include <vector>
+
+#define TEST_FILE "/xmodemtest.bin"
+#define TEST_FILE_SIZE (64 * 1024 + 77) // Not a whole number of blocks
+#define MAX_PUMPS 100000
+
+/// What the client writes comes out at the device and the other way around
+class LoopbackStream : public Stream
+{
+  public:
+    std::deque<uint8_t> toDevice;
+    std::deque<uint8_t> toClient;
+
+    virtual int available() override { return toDevice.size(); }
+
+    virtual int read() override
+    {
+        if (toDevice.empty())
+            return -1;
+        int c = toDevice.front();
+        toDevice.pop_front();
+        return c;
+    }
+
+    virtual int peek() override { return toDevice.empty() ? -1 : toDevice.front(); }
+
+    virtual size_t write(uint8_t c) override
+    {
+        toClient.push_back(c);
+        return 1;
+    }
+
+    virtual size_t write(const uint8_t *buf, size_t size) override
+    {
+        toClient.insert(toClient.end(), buf, buf + size);
+        return size;
+    }
+};
+
+class LoopbackAPI : public StreamAPI
+{
+  public:
+    explicit LoopbackAPI(Stream *stream) : StreamAPI(stream) {}
+
+  protected:
+    virtual bool checkIsConnected() override { return true; }
+
+    virtual void onConnectionChanged(bool connected) override {} // Leave the power FSM alone
+};
+
+class TestXModem : public XModemAdapter
+{
+  public:
+    using XModemAdapter::crc16_ccitt;
+};
+
+static LoopbackStream *stream;
+static LoopbackAPI *api;
+static TestXModem crcOnly;
+static std::vector<uint8_t> testData;
+static uint32_t pumps;
+static uint32_t dropBlock, dropTimes; // Upload block to lose on the way, the first dropTimes times it is sent
+static uint32_t corruptBlock;         // Upload block to garble on the way, the first time it is sent
+static uint32_t naks, resent;
+
+static void sendToRadio(const meshtastic_ToRadio &toRadio)
+{
+    uint8_t buf[MAX_STREAM_BUF_SIZE];
+    size_t len = pb_encode_to_bytes(buf + 4, MAX_TO_FROM_RADIO_SIZE, &meshtastic_ToRadio_msg, &toRadio);
+    buf[0] = 0x94;
+    buf[1] = 0xc3;
+    buf[2] = (len >> 8) & 0xff;
+    buf[3] = len & 0xff;
+    stream->toDevice.insert(stream->toDevice.end(), buf, buf + len + 4);
+}
+
+static void sendXModem(meshtastic_XModem_Control control, uint16_t seq, const uint8_t *bytes = NULL, size_t size = 0,
+                       bool badCrc = false)
+{
+    meshtastic_ToRadio toRadio = meshtastic_ToRadio_init_zero;
+    toRadio.which_payload_variant = meshtastic_ToRadio_xmodemPacket_tag;
+    toRadio.xmodemPacket.control = control;
+    toRadio.xmodemPacket.seq = seq;
+    if (size)
+        memcpy(toRadio.xmodemPacket.buffer.bytes, bytes, size);
+    toRadio.xmodemPacket.buffer.size = size;
+    toRadio.xmodemPacket.crc16 = crcOnly.crc16_ccitt(bytes, size) ^ (badCrc ? 0xffff : 0);
+    sendToRadio(toRadio);
+}
+
+/// Take the next XModem packet the device sent, pumping the API until there is one
+static meshtastic_XModem receiveXModem()
+{
+    for (; pumps < MAX_PUMPS; pumps++) {
+        while (stream->toClient.size() >= 4) {
+            size_t len = (stream->toClient[2] << 8) | stream->toClient[3];
+            TEST_ASSERT_EQUAL_HEX8(0x94, stream->toClient[0]);
+            TEST_ASSERT_EQUAL_HEX8(0xc3, stream->toClient[1]);
+            TEST_ASSERT_GREATER_OR_EQUAL(len + 4, stream->toClient.size());
+
+            uint8_t buf[MAX_TO_FROM_RADIO_SIZE];
+            std::copy(stream->toClient.begin() + 4, stream->toClient.begin() + 4 + len, buf);
+            stream->toClient.erase(stream->toClient.begin(), stream->toClient.begin() + 4 + len);
+
+            meshtastic_FromRadio fromRadio = meshtastic_FromRadio_init_zero;
+            TEST_ASSERT_TRUE(pb_decode_from_bytes(buf, len, &meshtastic_FromRadio_msg, &fromRadio));
+            if (fromRadio.which_payload_variant == meshtastic_FromRadio_xmodemPacket_tag)
+                return fromRadio.xmodemPacket;
+        }
+        api->runOncePart();
+    }
+    TEST_FAIL_MESSAGE("Device stopped talking");
+    return meshtastic_XModem_init_zero;
+}
+
+static void sendOpen(meshtastic_XModem_Control control, uint8_t window, uint8_t flags, uint32_t offset)
+{
+    uint8_t buf[sizeof(TEST_FILE) + 7] = TEST_FILE;
+    uint8_t *params = buf + sizeof(TEST_FILE);
+    params[0] = XMODEM_WINDOW_MAGIC;
+    params[1] = window;
+    params[2] = flags;
+    for (int i = 0; i < 4; i++)
+        params[3 + i] = (offset >> (8 * i)) & 0xff;
+    sendXModem(control, 0, buf, sizeof(buf));
+}
+
+static uint32_t getLE32(const pb_byte_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Upload testData[0..end) with a windowed transfer, starting wherever the device tells us to
+ *
+ * @return the offset the device resumed at
+ */
+static uint32_t uploadWindowed(uint8_t window, uint8_t flags, size_t end, bool sendEOT = true)
+{
+    sendOpen(meshtastic_XModem_Control_SOH, window, flags, 0);
+    meshtastic_XModem reply = receiveXModem();
+    TEST_ASSERT_EQUAL(meshtastic_XModem_Control_ACK, reply.control);
+    TEST_ASSERT_EQUAL(9, reply.buffer.size);
+    uint32_t offset = getLE32(reply.buffer.bytes);
+    window = reply.buffer.bytes[8];
+
+    uint32_t lastBlock = (end - offset + XMODEM_BLOCK_SIZE - 1) / XMODEM_BLOCK_SIZE;
+    uint32_t acked = 0, next = 1;
+    bool eotSent = false;
+    auto sendBlock = [&](uint32_t block) {
+        if (block == dropBlock && dropTimes) {
+            dropTimes--;
+            return;
+        }
+        size_t pos = offset + (block - 1) * XMODEM_BLOCK_SIZE;
+        sendXModem(meshtastic_XModem_Control_SOH, block, testData.data() + pos, std::min(XMODEM_BLOCK_SIZE, end - pos),
+                   block == corruptBlock);
+        if (block == corruptBlock)
+            corruptBlock = 0;
+    };
+
+    while (true) {
+        while (next <= lastBlock && next <= acked + window)
+            sendBlock(next++);
+        if (next > lastBlock && !eotSent) {
+            if (!sendEOT)
+                return offset; // Pretend we lost the connection
+            sendXModem(meshtastic_XModem_Control_EOT, lastBlock);
+            eotSent = true;
+        }
+
+        meshtastic_XModem status = receiveXModem();
+        TEST_ASSERT_NOT_EQUAL(meshtastic_XModem_Control_CAN, status.control);
+        acked = status.seq;
+        if (status.control == meshtastic_XModem_Control_NAK) {
+            naks++;
+            uint32_t received = getLE32(status.buffer.bytes);
+            for (uint32_t block = acked + 1; block < next; block++) {
+                if (!(received & (1u << (block - acked - 1)))) {
+                    sendBlock(block);
+                    resent++;
+                }
+            }
+            eotSent = false;
+        } else if (eotSent && acked == lastBlock) {
+            return offset;
+        }
+    }
+}
+
+/// Upload testData with the old stop-and-wait protocol
+static void uploadStopAndWait()
+{
+    sendXModem(meshtastic_XModem_Control_SOH, 0, (const uint8_t *)TEST_FILE, strlen(TEST_FILE));
+    TEST_ASSERT_EQUAL(meshtastic_XModem_Control_ACK, receiveXModem().control);
+
+    for (size_t pos = 0, block = 1; pos < testData.size(); pos += XMODEM_BLOCK_SIZE, block++) {
+        sendXModem(meshtastic_XModem_Control_SOH, block, testData.data() + pos,
+                   std::min(XMODEM_BLOCK_SIZE, testData.size() - pos));
+        TEST_ASSERT_EQUAL(meshtastic_XModem_Control_ACK, receiveXModem().control);
+    }
+    sendXModem(meshtastic_XModem_Control_EOT, 0);
+    TEST_ASSERT_EQUAL(meshtastic_XModem_Control_ACK, receiveXModem().control);
+}
+
+/// Download the test file with a windowed transfer, from offset on
+static std::vector<uint8_t> downloadWindowed(uint8_t window, uint32_t offset)
+{
+    sendOpen(meshtastic_XModem_Control_STX, window, 0, offset);
+    meshtastic_XModem reply = receiveXModem();
+    TEST_ASSERT_EQUAL(meshtastic_XModem_Control_ACK, reply.control);
+    TEST_ASSERT_EQUAL(offset, getLE32(reply.buffer.bytes));
+    TEST_ASSERT_EQUAL(testData.size(), getLE32(reply.buffer.bytes + 4));
+    window = reply.buffer.bytes[8];
+
+    std::vector<uint8_t> data;
+    uint32_t have = 0, acked = 0;
+    while (true) {
+        meshtastic_XModem packet = receiveXModem();
+        if (packet.control == meshtastic_XModem_Control_EOT) {
+            TEST_ASSERT_EQUAL(have, packet.seq);
+            if (acked != have)
+                sendXModem(meshtastic_XModem_Control_ACK, have, (const uint8_t *)"\0\0\0\0", 4);
+            api->runOncePart();
+            return data;
+        }
+
+        TEST_ASSERT_EQUAL(meshtastic_XModem_Control_SOH, packet.control);
+        TEST_ASSERT_EQUAL(have + 1, packet.seq); // Nothing gets lost over the loopback
+        TEST_ASSERT_EQUAL(packet.crc16, crcOnly.crc16_ccitt(packet.buffer.bytes, packet.buffer.size));
+        data.insert(data.end(), packet.buffer.bytes, packet.buffer.bytes + packet.buffer.size);
+        have++;
+        if (have - acked >= (window + 1u) / 2u) {
+            sendXModem(meshtastic_XModem_Control_ACK, have, (const uint8_t *)"\0\0\0\0", 4);
+            acked = have;
+        }
+    }
+}
+
+static void checkFile()
+{
+    File f = FSCom.open(TEST_FILE, FILE_O_READ);
+    TEST_ASSERT_TRUE((bool)f);
+    std::vector<uint8_t> data(f.size());
+    TEST_ASSERT_EQUAL(testData.size(), f.read(data.data(), data.size()));
+    f.close();
+    TEST_ASSERT_EQUAL_MEMORY(testData.data(), data.data(), testData.size());
+}
+
+static void report(const char *what, uint32_t startMs)
+{
+    uint32_t ms = std::max(1u, (uint32_t)(millis() - startMs));
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%s: %u bytes in %u ms (%u KB/s), %u API polls", what, (unsigned)testData.size(), ms,
+             (unsigned)(testData.size() / ms), pumps);
+    TEST_MESSAGE(msg);
+}
+
+void setUp(void)
+{
+    pumps = 0;
+    dropBlock = dropTimes = corruptBlock = 0;
+    naks = resent = 0;
+}
+
+void tearDown(void)
+{
+    // clean stuff up here
+}
+
+void test_CRC16(void)
+{
+    // Check value of CRC-16/XMODEM
+    TEST_ASSERT_EQUAL_HEX16(0x31c3, crcOnly.crc16_ccitt((const pb_byte_t *)"123456789", 9));
+    TEST_ASSERT_EQUAL_HEX16(0, crcOnly.crc16_ccitt(NULL, 0));
+}
+
+void test_StopAndWaitUpload(void)
+{
+    uint32_t start = millis();
+    uploadStopAndWait();
+    report("Stop-and-wait upload", start);
+    checkFile();
+}
+
+void test_WindowedUpload(void)
+{
+    uint32_t start = millis();
+    TEST_ASSERT_EQUAL(0, uploadWindowed(XMODEM_MAX_WINDOW, 0, testData.size()));
+    report("Windowed upload", start);
+    checkFile();
+}
+
+void test_LossyWindowedUpload(void)
+{
+    // One block never arrives and another fails its CRC, the device has to ask for both again
+    dropBlock = 3;
+    dropTimes = 1;
+    corruptBlock = 5;
+    TEST_ASSERT_EQUAL(0, uploadWindowed(XMODEM_MAX_WINDOW, 0, testData.size()));
+    TEST_ASSERT_EQUAL(0, dropTimes);
+    TEST_ASSERT_EQUAL(0, corruptBlock);
+    TEST_ASSERT_GREATER_THAN(0, naks);
+    TEST_ASSERT_GREATER_OR_EQUAL(2, resent);
+    checkFile();
+}
+
+void test_FirstBlockLostUpload(void)
+{
+    // Nothing is acknowledged yet when the gap shows up
+    dropBlock = 1;
+    dropTimes = 1;
+    TEST_ASSERT_EQUAL(0, uploadWindowed(XMODEM_MAX_WINDOW, 0, testData.size()));
+    TEST_ASSERT_EQUAL(0, dropTimes);
+    TEST_ASSERT_GREATER_THAN(0, naks);
+    checkFile();
+}
+
+void test_ResendLostUpload(void)
+{
+    // The block we send again after the first NAK gets lost too, the device has to ask once more
+    dropBlock = 3;
+    dropTimes = 2;
+    TEST_ASSERT_EQUAL(0, uploadWindowed(XMODEM_MAX_WINDOW, 0, testData.size()));
+    TEST_ASSERT_EQUAL(0, dropTimes);
+    TEST_ASSERT_GREATER_THAN(1, naks);
+    checkFile();
+}
+
+void test_ResumedUpload(void)
+{
+    // Lose the connection half way, then continue where the device got to
+    size_t half = testData.size() / 2 / XMODEM_BLOCK_SIZE * XMODEM_BLOCK_SIZE;
+    TEST_ASSERT_EQUAL(0, uploadWindowed(XMODEM_MAX_WINDOW, 0, half, false));
+    for (int i = 0; i < 10; i++)
+        api->runOncePart();
+    stream->toClient.clear();
+
+    uint32_t offset = uploadWindowed(XMODEM_MAX_WINDOW, XMODEM_FLAG_RESUME, testData.size());
+    TEST_ASSERT_EQUAL(half, offset);
+    checkFile();
+}
+
+void test_WindowedDownload(void)
+{
+    uint32_t start = millis();
+    std::vector<uint8_t> data = downloadWindowed(XMODEM_MAX_WINDOW, 0);
+    report("Windowed download", start);
+    TEST_ASSERT_EQUAL(testData.size(), data.size());
+    TEST_ASSERT_EQUAL_MEMORY(testData.data(), data.data(), data.size());
+
+    // Resume from an offset
+    uint32_t offset = 1000;
+    data = downloadWindowed(XMODEM_MAX_WINDOW, offset);
+    TEST_ASSERT_EQUAL(testData.size() - offset, data.size());
+    TEST_ASSERT_EQUAL_MEMORY(testData.data() + offset, data.data(), data.size());
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    fsInit();
+    initSPI();
+    nodeDB = new NodeDB;
+    service = new MeshService();
+
+    uint32_t seed = 1;
+    testData.resize(TEST_FILE_SIZE);
+    for (auto &b : testData) {
+        seed = seed * 1103515245 + 12345;
+        b = seed >> 16;
+    }
+
+    // Get the API to where a client can transfer files
+    stream = new LoopbackStream();
+    api = new LoopbackAPI(stream);
+    meshtastic_ToRadio toRadio = meshtastic_ToRadio_init_zero;
+    toRadio.which_payload_variant = meshtastic_ToRadio_want_config_id_tag;
+    toRadio.want_config_id = SPECIAL_NONCE;
+    sendToRadio(toRadio);
+    for (int i = 0; i < 100; i++)
+        api->runOncePart();
+    stream->toClient.clear();
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_CRC16);
+    RUN_TEST(test_StopAndWaitUpload);
+    RUN_TEST(test_WindowedUpload);
+    RUN_TEST(test_LossyWindowedUpload);
+    RUN_TEST(test_FirstBlockLostUpload);
+    RUN_TEST(test_ResendLostUpload);
+    RUN_TEST(test_ResumedUpload);
+    RUN_TEST(test_WindowedDownload);
+
+    FSCom.remove(TEST_FILE);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
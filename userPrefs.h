@@ -16,6 +16,17 @@
 
 // #define USERPREFS_CONFIG_GPS_MODE meshtastic_Config_PositionConfig_GpsMode_ENABLED
 
+// Hold our position, telemetry, nodeinfo and routing packets up to this long so several can share one LoRa frame
+// #define USERPREFS_PACKET_AGGREGATION_WINDOW_MS 2000
+
+// Broadcast telemetry that stayed within its deadbands anyway after this many update intervals (1 sends every interval)
+// #define USERPREFS_TELEMETRY_HEARTBEAT_INTERVALS 4
+// Send only the telemetry metrics that changed in between full reports, needs receivers that understand it
+// #define USERPREFS_TELEMETRY_DELTA_ENCODING 1
+
+// Dual core ESP32 only: run the LoRa driver in its own task on this core, the Arduino loop runs on core 1
+// #define USERPREFS_RADIO_TASK_CORE 0
+
 // #define USERPREFS_CHANNELS_TO_WRITE 3
 /*
 #define USERPREFS_CHANNEL_0_PSK \